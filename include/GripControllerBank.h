@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file GripControllerBank.h
+ * \brief Class evaluating the controllers of many skeletons in parallel
+ */
+
+#ifndef GRIP_CONTROLLER_BANK_H
+#define GRIP_CONTROLLER_BANK_H
+
+// Qt includes
+#include <QThreadPool>
+
+// C++ Standard includes
+#include <vector>
+
+// Local includes
+#include "HuboController.h"
+#include "GripProfiler.h"
+
+class GripControllerTask;
+
+/**
+ * \class GripControllerBank GripControllerBank.h
+ * \brief Owns one HuboController per skeleton and computes all their torques
+ * on a thread pool between world steps. Each controller only reads its own
+ * skeleton and writes its own torque vector, so the controllers don't share
+ * anything while they run. The torques are then applied to the skeletons in
+ * one pass on the calling thread. Call update() from the thread stepping the
+ * world, e.g. in a plugin's GRIPEventSimulationBeforeTimestep().
+ */
+class GripControllerBank
+{
+public:
+
+    /**
+     * \brief Constructs an empty GripControllerBank
+     * \param numThreads Number of threads computing torques. Defaults to the number of cores
+     */
+    GripControllerBank(int numThreads=-1);
+
+    /**
+     * \brief Destructor for GripControllerBank. Deletes the controllers
+     */
+    ~GripControllerBank();
+
+    /**
+     * \brief Adds a controller and takes ownership of it. Its skeleton shouldn't
+     * have a controller in the bank yet.
+     * \param controller Controller of one skeleton
+     * \return size_t Index of the controller
+     */
+    size_t addController(HuboController* controller);
+
+    /**
+     * \brief Gets the number of controllers
+     * \return size_t
+     */
+    size_t getNumControllers() const;
+
+    /**
+     * \brief Gets a controller, e.g. to change its reference positions
+     * \param index Index of the controller
+     * \return HuboController* Controller, or NULL for an invalid index
+     */
+    HuboController* getController(size_t index);
+
+    /**
+     * \brief Computes the torques of every controller in parallel from the
+     * current state of their skeletons
+     * \param t Time, usually the world time
+     * \return void
+     */
+    void computeTorques(double t);
+
+    /**
+     * \brief Sets the torques computed last as the internal forces of the skeletons
+     * \return void
+     */
+    void applyTorques();
+
+    /**
+     * \brief Computes and then applies the torques of every controller
+     * \param t Time, usually the world time
+     * \return void
+     */
+    void update(double t);
+
+    /**
+     * \brief Gets the torques a controller computed last
+     * \param index Index of the controller
+     * \return const Eigen::VectorXd& Joint torques
+     */
+    const Eigen::VectorXd& getTorques(size_t index) const;
+
+    /**
+     * \brief Gets how long a controller took to compute its torques last time
+     * \param index Index of the controller
+     * \return double Duration in seconds, or 0 for an invalid index
+     */
+    double getLastDuration(size_t index) const;
+
+    /**
+     * \brief Gets how long the last computeTorques() took as a whole
+     * \return double Duration in seconds
+     */
+    double getLastComputeDuration() const;
+
+    /**
+     * \brief Sets the profiler that every controller and the whole bank are timed
+     * in. Controllers added later get their phases when they're added.
+     * \param profiler Profiler to record in, or NULL to not time anything
+     * \return void
+     */
+    void setProfiler(GripProfiler* profiler);
+
+    /**
+     * \brief Sets the number of threads computing torques
+     * \param numThreads Number of threads
+     * \return void
+     */
+    void setMaxThreadCount(int numThreads);
+
+protected:
+
+    friend class GripControllerTask;
+
+    /**
+     * \brief Computes the torques of one controller and times it. Called from the pool
+     * \param index Index of the controller
+     * \return void
+     */
+    void _compute(size_t index);
+
+    /**
+     * \brief Adds the profiler phase of a controller
+     * \param index Index of the controller
+     * \return void
+     */
+    void _addPhase(size_t index);
+
+    std::vector<HuboController*> _controllers;     ///< One controller per skeleton
+    std::vector<GripControllerTask*> _tasks;       ///< Reused pool task of each controller
+    std::vector<Eigen::VectorXd> _torques;         ///< Torques computed last by each controller
+    std::vector<double> _durations;                ///< Duration of the last computation of each controller
+    std::vector<size_t> _phases;                   ///< Profiler phase of each controller
+
+    /// Threads computing the torques, kept alive between time steps
+    QThreadPool* _pool;
+
+    GripProfiler* _profiler;    ///< Profiler to record in, or NULL
+    size_t _phaseCompute;       ///< Profiler phase of a whole computeTorques()
+    size_t _phaseApply;         ///< Profiler phase of applyTorques()
+    double _time;               ///< Time the torques are being computed for
+    double _computeDuration;    ///< Duration of the last computeTorques()
+};
+
+#endif // GRIP_CONTROLLER_BANK_H
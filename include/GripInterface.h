@@ -57,6 +57,7 @@
 #include <string>
  #include <thread>
 #include "GripMainWindow.h"
+#include "GripRolloutEngine.h"
 
 /**
  * \class GripInterface GripInterface.h
@@ -125,6 +126,29 @@ public:
      */
     void simulateSingleStep();
 
+    /**
+     * \brief Runs numSteps time steps on the simulation thread and blocks until
+     *        they're done, for external control loops. The torques are set as the
+     *        internal forces of every DOF before each step. Nothing sleeps or polls;
+     *        the simulation thread wakes the caller up when the last step is done.
+     *        Fails while the simulation is running.
+     * \param numSteps Number of time steps to simulate
+     * \param torques Pointer to one torque per DOF of the world, skeleton after
+     *        skeleton, or NULL to leave the forces alone
+     * \param numTorques Number of torques. Must match the DOFs of the world unless zero
+     * \param state Array of getStateSize() doubles to put the resulting state in, or NULL
+     * \return True if the steps ran
+     */
+    bool step(int numSteps, const double *torques, int numTorques, double *state);
+
+    /**
+     * \brief Same as step(int, const double*, int), returning the resulting state
+     * \param numSteps Number of time steps to simulate
+     * \param torques One torque per DOF of the world, or empty to leave the forces alone
+     * \return The state of the world after the steps, or an empty vector if they didn't run
+     */
+    std::vector<double> step(int numSteps, const std::vector<double> &torques);
+
     /**
      * \brief Returns the state of the world as std::vector, which can be
      *        coerced to numpy array in cython bindings.
@@ -139,10 +163,131 @@ public:
      */
     void setState(const std::vector<double> &state);
 
+    /**
+     * \brief Copies the state of the world into a buffer owned by the caller, e.g.
+     *        the data of a numpy array, without an intermediate std::vector.
+     * \param state Array of getStateSize() doubles to put the state in
+     * \return void
+     */
+    void updateStateBuffer(double *state);
+
+    /**
+     * \brief Sets the state of the world from a buffer owned by the caller, e.g.
+     *        the data of a numpy array, the same way as setState.
+     * \param state Array of the new state
+     * \param size Number of doubles in state. Must match getStateSize()
+     * \return void
+     */
+    void setStateFromBuffer(const double *state, int size);
+
+    /**
+     * \brief Returns the size of the world state
+     * \return Number of doubles in the state
+     */
+    int getStateSize();
+
+    /**
+     * \brief Returns the number of timeslices still in the timeline, i.e. the
+     *        number of rows exportTimeline can copy
+     * \return Number of timeslices
+     */
+    int getTimelineLength();
+
+    /**
+     * \brief Returns the size of the states in the timeline
+     * \return Number of doubles in each row copied by exportTimeline
+     */
+    int getTimelineStateSize();
+
+    /**
+     * \brief Copies the timeline into buffers owned by the caller in one pass, e.g.
+     *        the data of numpy arrays. Refuses while simulating, since the
+     *        simulation keeps adding to the timeline.
+     * \param times Array of numRows doubles to put one time per timeslice in
+     * \param states Array of numRows rows of getTimelineStateSize() doubles
+     * \param numRows Maximum number of timeslices to copy
+     * \return Number of timeslices copied, or -1 while simulating
+     */
+    int exportTimeline(double *times, double *states, int numRows);
+
+    /**
+     * \brief Runs one headless rollout of a scene per set of gains, in parallel,
+     *        and blocks until they're done. Doesn't need or touch the window.
+     *        Each rollout starts from the initial state of the scene and the
+     *        HuboController holds the first skeleton of the scene where it starts.
+     * \param sceneFileName Name of scene file (.urdf, .sdf). Only parsed again if it changed
+     * \param numSteps Number of time steps per rollout
+     * \param kp Proportional gains of each rollout, one per DOF. Empty for a passive rollout
+     * \param kd Derivative gains of each rollout, one per DOF. Empty for a passive rollout
+     * \param numThreads Number of threads. Zero or less uses every core
+     * \return Number of rollouts that ran, or -1 if the scene couldn't be loaded
+     */
+    int runRollouts(std::string sceneFileName, int numSteps,
+                    const std::vector<std::vector<double> > &kp,
+                    const std::vector<std::vector<double> > &kd,
+                    int numThreads=0);
+
+    /**
+     * \brief Returns the summary of each rollout of the last runRollouts call
+     * \return One GripRolloutMetrics per rollout, in the order of the gains
+     */
+    std::vector<GripRolloutMetrics> getRolloutMetrics();
+
+    /**
+     * \brief Returns the recorded timeline of a rollout as rows of the time
+     *        followed by the world state, concatenated. Every getRolloutSampleSize()
+     *        values are one row.
+     * \param rollout Index of the rollout
+     * \return The rows of the timeline, or an empty vector for an invalid index
+     */
+    std::vector<double> getRolloutTimeline(int rollout);
+
+    /**
+     * \brief Returns the number of values in each row of a rollout timeline
+     * \return One plus the size of the world state
+     */
+    int getRolloutSampleSize();
+
 protected:
+    /**
+     * \brief Runs a scene for a fixed number of time steps without creating the
+     * GripMainWindow or ViewerWidget. The simulation steps in batch mode on its own
+     * thread and the process returns once it's done.
+     * \param argc Number of command line arguments (for the QCoreApplication)
+     * \param argv Command line arguments (for the QCoreApplication)
+     * \param sceneFileName Name of scene file to simulate
+     * \param numSteps Number of time steps to simulate
+     * \param outputFileName Timeline file to record the simulation to. Empty to not record
+     * \param retention Seconds of the timeline to keep in memory. Zero or less keeps everything
+     * \param spill Whether to spill older parts of the timeline to disk instead of dropping them
+     * \param debug Whether or not to print debug statements
+     * \return 0 on success, 1 if the scene couldn't be simulated
+     */
+    int _createHeadless(int argc, char **argv, std::string sceneFileName, int numSteps,
+                        std::string outputFileName, double retention, bool spill, bool debug);
+
+    /**
+     * \brief Parses a scene file (.urdf, .sdf) with GripSceneLoader::parseScene and adds
+     * the same ground and time step the GripMainWindow uses, without creating any
+     * OpenSceneGraph nodes. The ground comes after the skeletons of the scene.
+     * \param sceneFileName Name of scene file to load
+     * \param debug Whether or not to print debug statements
+     * \return Pointer to the new world, or NULL if the scene couldn't be parsed
+     */
+    static dart::simulation::World* _loadWorld(std::string sceneFileName, bool debug);
+
+    /**
+     * \brief Sets the world to a state through GripMainWindow::setWorldFromExternalState,
+     * on the window's thread, and waits for it
+     * \param state New state of the world
+     * \return void
+     */
+    void _applyState(const Eigen::Map<const Eigen::VectorXd> &state);
+
 	QApplication * _app;
 	GripMainWindow *_window;
     std::thread *_gripthread; // used for linux thread solution only
+    GripRolloutEngine *_rolloutEngine; ///< Created by the first runRollouts call
 };
 
 #endif // GRIP_INTERFACE_H
@@ -63,6 +63,7 @@
 #include "InspectorTab.h"
 #include "VisualizationTab.h"
 #include "PlaybackWidget.h"
+#include "ProfilerWidget.h"
 #include "ui_VisualizationTab.h"
 #include "ui_InspectorTab.h"
 #include "ui_TreeView.h"
@@ -70,7 +71,12 @@
 #include "DartNode.h"
 #include "GripSimulation.h"
 #include "GripTab.h"
-#include "GripTimeslice.h"
+#include "GripTimeline.h"
+#include "GripSceneLoader.h"
+#include "GripVideoEncoder.h"
+#include "GripTimelineInterpolator.h"
+#include "GripStateApplier.h"
+#include "GripProfiler.h"
 
 // Qt includes
 #include <QDir>
@@ -101,17 +107,15 @@ public:
     ~GripMainWindow();
 
     /**
-     * \brief Convenience function for creating a ground skeleton
+     * \brief Convenience function for creating a ground skeleton. Static so
+     * that the headless mode can create the same ground without a window.
      * \return Ground object
      */
-    dart::dynamics::Skeleton *createGround();
+    static dart::dynamics::Skeleton *createGround();
 
     /// OpenSceneGraph Qt composite viewer widget, which can hold more than one view
     ViewerWidget *viewWidget;
 
-    /// OpenSceneGraph Qt composite viewer widget for recording the playback in a separate window
-    ViewerWidget *recordViewWidget;
-
     /// QDockWidget that contains a QTreeWidget. It is used as an object explorer for the loaded skeletons or robots
     TreeView *treeviewer;
 
@@ -121,8 +125,24 @@ public:
     /// Tab for changing visualization settings of the render window
     VisualizationTab *visualizationTab;
 
+    /// Table of the simulation and render timings, hidden until opened from the Widgets menu
+    ProfilerWidget *profilerWidget;
+
     /// Array of GripTimeSlice objects stored for simulation/kinematic playback
-    std::vector<GripTimeslice> *timeline;
+    GripTimeline *timeline;
+
+    /// Times the phases of every simulation step and render frame. Written to
+    /// grip-profile.csv in the home directory on exit, and saved from the profiler widget
+    GripProfiler *profiler;
+
+    /// Snapshots of the world handed from the simulation thread to the renderer
+    osgDart::WorldSnapshotBuffer *snapshotBuffer;
+
+    /// Loads scene files on its own thread
+    GripSceneLoader *sceneLoader;
+
+    /// Writes recorded frames to disk while the playback is being recorded
+    GripVideoEncoder *videoEncoder;
     
     /// Widget for playing back the simulation or kinematic states in the timeline
     PlaybackWidget *playbackWidget;
@@ -143,9 +163,6 @@ public:
     /// Simulation thread doing the actually simluation loop
     GripSimulation *simulation;
 
-    /// stores a list of images to be saved as videos
-    QList<QImage>* recordImageList;
-
     /// grants the grip interface class access to protected members
     friend class GripInterface;
 
@@ -178,12 +195,17 @@ public slots:
     void slotPlaybackBeginning();
 
     /**
-     * \brief Slot that recursively calls it self to run the playback loop.
-     * The recursive call allows the event loop to process other events, (eg. Stop Playback)
+     * \brief Slot that advances the playback by one step. Called by the playback
+     * timer once per displayed frame while playing back
      * \param playForward Whether or not to play back in forward or reverse
      */
     void slotPlaybackTimeStep(bool playForward);
 
+    /**
+     * \brief Slot for the playback timer, steps the playback in its current direction
+     */
+    void slotPlaybackTick();
+
 protected slots:
 
     /**
@@ -259,6 +281,28 @@ protected slots:
      */
     void resetCamera();
 
+    /**
+     * \brief Asks how many seconds of the timeline to keep in memory and whether
+     * to spill older parts to disk. Clears the timeline.
+     * \return void
+     */
+    void setTimelineRetention();
+
+    /**
+     * \brief Asks for the maximum number of frames rendered per second and
+     * shows how many frames were rendered and skipped so far in the dialog
+     * and the status bar
+     * \return void
+     */
+    void setMaxFrameRate();
+
+    /**
+     * \brief Asks for the threading model of the viewer, e.g. to draw on another
+     * thread while the next frame is updated
+     * \return void
+     */
+    void setRenderingThreads();
+
     /**
      * \brief Change movie export mode to 1024x768
      */
@@ -280,10 +324,33 @@ protected slots:
     void camera();
 
     /**
-     * \brief Takes a series of screenshots of the rendering window while it is playing back a simulation
+     * \brief Records the playback from the slider position to the end as a video
+     * of 30 frames per second of wall clock time at the current playback speed
      */
     void film();
 
+    /**
+     * \brief Renders the timeline offline at a fixed frame rate of simulated time
+     */
+    void exportVideo();
+
+    /**
+     * \brief Saves the playback timeline to a timeline file chosen with a dialog
+     */
+    void saveTimeline();
+
+    /**
+     * \brief Loads a timeline file chosen with a dialog. The file is memory mapped,
+     * so long recordings open instantly and aren't copied into memory.
+     */
+    void loadTimeline();
+
+    /**
+     * \brief Starts or stops streaming the simulated time steps to a timeline file
+     * \param record Whether or not to record
+     */
+    void recordTimeline(bool record);
+
     /**
      * \brief Close current scene
      */
@@ -295,6 +362,36 @@ protected slots:
      */
     void simulationStopped();
 
+    /**
+     * \brief Shows the progress of the scene being loaded in the status bar
+     * \param numDone Number of meshes and skeletons done
+     * \param numTotal Number of meshes and skeletons in the scene
+     * \param stage Description of what's being done
+     * \return void
+     */
+    void sceneLoadProgress(int numDone, int numTotal, QString stage);
+
+    /**
+     * \brief Adds the scene that was loaded in the background to the world and the view
+     * \param success Whether or not the scene was parsed
+     * \return void
+     */
+    void sceneLoaded(bool success);
+
+    /**
+     * \brief Sets the world to _externalState through the state applier, for
+     * callers on other threads such as GripInterface. Ignored while simulating.
+     * \return void
+     */
+    void setWorldFromExternalState();
+
+    /**
+     * \brief Invalidates the state applier and redraws the world after something
+     * else moved the skeletons, e.g. GripInterface::step
+     * \return void
+     */
+    void worldChangedExternally();
+
 protected:
     /// Any plugin that is loaded successfully into the Grip will get stored in this QList
     /// The plugins are always going to be derived from the GripTab interface defined in qtWidgets/include/GripTab.h
@@ -318,9 +415,6 @@ protected:
     /// Stores the height width resolution for the recording
     QSize recordSize;
 
-    /// Pointer to the widget that run the simulation playback for recording
-    QWidget* recordWidget;
-
     /**
      * \brief Create an XML file for the workspace
      * contains the list of plugins, status of DockWidgets and the loaded scene
@@ -377,6 +471,13 @@ protected:
      */
     bool stopSimulationWithDialog();
 
+    /**
+     * \brief Asks for the file to record a video to. A name without an
+     * extension gets the one of the selected filter.
+     * \return QString File name, or an empty string if the dialog was cancelled
+     */
+    QString getVideoFileName();
+
     /**
      * \brief Swaps the start and stop buttons for covenience. It just shows and hides them.
      * \return void
@@ -385,12 +486,23 @@ protected:
 
     /**
      * \brief Load the scene and renders it. This function resets everything
-     * on each load.
+     * on each load. The scene is loaded in the background and shows up once
+     * sceneLoaded() is called.
      * \param fileName Name of scene file to load
      * \return void
      */
     void doLoad(std::string sceneFileName);
 
+    /**
+     * \brief Load the scene and renders it. This function resets everything
+     * on each load.
+     * \param fileName Name of scene file to load
+     * \param async Whether to load in the background, or to only return once
+     * the scene is in the world
+     * \return void
+     */
+    void doLoad(std::string sceneFileName, bool async);
+
     /**
      * \brief Saves the loaded scene to file for quick load functionality
      * \return void
@@ -415,10 +527,18 @@ protected:
      * \brief Set state of world from an Eigen::VectorXd.
      * Because DART has a major bug with the integration of free and ball
      * joints, some extra work arounds have to been performed.
+     * Skeletons whose state didn't change since the last call are skipped
+     * (see GripStateApplier).
      * \param newState New state for the world
      */
     void setWorldState_Issue122(const Eigen::VectorXd &newState);
 
+    /**
+     * \brief Set state of world from a timeslice's state without copying it
+     * \param newState New state for the world
+     */
+    void setWorldState_Issue122(const Eigen::Map<const Eigen::VectorXd> &newState);
+
     /**
      * \brief Records playback images
      * \param QList<QImage>* to list of QImages where the images are stored
@@ -428,22 +548,57 @@ protected:
     void recordPlayback(QList<QImage>* imageList, ViewerWidget* vWidget);
 
     /**
-     * \brief saves video
-     * \param QList<QImage>*
+     * \brief Waits for the video encoder to write the last recorded frames
+     * and reports the result
      * \return void
      */
     void saveVideo();
 
+    /**
+     * \brief Renders the timeline offscreen one frame per fixed step of simulated
+     * time, from startTime to the end of the timeline, and writes it as a video
+     * \param fileName Name of the video file, or pattern of the frame files
+     * \param fps Frame rate of the video
+     * \param startTime Simulation time of the first frame
+     * \param timeStep Simulation time between frames
+     * \return void
+     */
+    void renderVideo(const QString &fileName, int fps, double startTime, double timeStep);
+
+    /**
+     * \brief Starts the playback timer and takes the first playback step
+     * \param playForward Whether or not to play back in forward or reverse
+     * \return void
+     */
+    void startPlaybackTimer(bool playForward);
+
+    /// Steps the playback once per displayed frame
+    QTimer *playbackTimer;
+
     /// used to maintain the layout of the widgets that are not QDockWidgets
     QGridLayout *gridLayout;
 
+    /// Computes the world states between timeslices for playback and video export
+    GripTimelineInterpolator _playbackInterpolator;
+
+    /// World state shown by the last playback step
+    Eigen::VectorXd _playbackState;
+
+    /// Sets playback states on the world's skeletons
+    GripStateApplier _stateApplier;
+
+    /// State handed over by setWorldFromExternalState's caller
+    Eigen::VectorXd _externalState;
+
     bool _debug;            ///< Whether or not to print debug statements
     bool _simulating;       ///< Whether or not simulation is happening
     bool _playingBack;      ///< Whether or not playback is happening
     size_t _curPlaybackTick;   ///< Current tick in playback
-    size_t _playbackSpeed;     ///< Additive value corresponding to playback speed
+    double _playbackTime;      ///< Simulation time being played back
+    double _playbackWallTime;  ///< Wall clock time of the last playback step
+    bool _playForward;         ///< Direction of the running playback
     bool _simulationDirty;  ///< Whether or not the timeline has been messed with
-    bool _recordVideo;      ///< Whether or not to store viewWidget images>
+    bool _loadingScene;     ///< Whether or not a scene is being loaded in the background
 };
 
 
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file GripPluginWorker.h
+ * \brief Thread delivering simulation state snapshots to an asynchronous plugin
+ */
+
+#ifndef GRIP_PLUGIN_WORKER_H
+#define GRIP_PLUGIN_WORKER_H
+
+// Qt includes
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+// Eigen includes
+#include <Eigen/Core>
+
+// C++ Standard includes
+#include <vector>
+
+class GripTab;
+
+/**
+ * \class GripPluginWorker GripPluginWorker.h
+ * \brief Runs a plugin's GRIPEventSimulationAfterTimestepAsync() on a thread of its
+ * own. The simulation thread posts copies of the world state into a bounded ring of
+ * preallocated snapshots and never waits. When the plugin falls behind, the oldest
+ * snapshot is overwritten, so the plugin always gets the newest states.
+ */
+class GripPluginWorker : public QThread
+{
+public:
+
+    /**
+     * \brief Constructs a GripPluginWorker and starts its thread
+     * \param plugin Plugin to deliver snapshots to
+     * \param maxQueuedStates Number of snapshots that can wait for the plugin
+     */
+    GripPluginWorker(GripTab* plugin, size_t maxQueuedStates=64);
+
+    /**
+     * \brief Destructor for GripPluginWorker. Delivers the queued snapshots and stops the thread
+     */
+    ~GripPluginWorker();
+
+    /**
+     * \brief Queues a copy of the state for the plugin. Never blocks on the plugin.
+     * Once the ring has grown to fit the state this doesn't allocate.
+     * \param time Simulation time of the state
+     * \param state World state
+     * \return bool False if the oldest queued snapshot was dropped to make room
+     */
+    bool post(double time, const Eigen::VectorXd& state);
+
+    /**
+     * \brief Delivers the queued snapshots and stops the thread
+     * \return void
+     */
+    void stop();
+
+    /**
+     * \brief Gets the plugin the snapshots are delivered to
+     * \return GripTab*
+     */
+    GripTab* getPlugin() const;
+
+    /**
+     * \brief Gets the number of snapshots dropped because the plugin fell behind
+     * \return size_t
+     */
+    size_t getNumDropped() const;
+
+    /**
+     * \brief Gets the number of snapshots delivered to the plugin
+     * \return size_t
+     */
+    size_t getNumDelivered() const;
+
+protected:
+
+    /**
+     * \brief Delivers snapshots to the plugin until stopped and the queue is empty
+     * \return void
+     */
+    void run();
+
+    /// Plugin the snapshots are delivered to
+    GripTab* _plugin;
+
+    std::vector<double> _times;          ///< Simulation time of each slot in the ring
+    std::vector<Eigen::VectorXd> _states; ///< State of each slot in the ring
+
+    /// Guards the ring and the counters
+    mutable QMutex _mutex;
+
+    /// Wakes the worker when a snapshot is posted or it's stopped
+    QWaitCondition _statePosted;
+
+    size_t _head;          ///< Slot of the oldest queued snapshot
+    size_t _numQueued;     ///< Number of queued snapshots
+    size_t _numDropped;    ///< Number of snapshots overwritten before delivery
+    size_t _numDelivered;  ///< Number of snapshots delivered
+    bool _stopping;        ///< Whether or not to stop once the queue is empty
+};
+
+#endif // GRIP_PLUGIN_WORKER_H
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file GripRolloutEngine.h
+ * \brief Class running many independent copies of a scene in parallel without a window
+ */
+
+#ifndef GRIP_ROLLOUT_ENGINE_H
+#define GRIP_ROLLOUT_ENGINE_H
+
+// DART includes
+#include <dart/simulation/World.h>
+
+// Qt includes
+#include <QThreadPool>
+
+// C++ Standard includes
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Eigen includes
+#include <Eigen/Core>
+
+/// Function parsing a scene file into a new world, e.g. GripInterface::_loadWorld
+typedef dart::simulation::World* (*GripWorldLoader)(std::string sceneFileName, bool debug);
+
+/**
+ * \struct GripRolloutParams GripRolloutEngine.h
+ * \brief Gains of the HuboController driving the controlled skeleton in one
+ * rollout. Empty gains leave the skeleton passive.
+ */
+struct GripRolloutParams {
+    Eigen::VectorXd Kp; ///< Proportional gain of each DOF
+    Eigen::VectorXd Kd; ///< Derivative gain of each DOF
+};
+
+/**
+ * \struct GripRolloutMetrics GripRolloutEngine.h
+ * \brief Summary of one rollout. Errors are how far the controlled skeleton's
+ * joints moved from where they started, which is what the controller holds.
+ */
+struct GripRolloutMetrics {
+    int index;             ///< Index of the rollout's parameters
+    int success;           ///< 1 if the rollout ran, 0 if its parameters didn't fit the skeleton
+    int numSteps;          ///< Number of time steps simulated
+    double simTime;        ///< Simulation time at the end in seconds
+    double realTime;       ///< Real time the rollout took in seconds
+    double rmsError;       ///< Root mean square joint error over all steps and DOFs
+    double maxError;       ///< Largest absolute joint error
+    double maxTorque;      ///< Largest absolute joint torque
+    double finalComHeight; ///< Height of the controlled skeleton's center of mass at the end
+};
+
+/**
+ * \class GripRolloutEngine GripRolloutEngine.h
+ * \brief Runs the same scene many times with different controller gains, e.g.
+ * for a parameter sweep. Every worker thread simulates its own copy of the
+ * world and resets it to the initial state before each rollout, and takes the
+ * next rollout as soon as it's done with one, so slow rollouts don't hold up
+ * the others. Each rollout records every few states into a compact float
+ * timeline and is summarized in a GripRolloutMetrics.
+ */
+class GripRolloutEngine
+{
+public:
+
+    /**
+     * \brief Constructs a GripRolloutEngine
+     * \param loader Function parsing a scene file into a new world
+     * \param numThreads Number of worker threads. Defaults to the number of cores
+     * \param debug Whether or not to print debug output
+     */
+    GripRolloutEngine(GripWorldLoader loader, int numThreads=-1, bool debug=false);
+
+    /**
+     * \brief Destructor for GripRolloutEngine. Deletes the worlds
+     */
+    ~GripRolloutEngine();
+
+    /**
+     * \brief Parses the scene the rollouts run in. The scene is only parsed
+     * again if the file name changed.
+     * \param sceneFileName Name of the scene file (.urdf, .sdf)
+     * \return bool Whether or not the scene was parsed
+     */
+    bool setScene(const std::string& sceneFileName);
+
+    /**
+     * \brief Sets the skeleton the rollout controllers drive. Defaults to 0,
+     * the first skeleton of the scene
+     * \param skeletonIndex Index of the skeleton in the world
+     * \return void
+     */
+    void setControlledSkeleton(size_t skeletonIndex);
+
+    /**
+     * \brief Sets how many time steps apart the states in the rollout timelines are
+     * \param numSteps Number of time steps between recorded states
+     * \return void
+     */
+    void setRecordInterval(size_t numSteps);
+
+    /**
+     * \brief Sets the number of worker threads. Only call this between runs
+     * \param numThreads Number of threads
+     * \return void
+     */
+    void setMaxThreadCount(int numThreads);
+
+    /**
+     * \brief Runs one rollout per set of parameters from the initial state of the
+     * scene and blocks until they're all done
+     * \param params Controller gains of each rollout
+     * \param numSteps Number of time steps per rollout
+     * \return size_t Number of rollouts that ran
+     */
+    size_t run(const std::vector<GripRolloutParams>& params, size_t numSteps);
+
+    /**
+     * \brief Gets the number of rollouts of the last run
+     * \return size_t
+     */
+    size_t getNumRollouts() const;
+
+    /**
+     * \brief Gets the summaries of the rollouts of the last run, in the order of their parameters
+     * \return const std::vector<GripRolloutMetrics>&
+     */
+    const std::vector<GripRolloutMetrics>& getMetrics() const;
+
+    /**
+     * \brief Gets the times of the recorded states of a rollout
+     * \param rollout Index of the rollout
+     * \return const Eigen::VectorXd& One time per recorded state
+     */
+    const Eigen::VectorXd& getTimes(size_t rollout) const;
+
+    /**
+     * \brief Gets the recorded states of a rollout
+     * \param rollout Index of the rollout
+     * \return const Eigen::MatrixXf& One world state per column
+     */
+    const Eigen::MatrixXf& getStates(size_t rollout) const;
+
+    /**
+     * \brief Gets the size of the world state
+     * \return int
+     */
+    int getStateSize() const;
+
+protected:
+
+    friend class GripRolloutTask;
+
+    /**
+     * \brief Runs rollouts in a world until there are none left. Called from the pool
+     * \param worker Index of the worker thread, which is the index of its world
+     * \return void
+     */
+    void _work(size_t worker);
+
+    /**
+     * \brief Runs one rollout in a world
+     * \param world World to simulate, reset to the initial state first
+     * \param rollout Index of the rollout
+     * \return void
+     */
+    void _runRollout(dart::simulation::World* world, size_t rollout);
+
+    /**
+     * \brief Puts every skeleton of a world back in the initial state of the scene
+     * \param world World to reset
+     * \return void
+     */
+    void _resetWorld(dart::simulation::World* world);
+
+    /**
+     * \brief Deletes the worlds of the workers
+     * \return void
+     */
+    void _clearWorlds();
+
+    GripWorldLoader _loader;                        ///< Parses the scene into each world
+    std::string _sceneFileName;                     ///< Scene the worlds were parsed from
+    std::vector<dart::simulation::World*> _worlds;  ///< One world per worker thread
+    Eigen::VectorXd _initialState;                  ///< State every rollout starts from
+
+    const std::vector<GripRolloutParams>* _params;  ///< Parameters of the current run
+    std::vector<GripRolloutMetrics> _metrics;       ///< Summary of each rollout
+    std::vector<Eigen::VectorXd> _times;            ///< Times of each rollout's recorded states
+    std::vector<Eigen::MatrixXf> _states;           ///< Recorded states of each rollout
+
+    std::atomic<size_t> _nextRollout; ///< Index of the next rollout a worker takes
+
+    /// Worker threads
+    QThreadPool* _pool;
+
+    size_t _skeletonIndex;  ///< Skeleton the controllers drive
+    size_t _recordInterval; ///< Time steps between recorded states
+    size_t _numSteps;       ///< Time steps per rollout in the current run
+    int _numThreads;        ///< Number of worker threads
+    bool _debug;            ///< Whether or not to print debug output
+};
+
+#endif // GRIP_ROLLOUT_ENGINE_H
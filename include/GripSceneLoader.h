@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file GripSceneLoader.h
+ * \brief Class for loading scene files off the GUI thread
+ */
+
+#ifndef GRIP_SCENE_LOADER_H
+#define GRIP_SCENE_LOADER_H
+
+// DART includes
+#include <dart/simulation/World.h>
+
+// Qt includes
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+// C++ Standard includes
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Local includes
+#include "MainWindow.h"
+#include "SkeletonNode.h"
+
+/**
+ * \class GripSceneLoader GripSceneLoader.h
+ * \brief Parses a scene file and builds its OpenSceneGraph nodes on its own
+ * thread, so the window stays responsive while large scenes load. Meshes are
+ * converted in parallel on a thread pool first, which fills the osgDart::MeshCache,
+ * and then the SkeletonNodes are built in parallel from the cached meshes.
+ * Progress is reported with progressChanged() and the result is picked up
+ * with takeWorld() and takeSkeletonNodes() once sceneLoaded() is emitted.
+ */
+class GripSceneLoader : public QObject
+{
+    /// Macro to create meta-object code for the signals and slots
+    Q_OBJECT
+
+public:
+
+    /**
+     * \brief Constructs a GripSceneLoader and moves it to its own thread
+     * \param parent Main window to report progress and results to, or NULL
+     * \param debug Whether or not to print debug output
+     */
+    GripSceneLoader(MainWindow* parent=0, bool debug=false);
+
+    /**
+     * \brief Destructor for GripSceneLoader
+     */
+    ~GripSceneLoader();
+
+    /**
+     * \brief Loads a scene file in the calling thread, still converting meshes and
+     * building nodes on the thread pool. Doesn't emit sceneLoaded().
+     * \param fileName Name of the urdf or sdf scene file
+     * \return bool Whether or not the scene was parsed
+     */
+    bool loadScene(std::string fileName);
+
+    /**
+     * \brief Parses a urdf or sdf scene file into a world the same way
+     * osgDart::DartNode::addWorld(std::string) does. A urdf that isn't a world is
+     * parsed as a single skeleton and put in a new world. Used by every path that
+     * loads a scene, with or without a window, so they all accept the same files.
+     * \param fileName Name of the urdf or sdf scene file
+     * \param debug Whether or not to print debug output
+     * \return dart::simulation::World* Parsed world, or NULL if parsing failed
+     */
+    static dart::simulation::World* parseScene(std::string fileName, bool debug=false);
+
+    /**
+     * \brief Gets the world of the last loaded scene and hands over its ownership
+     * \return dart::simulation::World* Parsed world, or NULL if there isn't one
+     */
+    dart::simulation::World* takeWorld();
+
+    /**
+     * \brief Gets the SkeletonNodes of the last loaded scene, one for each skeleton
+     * of the world in the same order, and hands them over
+     * \return std::vector<osg::ref_ptr<osgDart::SkeletonNode> > SkeletonNodes
+     */
+    std::vector<osg::ref_ptr<osgDart::SkeletonNode> > takeSkeletonNodes();
+
+    /**
+     * \brief Gets the name of the last loaded scene file
+     * \return std::string Scene file name
+     */
+    std::string getFileName() const;
+
+    /**
+     * \brief Sets the number of threads converting meshes and building nodes
+     * \param numThreads Number of threads. Defaults to the number of cores
+     * \return void
+     */
+    void setMaxThreadCount(int numThreads);
+
+signals:
+    /**
+     * \brief Signal emitted as meshes get converted and SkeletonNodes get built.
+     * Emitted from the thread pool.
+     * \param numDone Number of meshes and skeletons done
+     * \param numTotal Number of meshes and skeletons in the scene
+     * \param stage Description of what's being done
+     * \return void
+     */
+    void progressChanged(int numDone, int numTotal, QString stage);
+
+    /**
+     * \brief Signal emitted when load() is done
+     * \param success Whether or not the scene was parsed
+     * \return void
+     */
+    void sceneLoaded(bool success);
+
+public slots:
+    /**
+     * \brief Loads a scene file and emits sceneLoaded() when done. Call this with
+     * QMetaObject::invokeMethod and a Qt::QueuedConnection to load on the loader's thread.
+     * \param fileName Name of the urdf or sdf scene file
+     * \return void
+     */
+    void load(QString fileName);
+
+protected:
+    /**
+     * \brief Counts a finished mesh or skeleton and reports the progress
+     * \param stage Description of what's being done
+     * \return void
+     */
+    void _taskDone(const QString& stage);
+
+    friend class GripMeshTask;
+    friend class GripSkeletonNodeTask;
+
+    /// World parsed from the last scene file
+    dart::simulation::World* _world;
+
+    /// SkeletonNodes built for the skeletons of _world
+    std::vector<osg::ref_ptr<osgDart::SkeletonNode> > _skeletonNodes;
+
+    /// Name of the last scene file
+    std::string _fileName;
+
+    /// Threads converting meshes and building nodes
+    QThreadPool* _pool;
+
+    /// Local thread to move object into
+    QThread* _thread;
+
+    std::atomic<int> _numDone; ///< Number of meshes and skeletons done
+    int _numTotal; ///< Number of meshes and skeletons in the scene being loaded
+    bool _debug; ///< Bool for whether or not to print debug output to standard error
+};
+
+#endif // GRIP_SCENE_LOADER_H
@@ -57,13 +57,33 @@
 #include <QObject>
 #include <QMetaType>
 
+// C++ Standard includes
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+
 //// Local includes
 #include "MainWindow.h"
 #include "GripTab.h"
-#include "GripTimeslice.h"
+#include "GripTimeline.h"
+#include "WorldSnapshot.h"
+#include "GripPluginWorker.h"
+#include "GripProfiler.h"
 
 class GripMainWindow;
 
+/**
+ * \struct GripStepSubscriber GripSimulation.h
+ * \brief A plugin subscribed to a simulation time step event
+ */
+struct GripStepSubscriber {
+    GripTab* plugin;          ///< Subscribed plugin
+    size_t period;            ///< Number of time steps between calls
+    GripPluginWorker* worker; ///< Thread of an asynchronous plugin, or NULL to call the plugin inline
+};
+
 /**
  * \class GripSimulation GripSimulation.h
  * \brief Class that handles the simulation loop, simulation timeline, timing
@@ -83,7 +103,7 @@ public:
      * \param parent Pointer to the parent widget. Default is 0
      * \param debug Flag for whether or not to output debug statements
      */
-    GripSimulation(dart::simulation::World* world, std::vector<GripTimeslice>* timeline,
+    GripSimulation(dart::simulation::World* world, GripTimeline* timeline,
                    QList<GripTab*>* pluginLinst, MainWindow *parent=0, bool debug=false);
 
     /**
@@ -104,6 +124,60 @@ public:
      */
     void reset();
 
+    /**
+     * \brief Sets how often the batch loop in simulateBatch checks for a stop request
+     * and emits the relative time signal. A check happens every "numSteps" steps or
+     * every "interval" seconds of real time, whichever comes first.
+     * \param numSteps Number of time steps between checks
+     * \param interval Real time in seconds between checks
+     * \return void
+     */
+    void setBatchCheckRate(size_t numSteps, double interval);
+
+    /**
+     * \brief Streams every time step added to the timeline to a timeline file as
+     * well, so long runs are kept on disk. When the timeline is cut back to restart
+     * from an earlier slice, the file is cut back with it. Only call this while not
+     * simulating.
+     * \param fileName Name of the timeline file to create
+     * \return True if the file was created
+     */
+    bool setTimelineFile(std::string fileName);
+
+    /**
+     * \brief Sets the buffer a snapshot of the world is published into after every time
+     * step, so the renderer never reads the world while it's being stepped. The buffer is
+     * live from when a simulation starts until its last step. Only call this while not simulating.
+     * \param snapshotBuffer Snapshot buffer, or NULL to not publish snapshots
+     * \return void
+     */
+    void setSnapshotBuffer(osgDart::WorldSnapshotBuffer* snapshotBuffer);
+
+    /**
+     * \brief Sets the profiler that the phases of every time step are timed in: the
+     * plugins before the step, the dynamics (World::step, which includes collision
+     * detection), adding to the timeline, publishing the snapshot and the plugins after
+     * the step. Only call this while not simulating.
+     * \param profiler Profiler to record in, or NULL to not time anything
+     * \return void
+     */
+    void setProfiler(GripProfiler* profiler);
+
+    /**
+     * \brief Runs "numSteps" time steps on the simulation thread and blocks the
+     * calling thread until they're done, for external control loops. The request is
+     * handed to the simulation thread and the result handed back through a condition
+     * variable, so the caller wakes up as soon as the last step is done. Fails while
+     * the simulation is running. Called from the simulation thread itself, the steps
+     * simply run in place.
+     * \param numSteps Number of time steps to simulate. Zero just reads the state
+     * \param torques Internal forces of every DOF of the world, skeleton after
+     * skeleton, set before each of the steps. Empty to leave the forces alone
+     * \param state Vector to put the state of the world after the last step in
+     * \return bool Whether or not the steps ran
+     */
+    bool stepSynchronous(size_t numSteps, const Eigen::VectorXd& torques, Eigen::VectorXd& state);
+
 signals:
     /**
      * \brief Signal to tell parent widget that the simulation loop is done. This is
@@ -154,24 +228,119 @@ public slots:
      */
     virtual void simulateSingleTimeStep();
 
+    /**
+     * \brief Slot that simulates "numSteps" time steps in a tight loop on the
+     * simulation thread without going back to the event loop after each step.
+     * Stop requests and the relative time signal are only handled at the rate
+     * set by setBatchCheckRate. Emits simulationStoppedSignal when done.
+     * \param numSteps Number of time steps to simulate
+     * \return void
+     */
+    virtual void simulateBatch(int numSteps);
+
+    /**
+     * \brief Slot that runs the request handed over by stepSynchronous and wakes
+     * up the caller waiting for it. Only invoked by stepSynchronous.
+     * \return void
+     */
+    virtual void processStepRequest();
+
+    /**
+     * \brief Slot that stops streaming time steps to the timeline file and closes
+     * it. Invoke it on the simulation thread while a simulation may be running,
+     * since the file is written there
+     * \return void
+     */
+    void closeTimelineFile();
+
 protected:
     /**
-     * \brief Adds a GripTimeslice to the timeline vector in order to store the
+     * \brief Runs the plugins' before-timestep functions, steps the world dynamics
+     * forward one step, adds the world to the timeline and runs the plugins'
+     * after-timestep functions.
+     * \return void
+     */
+    void stepWorld();
+
+    /**
+     * \brief Adds a timeslice to the timeline in order to store the
      * world time and state in the timeline for playback or movie saving at a later time.
      * \param worldToAdd dart::simulation::World object of which to save the time and state.
      * \return void
      */
     void addWorldToTimeline(const dart::simulation::World& worldToAdd);
 
+    /**
+     * \brief Rebuilds the lists of plugins subscribed to the time step events from
+     * their subscriptions and callback rates, and starts a GripPluginWorker for every
+     * new asynchronous plugin. Called when a simulation starts, so the loop itself
+     * only goes through the plugins that asked to be called.
+     * \return void
+     */
+    void _updateSubscriptions();
+
+    /**
+     * \brief Cuts the timeline file back to the timeline, if the timeline was
+     * truncated since the last time step was recorded
+     * \return void
+     */
+    void _truncateTimelineFile();
+
+    /**
+     * \brief Runs the steps of a synchronous step request on the current thread
+     * \return bool Whether or not the steps ran
+     */
+    bool _runStepRequest();
+
     /// World object received from creator that we need to simulate
     dart::simulation::World* _world;
 
     /// Array of GripTimeSlice objects for simulation/kinematic playback
-    std::vector<GripTimeslice>* _timeline;
+    GripTimeline* _timeline;
+
+    /// File the timeline is streamed to while simulating, or NULL
+    GripTimelineFile* _timelineFile;
+
+    /// Index in the timeline of the first record in the timeline file
+    size_t _timelineFileStart;
+
+    /// Buffer the world is published into for rendering after every time step, or NULL
+    osgDart::WorldSnapshotBuffer* _snapshotBuffer;
 
     /// List of plugin pointers in order call their functions every timestep of simulation
     QList<GripTab*>* _plugins;
 
+    std::vector<GripStepSubscriber> _beforeStepSubscribers; ///< Plugins called before time steps
+    std::vector<GripStepSubscriber> _afterStepSubscribers;  ///< Plugins called or posted to after time steps
+
+    /// Threads of the asynchronous plugins, kept running between simulations
+    std::map<GripTab*, GripPluginWorker*> _pluginWorkers;
+
+    /// State of the world after the last time step, as added to the timeline
+    Eigen::VectorXd _state;
+
+    /// Number of time steps simulated, for plugins called every N steps
+    size_t _numSteps;
+
+    /// Profiler the phases of each time step are timed in, or NULL
+    GripProfiler* _profiler;
+
+    size_t _phaseStep;          ///< Profiler phase of a whole time step
+    size_t _phasePluginsBefore; ///< Profiler phase of the plugins before a time step
+    size_t _phaseDynamics;      ///< Profiler phase of stepping the world
+    size_t _phaseTimeline;      ///< Profiler phase of adding the world to the timeline
+    size_t _phaseSnapshot;      ///< Profiler phase of publishing the snapshot
+    size_t _phasePluginsAfter;  ///< Profiler phase of the plugins after a time step
+    size_t _phaseSignals;       ///< Profiler phase of emitting the relative time to the window
+
+    std::mutex _stepMutex;                  ///< Guards the synchronous step request
+    std::condition_variable _stepDone;      ///< Signaled when a synchronous step request is done
+    bool _stepPending;                      ///< Whether a synchronous step request is waiting or running
+    bool _stepSucceeded;                    ///< Whether the last synchronous step request ran
+    size_t _stepCount;                      ///< Number of steps requested
+    Eigen::VectorXd _stepTorques;           ///< Torques requested, or empty
+    Eigen::VectorXd _stepState;             ///< State after the requested steps
+
     /// Local thread to move object into
     QThread* _thread;
 
@@ -180,7 +349,10 @@ protected:
     double _simTimeRelToRealTimeInstantaneous; ///< Simulation time relative to realtime (ie. 1.0 is realtime. 0.5 is half the speed of realtime)
     double _prevTime; ///< Real time on the last time step
 
-    bool _simulating; ///< Bool for whether or not we are simulating
+    size_t _batchCheckSteps; ///< Number of steps between stop checks in batch mode
+    double _batchCheckInterval; ///< Real time in seconds between stop checks in batch mode
+
+    std::atomic<bool> _simulating; ///< Bool for whether or not we are simulating. Atomic since it's set from the GUI thread
     bool _simulateOneFrame; ///< Bool for whether or not to simulate only one frame
     bool _debug; ///< Bool for whether or not to print debug output to standard error
 };
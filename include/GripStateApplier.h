@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file GripStateApplier.h
+ * \brief Class for setting recorded world states on the world's skeletons
+ */
+
+#ifndef GRIP_STATE_APPLIER_H
+#define GRIP_STATE_APPLIER_H
+
+// DART includes
+#include <dart/simulation/World.h>
+
+// C++ Standard includes
+#include <vector>
+
+/**
+ * \class GripStateApplier GripStateApplier.h
+ * \brief Sets world states from the timeline on the skeletons of a world for
+ * playback. Where every skeleton's coordinates are in the world state is
+ * worked out once per scene, the coordinates are copied into buffers kept
+ * from one frame to the next, and each skeleton gets a single forward
+ * kinematics pass. Skeletons whose state didn't change since the last
+ * apply() are skipped, so call invalidate() after moving the skeletons any
+ * other way, e.g. by simulating.
+ */
+class GripStateApplier
+{
+public:
+    /**
+     * \brief Constructs a GripStateApplier
+     * \param world World whose skeletons get the states
+     */
+    GripStateApplier(dart::simulation::World* world=0);
+
+    /**
+     * \brief Sets the world whose skeletons get the states
+     * \param world World whose skeletons get the states
+     * \return void
+     */
+    void setWorld(dart::simulation::World* world);
+
+    /**
+     * \brief Sets the state of every skeleton whose part of the state changed.
+     * The layout is worked out again if the world's skeletons changed.
+     * \param state World state, [q, dq] of each skeleton one after the other
+     * \return void
+     */
+    void apply(const Eigen::Map<const Eigen::VectorXd>& state);
+
+    /**
+     * \brief Sets the state of every skeleton whose part of the state changed
+     * \param state World state, [q, dq] of each skeleton one after the other
+     * \return void
+     */
+    void apply(const Eigen::VectorXd& state);
+
+    /**
+     * \brief Forgets the states applied so far, so the next apply() sets every skeleton
+     * \return void
+     */
+    void invalidate();
+
+    /**
+     * \brief Gets the number of skeletons the last apply() skipped because their state didn't change
+     * \return int
+     */
+    int getNumSkipped() const;
+
+protected:
+    /**
+     * \brief Finds where each skeleton's coordinates are in the world state
+     * and sizes the buffers. Invalidates the applied states.
+     * \return void
+     */
+    void _layout();
+
+    /**
+     * \brief Whether or not the world's skeletons are still the ones laid out
+     * \return bool
+     */
+    bool _layoutIsValid() const;
+
+    /// World whose skeletons get the states
+    dart::simulation::World* _world;
+
+    /// Skeletons of the world when the layout was worked out
+    std::vector<dart::dynamics::Skeleton*> _skeletons;
+
+    /// Index in the world state of each skeleton's coordinates
+    std::vector<int> _starts;
+
+    /// Coordinates last set on each skeleton
+    std::vector<Eigen::VectorXd> _q;
+
+    /// Velocities last set on each skeleton
+    std::vector<Eigen::VectorXd> _dq;
+
+    /// Whether or not _q and _dq are what each skeleton has
+    std::vector<bool> _applied;
+
+    /// Number of skeletons skipped by the last apply()
+    int _numSkipped;
+};
+
+#endif // GRIP_STATE_APPLIER_H
@@ -0,0 +1,532 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file GripTimeline.h
+ * \brief Container for the world states recorded during simulation and
+ * kinematic playback
+ */
+
+#ifndef GRIP_TIMELINE_H
+#define GRIP_TIMELINE_H
+
+// Local includes
+#include "GripTimeslice.h"
+#include "GripTimelineFile.h"
+
+// DART includes
+#include <dart/simulation/World.h>
+
+// C++ Standard includes
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <cstddef>
+#include <mutex>
+#include <stdint.h>
+
+/**
+ * \enum timelineCompression_t
+ * \brief How the world states are stored in the timeline
+ */
+typedef enum {
+    TIMELINE_RAW = 0,       ///< Full states, no compression
+    TIMELINE_LOSSLESS,      ///< Keyframes plus XOR deltas, bit exact
+    TIMELINE_QUANTIZED      ///< Keyframes plus quantized deltas, bounded error
+} timelineCompression_t;
+
+/**
+ * \class GripTimesliceView GripTimeline.h
+ * \brief Lightweight, read-only view of one slice of a GripTimeline. Raw states
+ * in memory or in a memory mapped file aren't copied; the view maps them, so it
+ * is only valid until the timeline is modified. Compressed and spilled states are
+ * decoded into the view itself, so views never overwrite each other.
+ */
+class GripTimesliceView
+{
+public:
+    /**
+     * \brief Constructs a view onto a time and a state stored elsewhere
+     * \param time Timestamp of the world state
+     * \param state Pointer to the first element of the world state
+     * \param stateSize Number of elements in the world state
+     */
+    GripTimesliceView(double time, const double* state, size_t stateSize);
+
+    /// The timeline decodes compressed states straight into the view
+    friend class GripTimeline;
+
+    /**
+     * \brief Gets the time stored in the timeslice
+     * \return Double value of the time
+     */
+    double getTime() const;
+
+    /**
+     * \brief Gets the state stored in the timeslice
+     * \return Eigen::Map of the world state in the timeline's memory, or in the view
+     */
+    Eigen::Map<const Eigen::VectorXd> getState() const;
+
+protected:
+    double _time; ///< Timestamp for the world state
+    const double* _state; ///< Pointer to the world state in the timeline
+    size_t _stateSize; ///< Number of elements in the world state
+    Eigen::VectorXd _decoded; ///< Decoded state, used instead of _state when not empty
+
+}; // end class GripTimesliceView
+
+/**
+ * \class GripTimeline GripTimeline.h
+ * \brief Structure-of-arrays store for the timeline. The states are packed into
+ * fixed size chunks of contiguous memory, each row being one world state, with a
+ * parallel array of times. Chunks are allocated at full size up front and never
+ * grow, so pushing a new slice never copies or moves the slices already stored
+ * and memory use is (number of slices) * (state size + 1) * sizeof(double),
+ * rounded up to a chunk.
+ *
+ * The states can optionally be compressed (see setCompression). Every
+ * keyframeInterval slices a full keyframe is stored, followed by deltas against
+ * the previous slice, so random access only decodes back to the nearest keyframe
+ * and sequential access decodes a single delta.
+ *
+ * A timeline can also be saved to a GripTimelineFile and loaded back. A loaded
+ * timeline reads its slices straight out of the memory mapped file. Pushing or
+ * truncating copies the slices into memory first and closes the file.
+ *
+ * By default the timeline keeps everything. With a retention time set (see
+ * setRetention) only the chunks covering the last N seconds stay in memory, and
+ * the chunks before that are either dropped or spilled to a compressed temporary
+ * file. Indices are never renumbered: dropped slices make getFirstIndex() move
+ * forward, while spilled slices stay readable through at().
+ *
+ * Every method locks the timeline, so one thread can push while another reads.
+ * The views returned by at(), front() and back() can still point into memory a
+ * later push reuses, so a thread reading while another one pushes should copy
+ * the slices out with at(index, state) or copyTo instead. Evicted chunks are
+ * reused for new slices, so when the thread holding views isn't the one pushing,
+ * it should defer eviction to itself (see setDeferredEviction).
+ */
+class GripTimeline
+{
+public:
+    /**
+     * \brief Constructs an empty GripTimeline
+     * \param chunkSize Number of timeslices stored per chunk of memory
+     */
+    GripTimeline(size_t chunkSize=4096);
+
+    /**
+     * \brief Destructs a GripTimeline object
+     */
+    ~GripTimeline();
+
+    /**
+     * \brief Sets how states are stored. Changing the compression clears the timeline.
+     * \param compression TIMELINE_RAW, TIMELINE_LOSSLESS or TIMELINE_QUANTIZED
+     * \param keyframeInterval Number of slices between full keyframes. Bounds the
+     * number of deltas decoded on random access
+     * \param resolution Quantization step for TIMELINE_QUANTIZED. Decoded values
+     * are within resolution/2 of the recorded values
+     * \return void
+     */
+    void setCompression(timelineCompression_t compression, size_t keyframeInterval=64,
+                        double resolution=1e-6);
+
+    /**
+     * \brief Gets how states are stored
+     * \return The compression mode
+     */
+    timelineCompression_t getCompression() const;
+
+    /**
+     * \brief Bounds how much of the timeline is kept in memory. Whole chunks are
+     * evicted once their last slice is more than "seconds" older than the newest
+     * slice, and their memory is reused for new chunks. Changing the retention
+     * clears the timeline.
+     * \param seconds Amount of simulation time to keep in memory. Zero or less
+     * keeps everything
+     * \param spillToDisk If true, evicted chunks are compressed into a temporary
+     * file and stay readable. If false, they're dropped
+     * \return void
+     */
+    void setRetention(double seconds, bool spillToDisk=false);
+
+    /**
+     * \brief Gets the amount of simulation time kept in memory
+     * \return Retention time in seconds, or zero or less if everything is kept
+     */
+    double getRetention() const;
+
+    /**
+     * \brief Sets whether chunks outside the retention time are evicted by push_back
+     * or only when evict() is called. Deferring lets the thread that reads views
+     * evict between its own reads, while another thread pushes.
+     * \param deferred If true, only evict() evicts
+     * \return void
+     */
+    void setDeferredEviction(bool deferred);
+
+    /**
+     * \brief Evicts the chunks outside the retention time, spilling them first if
+     * spilling is on. push_back does this itself unless eviction is deferred.
+     * \return void
+     */
+    void evict();
+
+    /**
+     * \brief Appends the current time and state of the world to the timeline.
+     * The first slice pushed sets the state size for the whole timeline.
+     * \param world World object from which to record the time and state
+     * \return void
+     */
+    void push_back(const dart::simulation::World& world);
+
+    /**
+     * \brief Appends a GripTimeslice to the timeline
+     * \param timeslice Time and state to store
+     * \return void
+     */
+    void push_back(const GripTimeslice& timeslice);
+
+    /**
+     * \brief Appends a time and a state to the timeline
+     * \param time Timestamp of the world state
+     * \param state State of the world at this time. Must have the same size as
+     * the states already stored
+     * \return void
+     */
+    void push_back(double time, const Eigen::VectorXd& state);
+
+    /**
+     * \brief Gets the timeslice at the given index. Throws std::out_of_range
+     * if the index is past the end, like std::vector::at, or was evicted
+     * \param index Index of the timeslice
+     * \return View onto the time and state of the timeslice
+     */
+    GripTimesliceView at(size_t index) const;
+
+    /**
+     * \brief Copies the timeslice at the given index into a vector owned by the
+     * caller, decoding it if it's compressed. Nothing is allocated if the vector
+     * already has the right size. Throws std::out_of_range like at()
+     * \param index Index of the timeslice
+     * \param state Vector to put the state in. Resized to getStateSize() if needed
+     * \return Simulation time of the timeslice
+     */
+    double at(size_t index, Eigen::VectorXd& state) const;
+
+    /**
+     * \brief Gets the time of the timeslice at the given index without decoding
+     * its state. Throws std::out_of_range like at()
+     * \param index Index of the timeslice
+     * \return Simulation time of the timeslice
+     */
+    double getTime(size_t index) const;
+
+    /**
+     * \brief Copies a range of timeslices into contiguous arrays in one pass, e.g.
+     * to hand the whole timeline to numpy. Raw slices in memory are copied a chunk
+     * at a time, compressed ones are decoded sequentially. Throws std::out_of_range
+     * like at() if any slice in the range isn't available
+     * \param first Index of the first timeslice to copy
+     * \param count Number of timeslices to copy
+     * \param times Array of at least count times to fill
+     * \param states Array of at least count * getStateSize() values to fill, one state per row
+     * \return void
+     */
+    void copyTo(size_t first, size_t count, double* times, double* states) const;
+
+    /**
+     * \brief Finds the last timeslice at or before the given time with a
+     * binary search, or the first available one if the time is before it.
+     * Throws std::out_of_range if the timeline is empty
+     * \param time Simulation time to look up
+     * \return Index of the timeslice
+     */
+    size_t findIndex(double time) const;
+
+    /**
+     * \brief Gets the first timeslice that's still available (see getFirstIndex)
+     * \return View onto the time and state of the first timeslice
+     */
+    GripTimesliceView front() const;
+
+    /**
+     * \brief Gets the last timeslice in the timeline
+     * \return View onto the time and state of the last timeslice
+     */
+    GripTimesliceView back() const;
+
+    /**
+     * \brief Gets the number of timeslices ever added to the timeline, including
+     * evicted ones, i.e. one past the index of the last timeslice
+     * \return Number of timeslices
+     */
+    size_t size() const;
+
+    /**
+     * \brief Gets the index of the first timeslice that hasn't been dropped by
+     * the retention policy. Valid indices are [getFirstIndex(), size())
+     * \return Index of the first available timeslice
+     */
+    size_t getFirstIndex() const;
+
+    /**
+     * \brief Whether or not the timeline has any timeslices
+     * \return True if the timeline is empty
+     */
+    bool empty() const;
+
+    /**
+     * \brief Removes every timeslice at or after the given index, keeping
+     * the first newSize timeslices. Chunks that are no longer used are freed.
+     * Truncating into spilled slices brings the new last chunk back into memory.
+     * Truncating into dropped slices clears the timeline.
+     * \param newSize Number of timeslices to keep
+     * \return void
+     */
+    void truncate(size_t newSize);
+
+    /**
+     * \brief Removes all timeslices and frees all memory. The next slice
+     * pushed sets a new state size.
+     * \return void
+     */
+    void clear();
+
+    /**
+     * \brief Gets the number of elements in each stored world state
+     * \return Size of the world state, or 0 if the timeline is empty
+     */
+    size_t getStateSize() const;
+
+    /**
+     * \brief Gets the number of timeslices stored per chunk of memory
+     * \return Chunk size
+     */
+    size_t getChunkSize() const;
+
+    /**
+     * \brief Writes every timeslice to a timeline file
+     * \param fileName Name of the file to write
+     * \param world World the timeline was recorded from, for the file's skeleton layout
+     * \return True if the file was written
+     */
+    bool save(const std::string& fileName, const dart::simulation::World& world) const;
+
+    /**
+     * \brief Replaces the contents of the timeline with a memory mapped timeline
+     * file. Nothing is copied; slices are read from the file as they're accessed.
+     * \param fileName Name of the file to load
+     * \param world World the states will be set on. The file's skeleton layout must match it
+     * \return True if the file was loaded
+     */
+    bool load(const std::string& fileName, const dart::simulation::World& world);
+
+    /**
+     * \brief Gets the amount of memory allocated for the timeslices. Memory mapped
+     * files aren't counted.
+     * \return Number of bytes allocated
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * \brief Gets the amount of memory the available timeslices would take uncompressed
+     * \return Number of bytes
+     */
+    size_t getRawMemoryUsage() const;
+
+    /**
+     * \brief Gets the size of the spill file
+     * \return Number of bytes spilled to disk
+     */
+    size_t getSpilledBytes() const;
+
+protected:
+    /**
+     * \brief Appends a time and a state without locking the timeline. See push_back
+     * \param time Timestamp of the world state
+     * \param state State of the world at this time
+     * \return void
+     */
+    void _push(double time, const Eigen::VectorXd& state);
+
+    /**
+     * \brief Gets a view of the timeslice at the given index without locking the
+     * timeline. See at()
+     * \param index Index of the timeslice
+     * \return View onto the time and state of the timeslice
+     */
+    GripTimesliceView _view(size_t index) const;
+
+    /**
+     * \brief Copies the timeslice at the given index without locking the timeline.
+     * The index must be valid
+     * \param index Index of the timeslice
+     * \param state Array of getStateSize() values to put the state in
+     * \return Time of the timeslice
+     */
+    double _read(size_t index, double* state) const;
+
+    /**
+     * \brief Gets the time of a timeslice without locking the timeline. See getTime
+     * \param index Index of the timeslice
+     * \return Time of the timeslice
+     */
+    double _getTime(size_t index) const;
+
+    /**
+     * \brief Removes all timeslices without locking the timeline. See clear
+     * \return void
+     */
+    void _clear();
+
+    /**
+     * \brief Throws std::out_of_range if no timeslice is available at the index
+     * \param index Index of the timeslice
+     * \param what Message of the exception
+     * \return void
+     */
+    void _checkIndex(size_t index, const char* what) const;
+
+    /**
+     * \brief Encodes a state as a keyframe or a delta against the previous state
+     * and appends it to the last block
+     * \param state State to encode
+     * \return void
+     */
+    void _encode(const Eigen::VectorXd& state);
+
+    /**
+     * \brief Moves the decode cursor to the state at the given index. Continues
+     * from the last decoded slice if it's in the same block and before the index,
+     * otherwise starts from the block's keyframe.
+     * \param index Index of the timeslice to decode
+     * \return void
+     */
+    void _decode(size_t index) const;
+
+    /**
+     * \brief Moves the decode cursor to a spilled slice, reading its chunk from
+     * the spill file if it isn't the one already read
+     * \param index Index of the timeslice to decode
+     * \return Time of the timeslice
+     */
+    double _decodeSpilled(size_t index) const;
+
+    /**
+     * \brief Evicts the oldest chunks that fall outside the retention time,
+     * spilling them first if spilling is on
+     * \return void
+     */
+    void _evict();
+
+    /**
+     * \brief Compresses the oldest chunk in memory and appends it to the spill file
+     * \return void
+     */
+    void _spillChunk();
+
+    /**
+     * \brief Truncates into the spilled slices. The spilled chunk holding the new
+     * last slice is read back into memory and everything after it is dropped
+     * \param newSize Number of timeslices to keep
+     * \return void
+     */
+    void _unspill(size_t newSize);
+
+    /**
+     * \brief Copies the first numSlices slices of the loaded file into memory
+     * and closes the file
+     * \param numSlices Number of slices to keep
+     * \return void
+     */
+    void _detachFile(size_t numSlices);
+
+    /**
+     * \brief Allocates a new chunk at full size if the last one is full
+     * \return void
+     */
+    void _reserveRow();
+
+    size_t _chunkSize; ///< Number of timeslices per chunk
+    size_t _stateSize; ///< Number of elements in each world state
+    size_t _size; ///< Number of timeslices in the timeline
+    size_t _firstIndex; ///< Index of the first timeslice that hasn't been dropped
+    size_t _memFirstChunk; ///< Chunk number of the first chunk in memory
+    std::deque<std::vector<double> > _timeChunks; ///< Times, one chunk of _chunkSize at a time
+    std::deque<std::vector<double> > _stateChunks; ///< States, _chunkSize rows of _stateSize each
+    std::vector<double> _spareTimeChunk; ///< Evicted time chunk kept for reuse
+    std::vector<double> _spareStateChunk; ///< Evicted state chunk kept for reuse
+
+    double _retention; ///< Seconds of simulation time kept in memory, everything if <= 0
+    bool _spillToDisk; ///< Whether evicted chunks are spilled or dropped
+    bool _deferEviction; ///< Whether only evict() evicts, rather than every push
+    FILE* _spillFile; ///< Temporary file holding the spilled chunks, or NULL
+    size_t _spilledBytes; ///< Number of bytes used in the spill file
+    std::vector<size_t> _spillOffsets; ///< Offset of each spilled chunk in the spill file
+    std::vector<std::vector<uint32_t> > _spillKeyframes; ///< Offset of each keyframe in each spilled chunk
+    mutable std::vector<unsigned char> _spillBuffer; ///< Last spilled chunk read back from disk
+    mutable size_t _spillBufferChunk; ///< Chunk number in the spill buffer, or max size_t if none
+
+    timelineCompression_t _compression; ///< How the states are stored
+    size_t _keyframeInterval; ///< Number of slices per compressed block
+    double _resolution; ///< Quantization step for TIMELINE_QUANTIZED
+    std::deque<std::vector<unsigned char> > _blocks; ///< Compressed states, one keyframe and its deltas per block
+    std::vector<uint64_t> _encodePrev; ///< Last encoded state (bits or quantized integers)
+
+    bool _clampWarned; ///< Whether values that couldn't be quantized were reported already
+
+    GripTimelineFile* _file; ///< Memory mapped file the slices are read from, or NULL
+
+    mutable std::vector<uint64_t> _decodePrev; ///< Encoded state the decode cursor is at
+    mutable size_t _decodedIndex; ///< Index of the slice the decode cursor is at, or max size_t if none
+    mutable size_t _decodeOffset; ///< Byte offset in its block (or spilled chunk) just past the decoded slice
+
+    mutable std::mutex _mutex; ///< Locked by every public method
+
+}; // end class GripTimeline
+
+#endif // GRIP_TIMELINE_H
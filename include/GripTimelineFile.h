@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file GripTimelineFile.h
+ * \brief Binary file format for saving timelines to disk and memory mapping
+ * them back for playback
+ */
+
+#ifndef GRIP_TIMELINE_FILE_H
+#define GRIP_TIMELINE_FILE_H
+
+// DART includes
+#include <dart/simulation/World.h>
+
+// C++ Standard includes
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdint.h>
+
+class GripTimesliceView;
+
+/**
+ * \class GripTimelineFile GripTimelineFile.h
+ * \brief Reads and writes timeline files. The layout, in host byte order, is:
+ *
+ *     char[8]   magic "GRIPTML1"
+ *     uint32    format version
+ *     uint32    state size (number of doubles per state)
+ *     uint64    header size in bytes (records start here, multiple of 8)
+ *     uint32    number of skeletons
+ *     uint32    reserved
+ *     for each skeleton:
+ *         uint32    name length, followed by the name (no terminator)
+ *         uint32    index of the skeleton's state in the world state
+ *         uint32    number of generalized coordinates
+ *     padding to a multiple of 8 bytes
+ *     records:  double time, double state[state size]
+ *
+ * Records are fixed width, so the number of records follows from the file size
+ * and a file cut short by a crash loses at most the record being written.
+ * Writing appends one record at a time through a buffered stream. Reading maps
+ * the file into memory and hands out views of the records without copying them.
+ */
+class GripTimelineFile
+{
+public:
+    /**
+     * \brief Constructs a GripTimelineFile object with no file open
+     */
+    GripTimelineFile();
+
+    /**
+     * \brief Closes the file if one is open and destructs the object
+     */
+    ~GripTimelineFile();
+
+    /**
+     * \brief Creates a timeline file for writing and writes the header with the
+     * skeleton layout of the world. Overwrites an existing file.
+     * \param fileName Name of the file to create
+     * \param world World whose states will be appended
+     * \return True if the file was created
+     */
+    bool create(const std::string& fileName, const dart::simulation::World& world);
+
+    /**
+     * \brief Appends a record to a file opened with create
+     * \param time Timestamp of the world state
+     * \param state Pointer to getStateSize() doubles
+     * \return True if the record was written
+     */
+    bool append(double time, const double* state);
+
+    /**
+     * \brief Flushes appended records to disk
+     * \return void
+     */
+    void flush();
+
+    /**
+     * \brief Cuts a file opened with create back to its first numRecords records.
+     * The next record is appended after them
+     * \param numRecords Number of records to keep
+     * \return True if the file was cut
+     */
+    bool truncate(size_t numRecords);
+
+    /**
+     * \brief Opens a timeline file for reading by memory mapping it
+     * \param fileName Name of the file to open
+     * \return True if the file was opened and has a valid header
+     */
+    bool open(const std::string& fileName);
+
+    /**
+     * \brief Closes the file, unmapping it or flushing it depending on the mode
+     * \return void
+     */
+    void close();
+
+    /**
+     * \brief Whether or not a file is open for reading or writing
+     * \return True if a file is open
+     */
+    bool isOpen() const;
+
+    /**
+     * \brief Gets the number of records in the file
+     * \return Number of records
+     */
+    size_t size() const;
+
+    /**
+     * \brief Gets the record at the given index from a file opened for reading.
+     * The view points into the mapped file and is valid until the file is closed.
+     * \param index Index of the record
+     * \return View onto the time and state of the record
+     */
+    GripTimesliceView at(size_t index) const;
+
+    /**
+     * \brief Gets the name of the open file
+     * \return File name, or the last file name if the file was closed
+     */
+    const std::string& getFileName() const;
+
+    /**
+     * \brief Gets the number of doubles per state
+     * \return Size of the world state
+     */
+    size_t getStateSize() const;
+
+    /**
+     * \brief Gets the names of the skeletons in the file's header
+     * \return Vector of skeleton names, in world order
+     */
+    const std::vector<std::string>& getSkeletonNames() const;
+
+    /**
+     * \brief Checks whether the file's skeleton layout matches a world, so its
+     * states can be set on that world
+     * \param world World to compare against
+     * \return True if the skeleton names, sizes and state size all match
+     */
+    bool matchesWorld(const dart::simulation::World& world) const;
+
+protected:
+    /**
+     * \brief Reads the skeleton layout of a world into the header members
+     * \param world World to read
+     * \return void
+     */
+    void _setLayout(const dart::simulation::World& world);
+
+    std::string _fileName; ///< Name of the open file
+    FILE* _writeFile; ///< Stream for appending records, or NULL if not writing
+    int _readFd; ///< File descriptor of the mapped file, or -1 if not reading
+    const unsigned char* _map; ///< Start of the mapped file
+    size_t _mapSize; ///< Number of bytes mapped
+    uint64_t _headerSize; ///< Offset of the first record
+    size_t _numRecords; ///< Number of records in the file
+
+    uint32_t _stateSize; ///< Number of doubles per state
+    std::vector<std::string> _skeletonNames; ///< Name of each skeleton
+    std::vector<uint32_t> _skeletonIndices; ///< Index of each skeleton's state in the world state
+    std::vector<uint32_t> _skeletonNumGenCoords; ///< Number of generalized coordinates per skeleton
+
+}; // end class GripTimelineFile
+
+#endif // GRIP_TIMELINE_FILE_H
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file GripTimelineInterpolator.h
+ * \brief Class for getting world states between the timeslices of a timeline
+ */
+
+#ifndef GRIP_TIMELINE_INTERPOLATOR_H
+#define GRIP_TIMELINE_INTERPOLATOR_H
+
+// Local includes
+#include "GripTimeline.h"
+
+// DART includes
+#include <dart/simulation/World.h>
+
+// C++ Standard includes
+#include <vector>
+
+/**
+ * \class GripTimelineInterpolator GripTimelineInterpolator.h
+ * \brief Computes the world state at any time of a GripTimeline from the two
+ * timeslices around it, so playback can run at any speed and frame rate
+ * independent of the simulation time step. Generalized coordinates and
+ * velocities are interpolated linearly, except the coordinates of FreeJoints,
+ * which are exponential coordinates of a rigid transform and get their
+ * rotation slerped and their translation interpolated linearly instead.
+ */
+class GripTimelineInterpolator
+{
+public:
+    /**
+     * \brief Constructs a GripTimelineInterpolator with no FreeJoints
+     */
+    GripTimelineInterpolator();
+
+    /**
+     * \brief Finds where the FreeJoints of the world's skeletons are in the world
+     * state. Call again whenever skeletons are added to or removed from the world.
+     * \param world World whose states are in the timeline
+     * \return void
+     */
+    void setWorld(const dart::simulation::World& world);
+
+    /**
+     * \brief Interpolates the world state at the given time. Times before or
+     * after the timeline give its first or last timeslice.
+     * Throws std::out_of_range if the timeline is empty.
+     * \param timeline Timeline to interpolate
+     * \param time Simulation time of the state
+     * \param state Interpolated world state
+     * \return size_t Index of the timeslice at or before the time
+     */
+    size_t interpolate(const GripTimeline& timeline, double time, Eigen::VectorXd& state);
+
+protected:
+    /// Index in the world state of the six coordinates of every FreeJoint
+    std::vector<int> _freeJointOffsets;
+
+    /// State of the timeslice before the time, kept while the state is interpolated in place
+    Eigen::VectorXd _before;
+
+    /// State of the timeslice after the time, reused so playback doesn't allocate
+    Eigen::VectorXd _after;
+};
+
+#endif // GRIP_TIMELINE_INTERPOLATOR_H
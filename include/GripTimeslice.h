@@ -93,13 +93,13 @@ public:
      * \brief Gets the time stored in the GripTimeslice
      * \return Double value of the time
      */
-    double getTime();
+    double getTime() const;
 
     /**
      * \brief Gets the state stored in the GripTimeslice
      * \return Eigen::VectorXd representing the world state
      */
-    const Eigen::VectorXd& getState();
+    const Eigen::VectorXd& getState() const;
 
 protected:
     double _time; ///< Timestamp for the world state
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file GripVideoEncoder.h
+ * \brief Class for writing recorded frames to disk while they are captured
+ */
+
+#ifndef GRIP_VIDEO_ENCODER_H
+#define GRIP_VIDEO_ENCODER_H
+
+// Qt includes
+#include <QImage>
+#include <QMutex>
+#include <QPair>
+#include <QProcess>
+#include <QQueue>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+/**
+ * \class GripVideoEncoder GripVideoEncoder.h
+ * \brief Streams recorded frames to disk. addFrame() puts a frame in a bounded
+ * queue and a pool of encoder threads writes numbered PNG or raw frames as they
+ * arrive, or a single thread pipes them to an ffmpeg process in order. The
+ * queue blocks the recorder when the encoders fall behind, so memory stays
+ * constant however long the recording is.
+ */
+class GripVideoEncoder
+{
+public:
+
+    /// Where the frames end up
+    typedef enum {
+        PNG_FRAMES = 0,  ///< One numbered PNG image per frame
+        RAW_FRAMES,      ///< One numbered file of raw 32 bit BGRA pixels per frame
+        FFMPEG_PIPE      ///< A single video file encoded by an ffmpeg process
+    } encoderOutput_t;
+
+    /**
+     * \brief Constructs a GripVideoEncoder
+     * \param maxQueuedFrames Number of frames that can wait for an encoder
+     * \param numThreads Number of encoder threads for numbered frames. Defaults to the number of cores
+     */
+    GripVideoEncoder(int maxQueuedFrames=16, int numThreads=-1);
+
+    /**
+     * \brief Destructor for GripVideoEncoder. Finishes the current recording
+     */
+    ~GripVideoEncoder();
+
+    /**
+     * \brief Starts a recording. Numbered frames are named after fileName
+     * without its extension, e.g. "dir/run.png" gives "dir/run000000.png",
+     * "dir/run000001.png", and so on.
+     * \param fileName Name of the video file, or pattern of the frame files
+     * \param output Type of output to write
+     * \param fps Frame rate of the video, only used by FFMPEG_PIPE
+     * \return bool Whether or not the recording started
+     */
+    bool start(const QString& fileName, encoderOutput_t output, double fps=30);
+
+    /**
+     * \brief Queues a frame to be written. Blocks while the queue is full.
+     * \param frame Frame to write. All frames of a recording must be the same size
+     * \return bool Whether or not the frame was queued
+     */
+    bool addFrame(const QImage& frame);
+
+    /**
+     * \brief Waits for every queued frame to be written and ends the recording
+     * \return bool Whether or not every frame was written
+     */
+    bool finish();
+
+    /**
+     * \brief Whether or not a recording is running
+     * \return bool
+     */
+    bool isRecording() const;
+
+    /**
+     * \brief Gets the number of frames written in the current or last recording
+     * \return int
+     */
+    int getNumFramesWritten() const;
+
+    /**
+     * \brief Gets the output type matching a file name's extension. "png" and
+     * "raw" give numbered frames, anything else a video through ffmpeg
+     * \param fileName Name of the output file
+     * \return encoderOutput_t
+     */
+    static encoderOutput_t outputFromFileName(const QString& fileName);
+
+protected:
+
+    /**
+     * \brief Takes frames off the queue and writes them until the recording
+     * is finished and the queue is empty. Runs on the encoder threads.
+     * \return void
+     */
+    void _encode();
+
+    /**
+     * \brief Writes one frame to its own file or to the ffmpeg pipe
+     * \param index Frame number in the recording
+     * \param frame Frame to write
+     * \return bool Whether or not the frame was written
+     */
+    bool _writeFrame(int index, const QImage& frame);
+
+    /**
+     * \brief Opens the ffmpeg pipe for frames of the given size
+     * \param width Width of the frames in pixels
+     * \param height Height of the frames in pixels
+     * \return bool Whether or not ffmpeg started
+     */
+    bool _openPipe(int width, int height);
+
+    /**
+     * \brief Closes ffmpeg's standard input and waits for it to finish the
+     * video. Called by the encoder thread that opened the pipe.
+     * \return bool Whether or not ffmpeg encoded the video
+     */
+    bool _closePipe();
+
+    friend class GripEncoderTask;
+
+    /// Frames waiting for an encoder, paired with their frame number
+    QQueue<QPair<int, QImage> > _queue;
+
+    /// Guards the queue and the counters
+    mutable QMutex _mutex;
+
+    /// Wakes the encoders when a frame is queued or the recording finishes
+    QWaitCondition _frameQueued;
+
+    /// Wakes the recorder when an encoder takes a frame off a full queue
+    QWaitCondition _frameTaken;
+
+    /// Encoder threads
+    QThreadPool* _pool;
+
+    /// Name of the video file, or of the frame files without the extension
+    QString _fileName;
+
+    /// Type of output of the current recording
+    encoderOutput_t _output;
+
+    /// Frame rate passed to ffmpeg
+    double _fps;
+
+    /// ffmpeg process reading the frames from its standard input, or NULL if it isn't running
+    QProcess* _process;
+
+    int _maxQueuedFrames;   ///< Capacity of the queue
+    int _numThreads;        ///< Number of encoder threads for numbered frames
+    int _numFramesQueued;   ///< Frame number of the next frame added
+    int _numFramesWritten;  ///< Number of frames written so far
+    int _numErrors;         ///< Number of frames that couldn't be written
+    bool _recording;        ///< Whether or not frames are accepted
+    bool _finishing;        ///< Whether or not the encoders should stop once the queue is empty
+};
+
+#endif // GRIP_VIDEO_ENCODER_H
@@ -51,13 +51,18 @@
 
 // Eigen includes
 #include <Eigen/Core>
+#include <Eigen/Cholesky>
 
 // DART includes
-#include <dynamics/Skeleton.h>
+#include <dart/dynamics/Skeleton.h>
 
 /**
  * \class HuboController HuboController.h
- * \brief Controller wrapper for Hubo position commands
+ * \brief Controller wrapper for Hubo position commands. Gains and the joint mask
+ * are the diagonals of the gain matrices. All the matrices and vectors the stable
+ * PD solve needs are allocated for the skeleton's number of DOFs up front, so a
+ * control tick doesn't allocate. Change the skeleton's DOFs and you need a new
+ * controller.
  */
 class HuboController {
 public:
@@ -94,21 +99,43 @@ public:
                                const Eigen::VectorXd &curVel,
                                double t);
 
+    /**
+     * \brief Gets the torques for the skeleton given desired positions and
+     * velocities for the joints, without allocating anything when "torques"
+     * already has one entry per DOF
+     * \param curPos Current position of the joints
+     * \param curVel Current velocity of the joints
+     * \param t Time
+     * \param torques Vector to put the joint torques in
+     * \return void
+     */
+    void getTorques(const Eigen::VectorXd &curPos,
+                    const Eigen::VectorXd &curVel,
+                    double t,
+                    Eigen::VectorXd &torques);
+
     Eigen::VectorXd refPos;
     Eigen::VectorXd refVel;
-    Eigen::MatrixXd Kp;
-    Eigen::MatrixXd Kd;
-    Eigen::MatrixXd Ki;
+    Eigen::VectorXd Kp; ///< Proportional gain of each DOF
+    Eigen::VectorXd Kd; ///< Derivative gain of each DOF
+    Eigen::VectorXd Ki; ///< Integral gain of each DOF
 
     Eigen::VectorXd errorLast;
     Eigen::VectorXd errorDeriv;
     Eigen::VectorXd errorInteg;
 
-    Eigen::MatrixXd jointMask;
+    Eigen::VectorXd jointMask; ///< 1 for each DOF that gets a torque, 0 otherwise
 
     double tLast;
 
     dart::dynamics::Skeleton* skel;
+
+protected:
+    Eigen::MatrixXd _M;                   ///< Mass matrix plus Kd * dt
+    Eigen::LDLT<Eigen::MatrixXd> _ldlt;   ///< Factorization of _M
+    Eigen::VectorXd _p;                   ///< Proportional term
+    Eigen::VectorXd _d;                   ///< Derivative term
+    Eigen::VectorXd _qddot;               ///< Predicted accelerations
 };
 
 #endif // HUBO_CONTROLLER_H
@@ -135,6 +135,11 @@ public slots:
      */
     virtual void slotPlaybackBeginning() = 0;
 
+    /**
+     * \brief Slot for the playback timer, steps the playback in its current direction
+     */
+    virtual void slotPlaybackTick() = 0;
+
     /**
      * \brief Pure virtual slot that saves a video of the current playback timeline
      */
@@ -216,6 +221,8 @@ protected:
         QAction *saveWorkspaceConfigurationAct;
         QAction *saveNewWorkspaceConfigurationAct;
         QAction *loadWorkspaceConfigurationAct;
+        QAction *saveTimelineAct;
+        QAction *loadTimelineAct;
         QAction *closeSceneAct;
         QAction *exitAct;
     QMenu *viewMenu;
@@ -226,6 +233,7 @@ protected:
         QAction *startSimulationAct;
         QAction *stopSimulationAct;
         QAction *simulateSingleStepAct;
+        QAction *recordTimelineAct;
     QMenu *settingsMenu;
         QAction *renderDuringSimulationAct;
         QMenu *backgroundMenu;
@@ -233,10 +241,15 @@ protected:
             QAction *grayAct;
             QAction *blackAct;
         QAction *resetCameraAct;
+        QAction *timelineRetentionAct;
+        QAction *maxFrameRateAct;
+        QAction *renderingThreadsAct;
+        QAction *saveProfileOnExitAct;
     QMenu *renderMenu;
         QAction *xga1024x768Act;
         QAction *vga640x480Act;
         QAction *hd1280x720Act;
+        QAction *exportVideoAct;
     QMenu *helpMenu;
         QAction *aboutAct;
 
@@ -365,6 +378,25 @@ protected slots:
      */
     virtual void resetCamera() = 0;
 
+    /**
+     * \brief Asks how much of the timeline to keep in memory and whether to spill
+     * the rest to disk
+     * \return void
+     */
+    virtual void setTimelineRetention() = 0;
+
+    /**
+     * \brief Asks for the maximum number of frames rendered per second
+     * \return void
+     */
+    virtual void setMaxFrameRate() = 0;
+
+    /**
+     * \brief Asks for the threading model of the viewer
+     * \return void
+     */
+    virtual void setRenderingThreads() = 0;
+
     virtual void xga1024x768() = 0;
 
     virtual void vga640x480() = 0;
@@ -383,12 +415,54 @@ protected slots:
      */
     virtual void film() = 0;
 
+    /**
+     * \brief Renders the playback timeline offline at a fixed frame rate of
+     * simulated time and writes it to a video file
+     * \return void
+     */
+    virtual void exportVideo() = 0;
+
+    /**
+     * \brief Saves the playback timeline to a timeline file chosen with a dialog
+     * \return void
+     */
+    virtual void saveTimeline() = 0;
+
+    /**
+     * \brief Loads a timeline file chosen with a dialog for playback
+     * \return void
+     */
+    virtual void loadTimeline() = 0;
+
+    /**
+     * \brief Starts or stops streaming the simulated time steps to a timeline file
+     * \param record Whether or not to record
+     * \return void
+     */
+    virtual void recordTimeline(bool record) = 0;
+
     /**
      * \brief Notifies thread that simulation has stopped
      * \return void
      */
     virtual void simulationStopped() = 0;
 
+    /**
+     * \brief Shows the progress of the scene being loaded in the status bar
+     * \param numDone Number of meshes and skeletons done
+     * \param numTotal Number of meshes and skeletons in the scene
+     * \param stage Description of what's being done
+     * \return void
+     */
+    virtual void sceneLoadProgress(int numDone, int numTotal, QString stage) = 0;
+
+    /**
+     * \brief Adds the scene that was loaded in the background to the world and the view
+     * \param success Whether or not the scene was parsed
+     * \return void
+     */
+    virtual void sceneLoaded(bool success) = 0;
+
     /**
      * \brief Sets the time box for simulation time relative to real time
      * \param time The simulation time relative to real time
@@ -396,6 +470,18 @@ protected slots:
      */
     virtual void setSimulationRelativeTime(double time) = 0;
 
+    /**
+     * \brief Sets the world to a state handed over by another thread, e.g. by GripInterface
+     * \return void
+     */
+    virtual void setWorldFromExternalState() = 0;
+
+    /**
+     * \brief Lets the window know something else moved the skeletons, e.g. GripInterface::step
+     * \return void
+     */
+    virtual void worldChangedExternally() = 0;
+
     /**
      * \brief Displays information about the application
      * \return void
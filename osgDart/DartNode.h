@@ -67,6 +67,10 @@
 // osgDart includes
 #include "SkeletonNode.h"
 #include "WorldVisuals.h"
+#include "WorldSnapshot.h"
+
+// Grip includes
+#include "GripProfiler.h"
 
 /**
  * \namespace osgDart
@@ -100,7 +104,7 @@ public:
     DartNode(bool debug=false);
 
     /**
-     * \brief Creates arrows for contact forces in the world during simulation
+     * \brief Updates the arrows for contact forces in the world during simulation
      * \return void
      */
     void _updateContactForces();
@@ -112,6 +116,29 @@ public:
      */
     void setContactForcesVisible(bool makeVisible);
 
+    /**
+     * \brief Sets the buffer the simulation publishes world snapshots into. While the
+     * buffer is live, update() draws the newest snapshot instead of reading the world,
+     * which is being stepped on the simulation thread. The DartNode doesn't take ownership.
+     * \param snapshotBuffer Snapshot buffer, or NULL to always read the world directly
+     * \return void
+     */
+    void setSnapshotBuffer(WorldSnapshotBuffer* snapshotBuffer);
+
+    /**
+     * \brief Gets the buffer the DartNode reads world snapshots from
+     * \return WorldSnapshotBuffer* Snapshot buffer, or NULL if there isn't one
+     */
+    WorldSnapshotBuffer* getSnapshotBuffer();
+
+    /**
+     * \brief Sets the profiler that update() is timed in, along with its SkeletonNode
+     * updates and contact forces. The DartNode doesn't take ownership.
+     * \param profiler Profiler to record in, or NULL to not time anything
+     * \return void
+     */
+    void setProfiler(GripProfiler* profiler);
+
     /**
      * \brief Create a dart::dynamics::Skeleton pointer from a skeleton urdf file
      * using DART's DartLoader.
@@ -184,6 +211,18 @@ public:
      */
     size_t addWorld(dart::simulation::World* world);
 
+    /**
+     * \brief Add a world to the DartNode using SkeletonNodes that were already built,
+     * for example on another thread while loading the scene.
+     * \param world The dart::simulation::World object that contains one or more
+     * dart::dynamics::Skeleton objects.
+     * \param skeletonNodes SkeletonNodes for the world's skeletons in the same order.
+     * Skeletons without one get a new SkeletonNode.
+     * \return Index of the last object added
+     */
+    size_t addWorld(dart::simulation::World* world,
+                    const std::vector<osg::ref_ptr<SkeletonNode> >& skeletonNodes);
+
     /**
      * \brief Get skeleton via index (size_t)
      * \param skeletonIndex Index of the skeleton you want
@@ -235,7 +274,11 @@ public:
 
     /**
      * \brief Updates the transforms of all the dart objects in the SkeletonNodes
-     * of the DartNode for the next culling and drawing events.
+     * of the DartNode for the next culling and drawing events. This runs in the
+     * update traversal, which a multi-threaded viewer overlaps with drawing the
+     * previous frame, so it only writes MatrixTransforms and DYNAMIC geometry.
+     * Render settings such as transparency and wireframe swap in new StateSets
+     * rather than changing the ones being drawn.
      * \return void
      */
     void update();
@@ -326,6 +369,13 @@ protected:
      */
     int skeletonIndexIsValid(size_t skeletonIndex);
 
+    /**
+     * \brief Updates the SkeletonNodes and contact forces from a world snapshot
+     * \param snapshot Snapshot to draw
+     * \return void
+     */
+    void _updateFromSnapshot(const WorldSnapshot& snapshot);
+
 
     //---------------------------------------------------------------
     //                       PROTECTED VARIABLES
@@ -343,8 +393,21 @@ protected:
     /// Map from dart::dynamics::Skeleton* to osg::SkeletonNode
     SkeletonNodeMap _skelNodeMap;
 
-    /// Array of osg::MatrixTransforms representing contactForces in the world
-    std::vector<osg::ref_ptr<osgDart::ContactForceVisual> > _contactForceArrows;
+    /// Node drawing all the contact forces in the world, attached once and hidden with its node mask
+    osg::ref_ptr<osgDart::ContactForcesVisual> _contactForcesVisual;
+
+    std::vector<Eigen::Vector3d> _contactPoints; ///< Contact points read from the world, reused every update
+    std::vector<Eigen::Vector3d> _contactForces; ///< Contact forces read from the world, reused every update
+
+    /// Buffer of world snapshots published by the simulation thread, or NULL
+    WorldSnapshotBuffer* _snapshotBuffer;
+
+    /// Profiler update() is timed in, or NULL
+    GripProfiler* _profiler;
+
+    size_t _phaseUpdate;        ///< Profiler phase of a whole update
+    size_t _phaseSkeletons;     ///< Profiler phase of the SkeletonNode updates
+    size_t _phaseContactForces; ///< Profiler phase of the contact forces update
 
     /// Debug variable for whether or not to print debug output
     bool _debug;
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file MeshCache.h
+ * \brief Process-wide cache of Assimp meshes converted to OpenSceneGraph nodes,
+ * so a mesh used by several shapes, skeletons or worlds is only converted and
+ * uploaded to the GPU once.
+ */
+
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+// Assimp includes
+#include <assimp/scene.h>
+
+// OpenSceneGraph includes
+#include <osg/Node>
+#include <osg/ref_ptr>
+
+// C++ Standard includes
+#include <map>
+#include <mutex>
+#include <stdint.h>
+
+namespace osgDart {
+
+/**
+ * \class MeshCache MeshCache.h
+ * \brief Cache of converted meshes keyed by a hash of the aiScene contents.
+ * Meshes are hashed instead of keyed by their aiScene pointer because DART
+ * loads a new aiScene for every MeshShape, even ones using the same file, and
+ * because a freed aiScene's address can be reused by a different mesh.
+ *
+ * The cached nodes are shared between every shape using the mesh, so per shape
+ * state, like the wireframe mode, has to be set on a parent node instead.
+ * All functions are thread safe.
+ */
+class MeshCache
+{
+public:
+
+    /**
+     * \brief Gets the OpenSceneGraph node for an Assimp scene, converting it with
+     * osgAssimpSceneReader the first time the mesh is seen.
+     * \param aiscene Assimp scene to convert
+     * \return osg::Node* Node shared with every other user of the mesh, or NULL if
+     * the scene has no root node
+     */
+    static osg::Node* getNode(const aiScene* aiscene);
+
+    /**
+     * \brief Removes the meshes that aren't used by any scene graph anymore
+     * \return size_t Number of meshes removed
+     */
+    static size_t releaseUnused();
+
+    /**
+     * \brief Removes all meshes from the cache. Nodes still in a scene graph stay valid.
+     * \return void
+     */
+    static void clear();
+
+    /**
+     * \brief Gets the number of meshes in the cache
+     * \return size_t Number of meshes
+     */
+    static size_t size();
+
+    /**
+     * \brief Gets the number of times a mesh was found in the cache
+     * \return size_t Number of hits
+     */
+    static size_t getNumHits();
+
+    /**
+     * \brief Gets the number of times a mesh had to be converted
+     * \return size_t Number of misses
+     */
+    static size_t getNumMisses();
+
+    /**
+     * \brief Hashes everything in an Assimp scene that ends up in the converted node:
+     * the node hierarchy and transforms, the mesh vertices, normals, colors, texture
+     * coordinates and faces, and the materials.
+     * \param aiscene Assimp scene to hash
+     * \return uint64_t 64 bit FNV-1a hash of the scene
+     */
+    static uint64_t hashScene(const aiScene* aiscene);
+
+protected:
+
+    /// Definition of type MeshMap, which maps scene hashes to converted nodes
+    typedef std::map<uint64_t, osg::ref_ptr<osg::Node> > MeshMap;
+
+    /**
+     * \brief Adds a node and all its children to the hash
+     * \param hash Hash to add to
+     * \param ainode Assimp node to add
+     * \return void
+     */
+    static void _hashNode(uint64_t& hash, const aiNode* ainode);
+
+    /**
+     * \brief Adds bytes to the hash
+     * \param hash Hash to add to
+     * \param data Bytes to add
+     * \param numBytes Number of bytes
+     * \return void
+     */
+    static void _hashBytes(uint64_t& hash, const void* data, size_t numBytes);
+
+    static MeshMap _meshes; ///< Converted meshes
+    static std::mutex _mutex; ///< Guards everything in the cache
+    static size_t _numHits; ///< Number of cache hits
+    static size_t _numMisses; ///< Number of cache misses
+
+}; // end class MeshCache
+
+} // end namespace osgDart
+
+#endif // MESHCACHE_H
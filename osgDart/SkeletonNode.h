@@ -77,6 +77,21 @@ typedef std::map<const dart::dynamics::BodyNode*, osg::ref_ptr<osg::Group> > Bod
 /// Definition of type BodyNodeGroupMap, which maps dart::dynamics::BodyNode* to osg::Group*
 typedef std::map<const dart::dynamics::BodyNode*, osg::ref_ptr<osgDart::BodyNodeVisuals> > BodyNodeVisualsMap;
 
+/**
+ * \struct BodyNodeTransform SkeletonNode.h
+ * \brief Scene graph nodes that follow a BodyNode's world transform. The pointers are
+ * owned by the SkeletonNode's maps.
+ */
+struct BodyNodeTransform {
+    const dart::dynamics::BodyNode* bodyNode; ///< BodyNode the nodes follow
+    size_t skeletonIndex; ///< Index of the BodyNode in its skeleton, and of its transform in a WorldSnapshot
+    osg::MatrixTransform* matrix; ///< Transform of the BodyNode's visualization and collision shapes
+    osgDart::BodyNodeVisuals* visuals; ///< Transform of the BodyNode's axes and joint axis
+};
+
+/// Definition of type BodyNodeTransformArray, a flat array of BodyNodeTransform objects
+typedef std::vector<BodyNodeTransform> BodyNodeTransformArray;
+
 /**
  * \enum renderMode_t
  * \brief Render options for the skeleton
@@ -115,11 +130,23 @@ public:
 
     /**
      * \brief Update SkeletonNode MatrixTransforms based on the dart::Skeleton BodyNode world transforms.
-     * This is done recursively by traversing through the Skeleton bodyNodes and their children.
+     * This walks a flat array of the BodyNodes in parent-before-child order built when the
+     * SkeletonNode was created, converting each world transform once. The MatrixTransforms
+     * have DYNAMIC data variance since they change every frame.
      * \return void
      */
     void update();
 
+    /**
+     * \brief Update SkeletonNode MatrixTransforms from transforms captured in a WorldSnapshot
+     * instead of reading them from the live skeleton, which may be getting simulated on another thread.
+     * \param transforms BodyNode world transforms in dart::dynamics::Skeleton::getBodyNode(i) order
+     * \param numTransforms Number of transforms. Skipped if it doesn't match the skeleton
+     * \param com World center of mass of the skeleton
+     * \return void
+     */
+    void update(const Eigen::Isometry3d* transforms, size_t numTransforms, const Eigen::Vector3d& com);
+
     /**
      * \brief Shows or hides the individual joint axes. This applies to skeletons with more than one
      * link. A single line with an arrow is displayed representing the axis of rotation of the joint.
@@ -258,13 +285,12 @@ protected:
     void _addCollisionShapesFromBodyNode(const dart::dynamics::BodyNode& node);
 
     /**
-     * \brief Update SkeletonNode recursively based on Skeleton transforms. This traverses through each
-     * BodyNode and its child BodyNodes and updates corresponding osg::MatrixTransform based on their
-     * current world transform.
-     * \param bodyNode BodyNode used to update the osg::MatrixTransform and its children
+     * \brief Builds _bodyNodeTransforms, the flat parent-before-child array of the skeleton's
+     * BodyNodes and their MatrixTransforms, from the maps filled in while creating the skeleton
+     * \param skeleton Skeleton the SkeletonNode was created from
      * \return void
      */
-    void _updateRecursively(const dart::dynamics::BodyNode& bodyNode);
+    void _flattenBodyNodes(const dart::dynamics::Skeleton& skeleton);
 
     /**
      * \brief Updates the skeleton visuals
@@ -272,6 +298,13 @@ protected:
      */
     void _updateSkeletonVisuals();
 
+    /**
+     * \brief Moves the center of mass visuals to the given center of mass
+     * \param com World center of mass of the skeleton
+     * \return void
+     */
+    void _updateSkeletonVisuals(const Eigen::Vector3d& com);
+
     //---------------------------------------------------------------
     //                    PROTECTED VARIABLES
     //---------------------------------------------------------------
@@ -303,6 +336,9 @@ protected:
     /// Map from dart::dynamics::BodyNode* to osgDart::BodyNodeVisuals for BodyNode visual shapes
     BodyNodeVisualsMap _bodyNodeVisualsMap;
 
+    /// BodyNodes and their transforms in parent-before-child order, for updating without map lookups
+    BodyNodeTransformArray _bodyNodeTransforms;
+
     /// Debug variable for whether or not to print debug output
     const bool _debug;
 
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file WorldSnapshot.h
+ * \brief Classes for handing the pose of a dart::simulation::World from the
+ * simulation thread to the rendering thread. The simulation thread publishes
+ * a WorldSnapshot after every time step into a WorldSnapshotBuffer, and the
+ * OpenSceneGraph update traversal reads the newest complete one, so neither
+ * thread ever waits on the other and the rendered frame is never torn.
+ */
+
+#ifndef WORLDSNAPSHOT_H
+#define WORLDSNAPSHOT_H
+
+// DART includes
+#include <dart/simulation/World.h>
+#include <dart/dynamics/Skeleton.h>
+
+// Eigen includes
+#include <Eigen/Geometry>
+#include <Eigen/StdVector>
+
+// C++ Standard includes
+#include <atomic>
+#include <vector>
+
+namespace osgDart {
+
+/// Array of BodyNode world transforms. Needs Eigen's allocator since Isometry3d is vectorizable
+typedef std::vector<Eigen::Isometry3d, Eigen::aligned_allocator<Eigen::Isometry3d> > TransformArray;
+
+/**
+ * \class WorldSnapshot WorldSnapshot.h
+ * \brief Copy of everything the renderer needs from a world at one instant:
+ * the world transform of every BodyNode, the center of mass of every Skeleton
+ * and the contact points and forces. BodyNode transforms are stored skeleton by
+ * skeleton in the order of dart::dynamics::Skeleton::getBodyNode(i).
+ */
+class WorldSnapshot
+{
+public:
+
+    /**
+     * \brief Constructor for WorldSnapshot
+     */
+    WorldSnapshot();
+
+    /**
+     * \brief Copies the current pose of the world into the snapshot. Storage is
+     * reused, so once the snapshot has grown to fit the world this doesn't allocate.
+     * \param world World to copy the pose of
+     * \param captureContacts Whether or not to copy the contact points and forces
+     * \return void
+     */
+    void capture(dart::simulation::World& world, bool captureContacts=true);
+
+    /**
+     * \brief Gets the simulation time the snapshot was taken at
+     * \return double Simulation time in seconds
+     */
+    double getTime() const;
+
+    /**
+     * \brief Gets the sequence number of the snapshot. Sequence numbers start at 1
+     * and increase with every published snapshot. 0 means nothing was captured.
+     * \return size_t Sequence number
+     */
+    size_t getSequence() const;
+
+    /**
+     * \brief Gets the number of skeletons in the snapshot
+     * \return size_t Number of skeletons
+     */
+    size_t getNumSkeletons() const;
+
+    /**
+     * \brief Gets the skeleton the transforms at the given index belong to. Only used
+     * to match the snapshot up with the scene graph, never dereferenced by the renderer.
+     * \param skeletonIndex Index of the skeleton in the world
+     * \return const dart::dynamics::Skeleton* Skeleton pointer
+     */
+    const dart::dynamics::Skeleton* getSkeleton(size_t skeletonIndex) const;
+
+    /**
+     * \brief Gets the number of BodyNodes captured for a skeleton
+     * \param skeletonIndex Index of the skeleton in the world
+     * \return size_t Number of BodyNodes
+     */
+    size_t getNumBodyNodes(size_t skeletonIndex) const;
+
+    /**
+     * \brief Gets the world transforms of a skeleton's BodyNodes
+     * \param skeletonIndex Index of the skeleton in the world
+     * \return const Eigen::Isometry3d* Pointer to getNumBodyNodes(skeletonIndex) transforms
+     */
+    const Eigen::Isometry3d* getBodyNodeTransforms(size_t skeletonIndex) const;
+
+    /**
+     * \brief Gets the world center of mass of a skeleton
+     * \param skeletonIndex Index of the skeleton in the world
+     * \return const Eigen::Vector3d& Center of mass
+     */
+    const Eigen::Vector3d& getSkeletonCOM(size_t skeletonIndex) const;
+
+    /**
+     * \brief Gets the contact points of the world
+     * \return const std::vector<Eigen::Vector3d>& Contact points
+     */
+    const std::vector<Eigen::Vector3d>& getContactPoints() const;
+
+    /**
+     * \brief Gets the contact forces of the world, one for each contact point
+     * \return const std::vector<Eigen::Vector3d>& Contact forces
+     */
+    const std::vector<Eigen::Vector3d>& getContactForces() const;
+
+protected:
+
+    friend class WorldSnapshotBuffer;
+
+    double _time; ///< Simulation time of the snapshot
+    size_t _sequence; ///< Sequence number of the snapshot. 0 if empty
+    size_t _generation; ///< Generation of the buffer when the snapshot was published
+
+    /// Skeletons in world order
+    std::vector<const dart::dynamics::Skeleton*> _skeletons;
+
+    /// Offset of each skeleton's first transform in _transforms, plus one past the end
+    std::vector<size_t> _offsets;
+
+    /// World transforms of all the BodyNodes
+    TransformArray _transforms;
+
+    /// World center of mass of each skeleton
+    std::vector<Eigen::Vector3d> _coms;
+
+    std::vector<Eigen::Vector3d> _contactPoints; ///< Contact points
+    std::vector<Eigen::Vector3d> _contactForces; ///< Contact forces
+
+}; // end class WorldSnapshot
+
+/**
+ * \class WorldSnapshotBuffer WorldSnapshot.h
+ * \brief Lock-free triple buffer of WorldSnapshot objects with exactly one writer
+ * (the simulation thread) and one reader (the rendering thread). The writer
+ * always has a back snapshot to fill and the reader a front snapshot to draw,
+ * and the third one holds the newest published snapshot. Publishing and
+ * acquiring are a single atomic exchange each.
+ *
+ * The buffer is "live" while a simulation is running. When it isn't, nothing
+ * is mutating the world from another thread and the renderer can read the
+ * world directly, which also picks up kinematic changes made in the GUI.
+ */
+class WorldSnapshotBuffer
+{
+public:
+
+    /**
+     * \brief Constructor for WorldSnapshotBuffer
+     * \param captureContacts Whether or not published snapshots include contacts
+     */
+    WorldSnapshotBuffer(bool captureContacts=true);
+
+    /**
+     * \brief Captures the world into the back snapshot and makes it the newest
+     * one. Must only be called from one thread at a time.
+     * \param world World to capture
+     * \return void
+     */
+    void publish(dart::simulation::World& world);
+
+    /**
+     * \brief Gets the newest published snapshot. The returned snapshot belongs to
+     * the reader and stays valid until the next call to acquire(). Must only be
+     * called from one thread at a time.
+     * \return const WorldSnapshot* Newest snapshot, or NULL if none has been
+     * published since the buffer last went live
+     */
+    const WorldSnapshot* acquire();
+
+    /**
+     * \brief Marks the buffer as live or not. Going live discards the snapshots of
+     * the previous run so stale poses are never drawn.
+     * \param live Whether or not a simulation is publishing into the buffer
+     * \return void
+     */
+    void setLive(bool live);
+
+    /**
+     * \brief Whether or not a simulation is publishing into the buffer
+     * \return bool True if live
+     */
+    bool isLive() const;
+
+    /**
+     * \brief Sets whether or not published snapshots include contacts
+     * \param captureContacts Whether or not to capture contacts
+     * \return void
+     */
+    void setCaptureContacts(bool captureContacts);
+
+protected:
+
+    /// Flag set in _ready when the snapshot it points to hasn't been acquired yet
+    static const int FRESH = 4;
+
+    /// Mask for getting the snapshot index out of _ready
+    static const int INDEX_MASK = 3;
+
+    /// The three snapshots
+    WorldSnapshot _snapshots[3];
+
+    /// Index of the newest published snapshot, or'd with FRESH if it's unread
+    std::atomic<int> _ready;
+
+    int _back; ///< Index of the snapshot the writer fills. Only touched by the writer
+    int _front; ///< Index of the snapshot the reader holds. Only touched by the reader
+
+    size_t _sequence; ///< Sequence number of the last published snapshot. Only touched by the writer
+
+    std::atomic<size_t> _generation; ///< Incremented every time the buffer goes live
+    std::atomic<bool> _live; ///< Whether or not a simulation is publishing
+    std::atomic<bool> _captureContacts; ///< Whether or not to capture contacts
+
+}; // end class WorldSnapshotBuffer
+
+} // end namespace osgDart
+
+#endif // WORLDSNAPSHOT_H
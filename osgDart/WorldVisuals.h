@@ -58,11 +58,17 @@
 
 // OpenSceneGraph includes
 #include <osg/MatrixTransform>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/LineWidth>
 
 // Eigen includes
 #include <Eigen/Core>
 #include <Eigen/Dense>
 
+// C++ Standard includes
+#include <vector>
+
 namespace osgDart {
 
 /**
@@ -122,6 +128,87 @@ protected:
 
 }; // end class ContactForceVisual
 
+/**
+ * \class ContactForcesVisual WorldVisuals.h
+ * \brief Class that draws the force vectors of all the contacts in the world as
+ * one batched geometry. Every contact is a line plus an arrowhead triangle in a
+ * shared vertex array that is updated in place, so the number of nodes and draw
+ * calls stays the same no matter how many contacts there are. The vertex array
+ * only grows, doubling when it runs out of room.
+ */
+class ContactForcesVisual : public osg::Geode
+{
+public:
+    /**
+     * \brief Constructs a ContactForcesVisual object
+     * \param debug Whether or not to print debug output
+     */
+    ContactForcesVisual(bool debug=false);
+
+    /**
+     * \brief Destructs the ContactForcesVisual object
+     */
+    ~ContactForcesVisual();
+
+    /**
+     * \brief Updates the force vectors to the given contacts. The longest force vector is
+     * drawn with unit length and the others are scaled relative to it.
+     * \param contactPoints Contact points
+     * \param contactForces Contact forces, one for each contact point
+     * \return void
+     */
+    void update(const std::vector<Eigen::Vector3d>& contactPoints,
+                const std::vector<Eigen::Vector3d>& contactForces);
+
+    /**
+     * \brief Gets the number of force vectors currently drawn
+     * \return size_t Number of force vectors
+     */
+    size_t getNumContacts() const;
+
+    /**
+     * \brief Sets the color of all the force vectors
+     * \param color Color in rgba format in range (0,1)
+     * \return void
+     */
+    void setColor(const osg::Vec4& color);
+
+protected:
+
+    /**
+     * \brief Makes sure the vertex array has room for the given number of contacts,
+     * doubling its capacity as needed
+     * \param numContacts Number of contacts to make room for
+     * \return void
+     */
+    void _reserve(size_t numContacts);
+
+    /// Geometry holding the lines and arrowheads of every force vector
+    osg::ref_ptr<osg::Geometry> _geometry;
+
+    /// Vertices. The lines of all the contacts come first, then the arrowheads
+    osg::ref_ptr<osg::Vec3Array> _verts;
+
+    /// Color of the force vectors. Only holds one color
+    osg::ref_ptr<osg::Vec4Array> _color;
+
+    /// Draws the lines, two vertices per contact
+    osg::ref_ptr<osg::DrawArrays> _lines;
+
+    /// Draws the arrowheads, three vertices per contact
+    osg::ref_ptr<osg::DrawArrays> _arrowheads;
+
+    /// Number of contacts the vertex array has room for
+    size_t _capacity;
+
+    /// Number of force vectors currently drawn
+    size_t _numContacts;
+
+    /// Whether or not to print out debug statements
+    bool _debug;
+
+}; // end class ContactForcesVisual
+
 } // end namespace osgDart
 
 #endif // WORLD_VISUALS_H
@@ -68,10 +68,11 @@ osg::Node* convertShapeToOsgNode(dart::dynamics::Shape* inputShape);
 /**
  * \brief Convert dart::dynamics::MeshShape to an osgNode.
  * DART MeshShapes are stored as Assimp scenes and these get converted
- * to an osg::Node*.
+ * to an osg::Node*. The converted mesh comes from the MeshCache and is
+ * shared with other shapes using the same mesh.
  * \param inputMesh A dart::dynamics::MeshShape or dart::dynamics::Shape
  * that is actually a MeshShape.
- * \return osg::MatrixTransform as an osg::Node pointer
+ * \return osg::Group holding the shared mesh node, as an osg::Node pointer
  */
 osg::Node* convertMeshToOsgNode(dart::dynamics::Shape* mesh);
 
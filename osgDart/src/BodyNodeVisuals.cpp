@@ -52,6 +52,9 @@ BodyNodeVisuals::BodyNodeVisuals() :
 {
     _cullFace = new osg::CullFace(osg::CullFace::BACK);
     _lineWidth = new osg::LineWidth(3.0);
+
+    // Follows its BodyNode every frame
+    this->setDataVariance(osg::Object::DYNAMIC);
 }
 
 BodyNodeVisuals::~BodyNodeVisuals()
@@ -63,34 +63,82 @@ using namespace osgDart;
 
 DartNode::DartNode(bool debug)
     : _world(0),
+      _snapshotBuffer(NULL),
+      _profiler(NULL),
+      _phaseUpdate(0),
+      _phaseSkeletons(0),
+      _phaseContactForces(0),
       _debug(debug),
       _showContactForces(0)
 {
     this->setUpdateCallback(new DartNodeCallback);
+
+    // All contact forces are drawn by one node that stays attached
+    _contactForcesVisual = new ContactForcesVisual(_debug);
+    _contactForcesVisual->setNodeMask(0x0);
+    this->addChild(_contactForcesVisual);
 }
 
 void DartNode::update()
 {
-    SkeletonNodeMap::const_iterator it;
-    for (int i=0; i<_world->getNumSkeletons(); ++i) {
-        it = _skelNodeMap.find(_world->getSkeleton(i));
-        if (it != _skelNodeMap.end()) {
-            _skelNodeMap.at(_world->getSkeleton(i))->update();
-        } else {
-            _skeletons.push_back(_world->getSkeleton(i));
-            osgDart::SkeletonNode* skelNode = new osgDart::SkeletonNode(*_world->getSkeleton(i), _debug);
-            _skeletonNodes.push_back(skelNode);
-            _skelNodeMap.insert(std::make_pair(_world->getSkeleton(i), skelNode));
-            this->addChild(skelNode);
+    GripScopedTimer updateTimer(_profiler, _phaseUpdate);
+
+    // While a simulation is running on another thread the world can't be read
+    // safely, so only draw complete snapshots published by the simulation
+    if (_snapshotBuffer && _snapshotBuffer->isLive()) {
+        const WorldSnapshot* snapshot = _snapshotBuffer->acquire();
+        if (snapshot) {
+            _updateFromSnapshot(*snapshot);
+        }
+        return;
+    }
+
+    {
+        GripScopedTimer timer(_profiler, _phaseSkeletons);
+        SkeletonNodeMap::const_iterator it;
+        for (int i=0; i<_world->getNumSkeletons(); ++i) {
+            it = _skelNodeMap.find(_world->getSkeleton(i));
+            if (it != _skelNodeMap.end()) {
+                _skelNodeMap.at(_world->getSkeleton(i))->update();
+            } else {
+                _skeletons.push_back(_world->getSkeleton(i));
+                osgDart::SkeletonNode* skelNode = new osgDart::SkeletonNode(*_world->getSkeleton(i), _debug);
+                _skeletonNodes.push_back(skelNode);
+                _skelNodeMap.insert(std::make_pair(_world->getSkeleton(i), skelNode));
+                this->addChild(skelNode);
+            }
         }
     }
 
     // Update contact forces
     if (_showContactForces) {
+        GripScopedTimer timer(_profiler, _phaseContactForces);
         _updateContactForces();
     }
 }
 
+void DartNode::_updateFromSnapshot(const WorldSnapshot& snapshot)
+{
+    // Skeletons without a SkeletonNode yet are picked up once the simulation stops,
+    // since building one reads the live skeleton
+    {
+        GripScopedTimer timer(_profiler, _phaseSkeletons);
+        SkeletonNodeMap::const_iterator it;
+        for (size_t i=0; i<snapshot.getNumSkeletons(); ++i) {
+            it = _skelNodeMap.find(snapshot.getSkeleton(i));
+            if (it != _skelNodeMap.end()) {
+                it->second->update(snapshot.getBodyNodeTransforms(i), snapshot.getNumBodyNodes(i),
+                                   snapshot.getSkeletonCOM(i));
+            }
+        }
+    }
+
+    if (_showContactForces) {
+        GripScopedTimer timer(_profiler, _phaseContactForces);
+        _contactForcesVisual->update(snapshot.getContactPoints(), snapshot.getContactForces());
+    }
+}
+
 void DartNode::_updateContactForces()
 {
     // FIXME this should be updated based on the selected node in the Qt treeview
@@ -99,28 +147,17 @@ void DartNode::_updateContactForces()
     // If we have a world and contraint handler, get all the contact forces and create OpenSceneGraph
     // vector to represent them
     if (_world && _world->getConstraintHandler()) {
-        size_t numContacts = _world->getConstraintHandler()->getCollisionDetector()->getNumContacts();
-        std::vector<Eigen::Vector3d> contactPoints(numContacts);
-        std::vector<Eigen::Vector3d> contactForces(numContacts);
-        std::vector<float> forceVectorLengths(numContacts);
-        std::vector<bool> nodeIsSelected(numContacts);
-        float maxForceVectorLength = 0;
+        dart::collision::CollisionDetector* detector = _world->getConstraintHandler()->getCollisionDetector();
+        size_t numContacts = detector->getNumContacts();
+        _contactPoints.resize(numContacts);
+        _contactForces.resize(numContacts);
 
         // Extract contact force from world
         for (size_t i = 0; i < numContacts; ++i) {
-            dart::collision::Contact contact = _world->getConstraintHandler()->getCollisionDetector()->getContact(i);
-
-            contactPoints[i] = contact.point;
-            contactForces[i] = contact.force/*.normalized() * .1 * log(contact.force.norm()*//*)*/;
-            forceVectorLengths[i] = (contactForces[i] - contactPoints[i]).norm();
-            if (forceVectorLengths[i] != forceVectorLengths[i]) {
-                forceVectorLengths[i] = 0;
-            }
+            const dart::collision::Contact& contact = detector->getContact(i);
 
-            // Update max force vector length variable if current force vector length is larger than max
-            if (forceVectorLengths[i] > maxForceVectorLength) {
-                maxForceVectorLength = forceVectorLengths[i];
-            }
+            _contactPoints[i] = contact.point;
+            _contactForces[i] = contact.force/*.normalized() * .1 * log(contact.force.norm()*//*)*/;
 //            nodeIsSelected[i] = false;
 //            // If either of the BodyNodes in contact are the user-selected node, mark it
 //            if (contact.collisionNode1->getBodyNode() == selectedNode
@@ -129,57 +166,40 @@ void DartNode::_updateContactForces()
 //            }
         }
 
-        // Create force arrows to render
-        for (size_t i = 0; i < numContacts; ++i) {
-            ContactForceVisual* contactForceLine;
-            // If we have some, use existing contactForceArrows and update them to the
-            // current contact force values
-            if (_contactForceArrows.size() > i) {
-                contactForceLine = _contactForceArrows[i];
-                contactForceLine->update(forceVectorLengths[i]/maxForceVectorLength, contactPoints[i], contactForces[i]);
-            // Otherwise create a new one and add it to the existing ones
-            } else {
-                contactForceLine = new ContactForceVisual(_debug);
-                float forceMagnitude = 0;
-                if (fabs(maxForceVectorLength) < 1e-3 || fabs(forceVectorLengths[i]) < 1e-3) {
-                    forceMagnitude = 0;
-                } else {
-                    forceMagnitude = forceVectorLengths[i] / maxForceVectorLength;
-                }
-                contactForceLine->createForceVector(forceMagnitude, contactPoints[i], contactForces[i]);
-                _contactForceArrows.push_back(contactForceLine);
-            }
-            this->addChild(contactForceLine);
-        }
-
-        // Hide unused contact force arrows
-        for (size_t i = numContacts; i < _contactForceArrows.size(); ++i) {
-            _contactForceArrows[i]->setNodeMask(0x0);
-        }
-    } else {
-//        delete selectedNode;
-        return;
+        _contactForcesVisual->update(_contactPoints, _contactForces);
     }
-//    delete selectedNode;
 }
 
 void DartNode::setContactForcesVisible(bool makeVisible)
 {
     if(_debug) {
-        std::cerr << "[DartNode] " << (makeVisible ? "Showing " : "Hiding ") << "contact forces" << std::endl;
-    }
-    if (_world && _world->getConstraintHandler()) {
-        size_t numContacts = _world->getConstraintHandler()->getCollisionDetector()->getNumContacts();
-        if(_debug) {
-            std::cerr << "Number of contact forces: " << numContacts << std::endl;
-        }
-        for(size_t i = 0; i < numContacts && i < _contactForceArrows.size(); ++i) {
-            _contactForceArrows[i]->setNodeMask(makeVisible ? 0xffffffff : 0x0);
-        }
+        std::cerr << "[DartNode] " << (makeVisible ? "Showing " : "Hiding ") << "contact forces"
+                  << ", currently " << _contactForcesVisual->getNumContacts() << std::endl;
     }
+    _contactForcesVisual->setNodeMask(makeVisible ? 0xffffffff : 0x0);
     _showContactForces = makeVisible;
 }
 
+void DartNode::setSnapshotBuffer(WorldSnapshotBuffer* snapshotBuffer)
+{
+    _snapshotBuffer = snapshotBuffer;
+}
+
+WorldSnapshotBuffer* DartNode::getSnapshotBuffer()
+{
+    return _snapshotBuffer;
+}
+
+void DartNode::setProfiler(GripProfiler* profiler)
+{
+    _profiler = profiler;
+    if (_profiler) {
+        _phaseUpdate = _profiler->addPhase("render: scene update");
+        _phaseSkeletons = _profiler->addPhase("render: skeleton nodes");
+        _phaseContactForces = _profiler->addPhase("render: contact forces");
+    }
+}
+
 void DartNode::setJointAxesVisible(bool makeVisible)
 {
     if (_debug) {
@@ -464,9 +484,12 @@ void DartNode::reset()
         _skeletons.clear();
         _skeletonNodes.clear();
         _skelNodeMap.clear();
-        _contactForceArrows.clear();
     }
     assert(this->getNumChildren() == 0);
+
+    // Keep the contact force node, just with nothing to draw
+    _contactForcesVisual->update(std::vector<Eigen::Vector3d>(), std::vector<Eigen::Vector3d>());
+    this->addChild(_contactForcesVisual);
 }
 
 void DartNode::hideSkeleton(int i)
@@ -534,6 +557,12 @@ size_t DartNode::getNumSkeletons()
 }
 
 size_t DartNode::addWorld(dart::simulation::World* world)
+{
+    return addWorld(world, std::vector<osg::ref_ptr<SkeletonNode> >());
+}
+
+size_t DartNode::addWorld(dart::simulation::World* world,
+                          const std::vector<osg::ref_ptr<SkeletonNode> >& skeletonNodes)
 {
     if (!_world) {
         _world = world;
@@ -554,10 +583,16 @@ size_t DartNode::addWorld(dart::simulation::World* world)
         if (_debug) {
             std::cerr << "    " << world->getSkeleton(i)->getName() << std::endl;
         }
-        osgDart::SkeletonNode* skelNode = new osgDart::SkeletonNode(*world->getSkeleton(i), _debug);
+        // Use the prebuilt SkeletonNode if there is one, otherwise build it here
+        osg::ref_ptr<osgDart::SkeletonNode> skelNode;
+        if ((size_t)i < skeletonNodes.size() && skeletonNodes[i].valid()) {
+            skelNode = skeletonNodes[i];
+        } else {
+            skelNode = new osgDart::SkeletonNode(*world->getSkeleton(i), _debug);
+        }
         _skeletonNodes.push_back(skelNode);
         _skelNodeMap.insert(std::make_pair(world->getSkeleton(i), skelNode));
-        this->addChild(skelNode);
+        this->addChild(skelNode.get());
     }
 
     return _skeletons.size()-1;
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Local includes
+#include "MeshCache.h"
+#include "osgAssimpSceneReader.h"
+
+using namespace osgDart;
+
+MeshCache::MeshMap MeshCache::_meshes;
+std::mutex MeshCache::_mutex;
+size_t MeshCache::_numHits = 0;
+size_t MeshCache::_numMisses = 0;
+
+osg::Node* MeshCache::getNode(const aiScene* aiscene)
+{
+    if (!aiscene || !aiscene->mRootNode) {
+        return NULL;
+    }
+
+    uint64_t hash = hashScene(aiscene);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        MeshMap::const_iterator it = _meshes.find(hash);
+        if (it != _meshes.end()) {
+            ++_numHits;
+            return it->second.get();
+        }
+    }
+
+    // Convert without holding the lock so other meshes can be converted at the same time.
+    // If another thread converted the same mesh in the meantime, use theirs
+    osg::ref_ptr<osg::Node> node = osgAssimpSceneReader::traverseAIScene(aiscene, aiscene->mRootNode);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_numMisses;
+    std::pair<MeshMap::iterator, bool> inserted = _meshes.insert(std::make_pair(hash, node));
+    return inserted.first->second.get();
+}
+
+size_t MeshCache::releaseUnused()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t numRemoved = 0;
+    MeshMap::iterator it = _meshes.begin();
+    while (it != _meshes.end()) {
+        // The cache's reference is the only one left
+        if (it->second->referenceCount() <= 1) {
+            _meshes.erase(it++);
+            ++numRemoved;
+        } else {
+            ++it;
+        }
+    }
+    return numRemoved;
+}
+
+void MeshCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _meshes.clear();
+}
+
+size_t MeshCache::size()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _meshes.size();
+}
+
+size_t MeshCache::getNumHits()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numHits;
+}
+
+size_t MeshCache::getNumMisses()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numMisses;
+}
+
+uint64_t MeshCache::hashScene(const aiScene* aiscene)
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    _hashBytes(hash, &aiscene->mNumMeshes, sizeof(aiscene->mNumMeshes));
+    for (unsigned int m=0; m<aiscene->mNumMeshes; ++m) {
+        const aiMesh* mesh = aiscene->mMeshes[m];
+        _hashBytes(hash, &mesh->mNumVertices, sizeof(mesh->mNumVertices));
+        _hashBytes(hash, &mesh->mMaterialIndex, sizeof(mesh->mMaterialIndex));
+        _hashBytes(hash, mesh->mVertices, mesh->mNumVertices * sizeof(aiVector3D));
+        if (mesh->mNormals) {
+            _hashBytes(hash, mesh->mNormals, mesh->mNumVertices * sizeof(aiVector3D));
+        }
+        if (mesh->mColors[0]) {
+            _hashBytes(hash, mesh->mColors[0], mesh->mNumVertices * sizeof(aiColor4D));
+        }
+        if (mesh->mTextureCoords[0]) {
+            _hashBytes(hash, mesh->mTextureCoords[0], mesh->mNumVertices * sizeof(aiVector3D));
+        }
+        _hashBytes(hash, &mesh->mNumFaces, sizeof(mesh->mNumFaces));
+        for (unsigned int f=0; f<mesh->mNumFaces; ++f) {
+            const aiFace& face = mesh->mFaces[f];
+            _hashBytes(hash, face.mIndices, face.mNumIndices * sizeof(unsigned int));
+        }
+    }
+
+    _hashBytes(hash, &aiscene->mNumMaterials, sizeof(aiscene->mNumMaterials));
+    for (unsigned int m=0; m<aiscene->mNumMaterials; ++m) {
+        const aiMaterial* material = aiscene->mMaterials[m];
+        for (unsigned int p=0; p<material->mNumProperties; ++p) {
+            const aiMaterialProperty* property = material->mProperties[p];
+            _hashBytes(hash, property->mKey.data, property->mKey.length);
+            _hashBytes(hash, property->mData, property->mDataLength);
+        }
+    }
+
+    _hashNode(hash, aiscene->mRootNode);
+    return hash;
+}
+
+void MeshCache::_hashNode(uint64_t& hash, const aiNode* ainode)
+{
+    if (!ainode) {
+        return;
+    }
+
+    _hashBytes(hash, &ainode->mTransformation, sizeof(aiMatrix4x4));
+    _hashBytes(hash, &ainode->mNumMeshes, sizeof(ainode->mNumMeshes));
+    _hashBytes(hash, ainode->mMeshes, ainode->mNumMeshes * sizeof(unsigned int));
+    _hashBytes(hash, &ainode->mNumChildren, sizeof(ainode->mNumChildren));
+    for (unsigned int n=0; n<ainode->mNumChildren; ++n) {
+        _hashNode(hash, ainode->mChildren[n]);
+    }
+}
+
+void MeshCache::_hashBytes(uint64_t& hash, const void* data, size_t numBytes)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i=0; i<numBytes; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
@@ -74,6 +74,8 @@ SkeletonNode::SkeletonNode(const dart::dynamics::Skeleton &skeleton, bool debug)
     this->setName(_rootBodyNode.getSkeleton()->getName());
     _createSkeleton();
 
+    _flattenBodyNodes(skeleton);
+
     osg::Material* mat = (osg::Material*)_bodyNodeGroupMap.at(&_rootBodyNode)->
             getOrCreateStateSet()->getAttribute(osg::StateAttribute::MATERIAL);
     this->getOrCreateStateSet()->setAttribute(mat);
@@ -197,22 +199,42 @@ void SkeletonNode::setBodyNodeTransparency(const dart::dynamics::BodyNode& node,
 
 void SkeletonNode::update()
 {
-    // First update root joint transform, which places the skeleton relative to the world
-    _bodyNodeMatrixMap.at(&_rootBodyNode)->setMatrix(osgGolems::eigToOsgMatrix(_rootBodyNode.getWorldTransform()));
-    _bodyNodeVisualsMap.at(&_rootBodyNode)->setMatrix(osgGolems::eigToOsgMatrix(_rootBodyNode.getWorldTransform()));
-
-    // Then recursively update all the children of the root body node
-    for (int i=0; i<_rootBodyNode.getNumChildBodyNodes(); ++i) {
-        _updateRecursively(*_rootBodyNode.getChildBodyNode(i));
+    // Parents come before children, so this is the same order the recursive walk used to go in
+    for (size_t i=0; i<_bodyNodeTransforms.size(); ++i) {
+        const BodyNodeTransform& entry = _bodyNodeTransforms[i];
+        osg::Matrix tf = osgGolems::eigToOsgMatrix(entry.bodyNode->getWorldTransform());
+        entry.matrix->setMatrix(tf);
+        entry.visuals->setMatrix(tf);
     }
 
     _updateSkeletonVisuals();
 }
 
+void SkeletonNode::update(const Eigen::Isometry3d* transforms, size_t numTransforms, const Eigen::Vector3d& com)
+{
+    for (size_t i=0; i<_bodyNodeTransforms.size(); ++i) {
+        const BodyNodeTransform& entry = _bodyNodeTransforms[i];
+        // Out of range means the snapshot is from before the skeleton changed
+        if (entry.skeletonIndex >= numTransforms) {
+            continue;
+        }
+        osg::Matrix tf = osgGolems::eigToOsgMatrix(transforms[entry.skeletonIndex]);
+        entry.matrix->setMatrix(tf);
+        entry.visuals->setMatrix(tf);
+    }
+
+    _updateSkeletonVisuals(com);
+}
+
 void SkeletonNode::_updateSkeletonVisuals()
+{
+    _updateSkeletonVisuals(_rootBodyNode.getSkeleton()->getWorldCOM());
+}
+
+void SkeletonNode::_updateSkeletonVisuals(const Eigen::Vector3d& com)
 {
     osg::Matrix comTF;
-    comTF.makeTranslate(osgGolems::eigToOsgVec3(_rootBodyNode.getSkeleton()->getWorldCOM()));
+    comTF.makeTranslate(osgGolems::eigToOsgVec3(com));
     if (_skeletonVisuals->getCenterOfMassTF()) {
         _skeletonVisuals->getCenterOfMassTF()->setMatrix(comTF);
     }
@@ -230,6 +252,7 @@ void SkeletonNode::_createSkeleton()
     // Get rootBodyNode's parent Joint, convert to osg::MatrixTransform,
     // add rootBodyNode to it, and then add child joint
     osg::MatrixTransform* root =  new osg::MatrixTransform(osgGolems::eigToOsgMatrix(_rootBodyNode.getWorldTransform()));
+    root->setDataVariance(osg::Object::DYNAMIC);
     root->addChild(_makeBodyNodeGroup(_rootBodyNode));
     root->addChild(_makeBodyNodeCollisionMeshGroup(_rootBodyNode));
     this->addChild(root);
@@ -257,6 +280,7 @@ void SkeletonNode::_addSkeletonObjectsRecursivley(const dart::dynamics::BodyNode
         // Get child BodyNode and add its parent Joint to the grandparent Joint
         dart::dynamics::BodyNode* childBodyNode = bodyNode.getChildBodyNode(i);
         osg::MatrixTransform* childNodeTF = new osg::MatrixTransform(osgGolems::eigToOsgMatrix(childBodyNode->getWorldTransform()));
+        childNodeTF->setDataVariance(osg::Object::DYNAMIC);
         childNodeTF->addChild(_makeBodyNodeGroup(*childBodyNode));
         childNodeTF->addChild(_makeBodyNodeCollisionMeshGroup(*childBodyNode));
         this->addChild(childNodeTF);
@@ -267,16 +291,37 @@ void SkeletonNode::_addSkeletonObjectsRecursivley(const dart::dynamics::BodyNode
     }
 }
 
-void SkeletonNode::_updateRecursively(const dart::dynamics::BodyNode& bodyNode)
+void SkeletonNode::_flattenBodyNodes(const dart::dynamics::Skeleton& skeleton)
 {
-    // Get child node and update its transform. Then get its children and update theirs
-    BodyNodeMatrixMap::const_iterator it = _bodyNodeMatrixMap.find(&bodyNode);
-    if (it != _bodyNodeMatrixMap.end()) {
-        _bodyNodeMatrixMap.at(&bodyNode)->setMatrix(osgGolems::eigToOsgMatrix(bodyNode.getWorldTransform()));
-        _bodyNodeVisualsMap.at(&bodyNode)->setMatrix(osgGolems::eigToOsgMatrix(bodyNode.getWorldTransform()));
-
-        for (int i=0; i<bodyNode.getNumChildBodyNodes(); ++i) {
-            _updateRecursively(*bodyNode.getChildBodyNode(i));
+    // Index of each BodyNode in the skeleton, which is where snapshots store its transform
+    std::map<const dart::dynamics::BodyNode*, size_t> skeletonIndices;
+    for (int i=0; i<skeleton.getNumBodyNodes(); ++i) {
+        skeletonIndices.insert(std::make_pair(skeleton.getBodyNode(i), i));
+    }
+
+    // Depth first from the root so every BodyNode comes after its parent
+    _bodyNodeTransforms.clear();
+    std::vector<const dart::dynamics::BodyNode*> stack(1, &_rootBodyNode);
+    while (!stack.empty()) {
+        const dart::dynamics::BodyNode* node = stack.back();
+        stack.pop_back();
+
+        BodyNodeMatrixMap::const_iterator matrixIt = _bodyNodeMatrixMap.find(node);
+        BodyNodeVisualsMap::const_iterator visualsIt = _bodyNodeVisualsMap.find(node);
+        if (matrixIt == _bodyNodeMatrixMap.end() || visualsIt == _bodyNodeVisualsMap.end()) {
+            continue;
+        }
+
+        BodyNodeTransform entry;
+        entry.bodyNode = node;
+        entry.skeletonIndex = skeletonIndices.at(node);
+        entry.matrix = matrixIt->second.get();
+        entry.visuals = visualsIt->second.get();
+        _bodyNodeTransforms.push_back(entry);
+
+        // Push in reverse so the first child is visited first
+        for (int i=node->getNumChildBodyNodes()-1; i>=0; --i) {
+            stack.push_back(node->getChildBodyNode(i));
         }
     }
 }
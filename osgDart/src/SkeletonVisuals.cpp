@@ -61,6 +61,7 @@ SkeletonVisuals::~SkeletonVisuals()
 void SkeletonVisuals::addCenterOfMass()
 {
     _centerOfMassTF = new osg::MatrixTransform;
+    _centerOfMassTF->setDataVariance(osg::Object::DYNAMIC);
     _centerOfMass = new osgGolems::Sphere(osg::Vec3(0,0,0), 0.03, osg::Vec4(1,1,.8,1));
     this->_setGeodeModes(_centerOfMass);
     _centerOfMassTF->addChild(_centerOfMass);
@@ -70,6 +71,7 @@ void SkeletonVisuals::addCenterOfMass()
 void SkeletonVisuals::addProjectedCenterOfMass()
 {
     _projectedCenterOfMassTF = new osg::MatrixTransform;
+    _projectedCenterOfMassTF->setDataVariance(osg::Object::DYNAMIC);
     _projectedCenterOfMass = new osgGolems::Cylinder(osg::Vec3(0,0,0), 0.03, 0.001f, osg::Vec4(1,1,.8,1));
     this->_setGeodeModes(_projectedCenterOfMass);
     _projectedCenterOfMassTF->addChild(_projectedCenterOfMass);
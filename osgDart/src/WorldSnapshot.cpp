@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// DART includes
+#include <dart/dynamics/BodyNode.h>
+#include <dart/collision/CollisionDetector.h>
+#include <dart/constraint/ConstraintDynamics.h>
+
+// osgDart includes
+#include "WorldSnapshot.h"
+
+using namespace osgDart;
+
+WorldSnapshot::WorldSnapshot()
+    : _time(0),
+      _sequence(0),
+      _generation(0)
+{
+}
+
+void WorldSnapshot::capture(dart::simulation::World& world, bool captureContacts)
+{
+    _time = world.getTime();
+
+    size_t numSkeletons = world.getNumSkeletons();
+    _skeletons.resize(numSkeletons);
+    _offsets.resize(numSkeletons + 1);
+    _coms.resize(numSkeletons);
+
+    // Count BodyNodes first so the transforms only get resized once
+    size_t numBodyNodes = 0;
+    for (size_t i = 0; i < numSkeletons; ++i) {
+        _offsets[i] = numBodyNodes;
+        numBodyNodes += world.getSkeleton(i)->getNumBodyNodes();
+    }
+    _offsets[numSkeletons] = numBodyNodes;
+    _transforms.resize(numBodyNodes);
+
+    for (size_t i = 0; i < numSkeletons; ++i) {
+        dart::dynamics::Skeleton* skel = world.getSkeleton(i);
+        _skeletons[i] = skel;
+        _coms[i] = skel->getWorldCOM();
+        Eigen::Isometry3d* transforms = &_transforms[_offsets[i]];
+        for (size_t j = 0; j < _offsets[i+1] - _offsets[i]; ++j) {
+            transforms[j] = skel->getBodyNode(j)->getWorldTransform();
+        }
+    }
+
+    _contactPoints.clear();
+    _contactForces.clear();
+    if (captureContacts && world.getConstraintHandler()) {
+        dart::collision::CollisionDetector* detector = world.getConstraintHandler()->getCollisionDetector();
+        size_t numContacts = detector->getNumContacts();
+        for (size_t i = 0; i < numContacts; ++i) {
+            const dart::collision::Contact& contact = detector->getContact(i);
+            _contactPoints.push_back(contact.point);
+            _contactForces.push_back(contact.force);
+        }
+    }
+}
+
+double WorldSnapshot::getTime() const
+{
+    return _time;
+}
+
+size_t WorldSnapshot::getSequence() const
+{
+    return _sequence;
+}
+
+size_t WorldSnapshot::getNumSkeletons() const
+{
+    return _skeletons.size();
+}
+
+const dart::dynamics::Skeleton* WorldSnapshot::getSkeleton(size_t skeletonIndex) const
+{
+    return _skeletons.at(skeletonIndex);
+}
+
+size_t WorldSnapshot::getNumBodyNodes(size_t skeletonIndex) const
+{
+    return _offsets.at(skeletonIndex + 1) - _offsets.at(skeletonIndex);
+}
+
+const Eigen::Isometry3d* WorldSnapshot::getBodyNodeTransforms(size_t skeletonIndex) const
+{
+    if (getNumBodyNodes(skeletonIndex) == 0) {
+        return NULL;
+    }
+    return &_transforms[_offsets[skeletonIndex]];
+}
+
+const Eigen::Vector3d& WorldSnapshot::getSkeletonCOM(size_t skeletonIndex) const
+{
+    return _coms.at(skeletonIndex);
+}
+
+const std::vector<Eigen::Vector3d>& WorldSnapshot::getContactPoints() const
+{
+    return _contactPoints;
+}
+
+const std::vector<Eigen::Vector3d>& WorldSnapshot::getContactForces() const
+{
+    return _contactForces;
+}
+
+WorldSnapshotBuffer::WorldSnapshotBuffer(bool captureContacts)
+    : _ready(2),
+      _back(0),
+      _front(1),
+      _sequence(0),
+      _generation(0),
+      _live(false),
+      _captureContacts(captureContacts)
+{
+}
+
+void WorldSnapshotBuffer::publish(dart::simulation::World& world)
+{
+    WorldSnapshot& snapshot = _snapshots[_back];
+    snapshot.capture(world, _captureContacts.load(std::memory_order_relaxed));
+    snapshot._sequence = ++_sequence;
+    snapshot._generation = _generation.load(std::memory_order_acquire);
+
+    // Hand the filled snapshot over and take whichever one was waiting in its place.
+    // The release half makes the snapshot's contents visible to the reader
+    int previous = _ready.exchange(_back | FRESH, std::memory_order_acq_rel);
+    _back = previous & INDEX_MASK;
+}
+
+const WorldSnapshot* WorldSnapshotBuffer::acquire()
+{
+    // Only swap if something new was published, otherwise keep drawing what we have
+    if (_ready.load(std::memory_order_relaxed) & FRESH) {
+        int previous = _ready.exchange(_front, std::memory_order_acq_rel);
+        _front = previous & INDEX_MASK;
+    }
+
+    const WorldSnapshot* snapshot = &_snapshots[_front];
+    if (snapshot->_sequence == 0
+            || snapshot->_generation != _generation.load(std::memory_order_acquire)) {
+        return NULL;
+    }
+    return snapshot;
+}
+
+void WorldSnapshotBuffer::setLive(bool live)
+{
+    if (live) {
+        _generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+    _live.store(live, std::memory_order_release);
+}
+
+bool WorldSnapshotBuffer::isLive() const
+{
+    return _live.load(std::memory_order_acquire);
+}
+
+void WorldSnapshotBuffer::setCaptureContacts(bool captureContacts)
+{
+    _captureContacts.store(captureContacts, std::memory_order_relaxed);
+}
@@ -47,6 +47,10 @@
 #include "WorldVisuals.h"
 #include "osgUtils.h"
 
+// C++ Standard includes
+#include <iostream>
+#include <algorithm>
+
 using namespace osgDart;
 
 ContactForceVisual::ContactForceVisual(bool debug)
@@ -118,3 +122,128 @@ osg::Matrix ContactForceVisual::_convertVectorToOsgTF(const Eigen::Vector3d &poi
 
     return osgGolems::eigToOsgMatrix(forceTF);
 }
+
+ContactForcesVisual::ContactForcesVisual(bool debug)
+    : _geometry(new osg::Geometry),
+      _verts(new osg::Vec3Array),
+      _color(new osg::Vec4Array),
+      _lines(new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, 0)),
+      _arrowheads(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLES, 0, 0)),
+      _capacity(0),
+      _numContacts(0),
+      _debug(debug)
+{
+    // The vertices change every frame, so skip display lists and let OSG know
+    // not to draw the geometry while it's being updated
+    _geometry->setDataVariance(osg::Object::DYNAMIC);
+    _geometry->setUseDisplayList(false);
+    _geometry->setUseVertexBufferObjects(true);
+
+    _geometry->setVertexArray(_verts);
+    _geometry->addPrimitiveSet(_lines);
+    _geometry->addPrimitiveSet(_arrowheads);
+
+    _color->push_back(osg::Vec4(1.0f,0.0f,0.0f,1.0f));
+    _geometry->setColorArray(_color);
+    _geometry->setColorBinding(osg::Geometry::BIND_OVERALL);
+
+    _geometry->getOrCreateStateSet()->setAttribute(new osg::LineWidth(3));
+    _geometry->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+
+    this->setDataVariance(osg::Object::DYNAMIC);
+    this->addDrawable(_geometry);
+}
+
+ContactForcesVisual::~ContactForcesVisual()
+{
+
+}
+
+void ContactForcesVisual::update(const std::vector<Eigen::Vector3d>& contactPoints,
+                                 const std::vector<Eigen::Vector3d>& contactForces)
+{
+    size_t numContacts = std::min(contactPoints.size(), contactForces.size());
+    _reserve(numContacts);
+
+    // Scale the force vectors so the largest one has unit length
+    double maxForce = 0;
+    for (size_t i = 0; i < numContacts; ++i) {
+        double force = contactForces[i].norm();
+        if (force == force && force > maxForce) {
+            maxForce = force;
+        }
+    }
+
+    // Same arrowhead size as an osgGolems::Line of width 3
+    const double arrowWidth = 0.009;
+    const double arrowLength = 0.045;
+
+    osg::Vec3Array& verts = *_verts;
+    for (size_t i = 0; i < numContacts; ++i) {
+        const Eigen::Vector3d& point = contactPoints[i];
+        double force = contactForces[i].norm();
+
+        // Arrows point along the force, like the x axis of ContactForceVisual
+        Eigen::Quaterniond forceQuat = Eigen::Quaterniond::Identity();
+        if (force >= 1e-3 && force == force) {
+            forceQuat.setFromTwoVectors(Eigen::Vector3d(1,0,0), contactForces[i]);
+        }
+        Eigen::Matrix3d rot = forceQuat.toRotationMatrix();
+        Eigen::Vector3d dir = rot.col(0);
+        Eigen::Vector3d side = rot.col(1);
+
+        double length = 0;
+        if (maxForce >= 1e-3 && force >= 1e-3 && force == force) {
+            length = force / maxForce;
+        }
+        Eigen::Vector3d tip = point + length * dir;
+
+        verts[2*i] = osgGolems::eigToOsgVec3(point);
+        verts[2*i + 1] = osgGolems::eigToOsgVec3(tip);
+
+        size_t head = 2*numContacts + 3*i;
+        verts[head] = osgGolems::eigToOsgVec3(tip + arrowWidth * side);
+        verts[head + 1] = osgGolems::eigToOsgVec3(tip + arrowLength * dir);
+        verts[head + 2] = osgGolems::eigToOsgVec3(tip - arrowWidth * side);
+    }
+
+    _lines->setFirst(0);
+    _lines->setCount(2*numContacts);
+    _arrowheads->setFirst(2*numContacts);
+    _arrowheads->setCount(3*numContacts);
+    _numContacts = numContacts;
+
+    _verts->dirty();
+    _geometry->dirtyBound();
+}
+
+size_t ContactForcesVisual::getNumContacts() const
+{
+    return _numContacts;
+}
+
+void ContactForcesVisual::setColor(const osg::Vec4& color)
+{
+    (*_color)[0] = color;
+    _color->dirty();
+}
+
+void ContactForcesVisual::_reserve(size_t numContacts)
+{
+    if (numContacts <= _capacity) {
+        return;
+    }
+
+    size_t capacity = (_capacity > 0 ? _capacity : 16);
+    while (capacity < numContacts) {
+        capacity *= 2;
+    }
+
+    if (_debug) {
+        std::cerr << "[ContactForcesVisual] Growing to " << capacity << " contacts" << std::endl;
+    }
+
+    // Five vertices per contact. Only the ones covered by the draw arrays are drawn
+    _verts->resize(5*capacity);
+    _capacity = capacity;
+}
@@ -66,6 +66,7 @@
 // Local includes
 #include "osgDartShapes.h"
 #include "osgAssimpSceneReader.h"
+#include "MeshCache.h"
 #include "osgUtils.h"
 
 // TODO: get colors working for sdf files
@@ -140,7 +141,10 @@ osg::Node* osgDart::convertMeshToOsgNode(dart::dynamics::Shape* mesh)
             std::cerr << "Exception: " << e.what() << std::endl;
         }
         if (ainode) {
-            osg::Node* node = osgAssimpSceneReader::traverseAIScene(aiscene, aiscene->mRootNode);
+            // The converted mesh is shared by every shape using the same mesh, so this
+            // shape's own state, like its wireframe mode, goes on a group around it
+            osg::Group* node = new osg::Group;
+            node->addChild(MeshCache::getNode(aiscene));
             osgGolems::addWireFrameMode(node);
             return node;
         } else {
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file FrameCapture.h
+ * \brief Camera draw callback that reads back rendered frames asynchronously
+ * through a ring of OpenGL pixel buffer objects.
+ */
+
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+// OpenSceneGraph includes
+#include <osg/Camera>
+
+// QT includes
+#include <QtGui/QImage>
+
+// C++ Standard includes
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace osgGolems {
+
+/**
+ * \class FrameCapture FrameCapture.h
+ * \brief Final draw callback that copies the camera's color buffer into a
+ * ring of pixel buffer objects. glReadPixels into a PBO returns right away,
+ * and a PBO is only mapped when the ring comes back around to it, so the
+ * transfer overlaps with the following frames instead of stalling the GPU.
+ * Captured frames come out in order, numFramesInFlight-1 frames late.
+ */
+class FrameCapture : public osg::Camera::DrawCallback
+{
+public:
+
+    /**
+     * \brief Constructor for FrameCapture class
+     * \param width Width of the frames to read back, in pixels
+     * \param height Height of the frames to read back, in pixels
+     * \param numFramesInFlight Number of pixel buffer objects in the ring
+     */
+    FrameCapture(int width, int height, uint numFramesInFlight=3);
+
+    /**
+     * \brief Destructor for FrameCapture class
+     */
+    ~FrameCapture();
+
+    /**
+     * \brief Starts reading back the current frame and maps the oldest one
+     * in flight. Called by OpenSceneGraph with the camera's context current.
+     * \param renderInfo Render information of the camera being drawn
+     * \return void
+     */
+    virtual void operator()(osg::RenderInfo& renderInfo) const;
+
+    /**
+     * \brief Makes the next draw map every frame still in flight and free the
+     * pixel buffer objects instead of reading back a new frame.
+     * \return void
+     */
+    void flush();
+
+    /**
+     * \brief Removes the oldest captured frame from the queue
+     * \param image Image to put the frame in
+     * \return bool Whether there was a frame to take
+     */
+    bool takeFrame(QImage& image);
+
+    /**
+     * \brief Gets the number of captured frames waiting to be taken
+     * \return size_t
+     */
+    size_t getNumFrames() const;
+
+    /**
+     * \brief Gets the width of the captured frames
+     * \return int
+     */
+    int getWidth() const { return _width; }
+
+    /**
+     * \brief Gets the height of the captured frames
+     * \return int
+     */
+    int getHeight() const { return _height; }
+
+protected:
+
+    /**
+     * \brief Maps a pixel buffer object and queues its contents as a frame
+     * \param index Index of the pixel buffer object in the ring
+     * \return void
+     */
+    void _mapPixelBuffer(uint index) const;
+
+    /**
+     * \brief Reads the frame buffer straight into a queued frame, for
+     * drivers without pixel buffer objects
+     * \return void
+     */
+    void _readPixels() const;
+
+    int _width;                                 ///< Width of the frames in pixels
+    int _height;                                ///< Height of the frames in pixels
+    uint _numFramesInFlight;                    ///< Size of the pixel buffer object ring
+
+    mutable std::vector<GLuint> _pixelBuffers;  ///< Pixel buffer object ids, created on the first draw
+    mutable std::vector<bool> _pending;         ///< Whether each pixel buffer object holds an unmapped frame
+    mutable uint _current;                      ///< Pixel buffer object the next frame is read into
+    mutable unsigned int _contextID;            ///< Context the pixel buffer objects belong to
+
+    mutable std::mutex _mutex;                  ///< Guards the frame queue and flush flag
+    mutable std::deque<QImage> _frames;         ///< Captured frames, oldest first
+    mutable bool _flush;                        ///< Set by flush, cleared by the draw that drains the ring
+
+}; // end class FrameCapture
+
+} // end namespace osgGolems
+
+#endif // FRAME_CAPTURE_H
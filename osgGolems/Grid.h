@@ -53,6 +53,8 @@
 
 // OpenSceneGraph includes
 #include <osg/Geometry>
+#include <osg/Geode>
+#include <osg/Uniform>
 
 /**
  * \namespace osgGolems
@@ -128,6 +130,70 @@ protected:
 
 }; // end class Grid
 
+/**
+ * \class InfiniteGrid Grid.h
+ * \brief Procedural ground grid drawn by a fragment shader on a single quad.
+ * The quad follows the camera in the ground plane so the grid has no edge,
+ * and the lines fade out with distance from the eye instead of aliasing.
+ */
+class InfiniteGrid : public osg::Geode
+{
+public:
+
+    /**
+     * \brief Constructor for InfiniteGrid class.
+     * \param gridSize Length of a side of each grid square.
+     * \param fadeDistance Distance from the eye at which the lines disappear.
+     * \param color Color of the grid lines
+     * \return void
+     */
+    InfiniteGrid(float gridSize, float fadeDistance, const osg::Vec4& color);
+
+    /**
+     * \brief Destructor for InfiniteGrid class
+     */
+    ~InfiniteGrid();
+
+    /**
+     * \brief Sets the color of the grid lines
+     * \param color Vector specifying the color using RGBA format
+     * \return void
+     */
+    void setGridColor(const osg::Vec4& color);
+
+    /**
+     * \brief Sets the length of a side of each grid square
+     * \param gridSize Grid square size in meters
+     * \return void
+     */
+    void setGridSize(float gridSize);
+
+    /**
+     * \brief Sets the distance from the eye at which the lines disappear
+     * \param fadeDistance Fade distance in meters
+     * \return void
+     */
+    void setFadeDistance(float fadeDistance);
+
+protected:
+
+    /**
+     * \brief Creates the quad, the shader program and the state for blending
+     * \return void
+     */
+    void _createGrid();
+
+    /// Grid square size uniform
+    osg::ref_ptr<osg::Uniform> _gridSize;
+
+    /// Fade distance uniform, also the half width of the quad
+    osg::ref_ptr<osg::Uniform> _fadeDistance;
+
+    /// Grid line color uniform
+    osg::ref_ptr<osg::Uniform> _gridColor;
+
+}; // end class InfiniteGrid
+
 } // end namespace osgGolems
 
 #endif // GRID_H
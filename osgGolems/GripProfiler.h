@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file GripProfiler.h
+ * \brief Lightweight timers for the phases of a simulation step and a render frame
+ */
+
+#ifndef GRIP_PROFILER_H
+#define GRIP_PROFILER_H
+
+// Local includes
+#include "gripTime.h"
+
+// C++ Standard includes
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * \struct GripPhaseStats GripProfiler.h
+ * \brief Summary of the durations recorded for one phase. Durations are in seconds.
+ */
+struct GripPhaseStats {
+    std::string name; ///< Name of the phase
+    size_t count;     ///< Number of durations recorded
+    double total;     ///< Sum of the durations
+    double mean;      ///< Mean duration
+    double p50;       ///< Median duration, to the resolution of the histogram
+    double p99;       ///< 99th percentile duration, to the resolution of the histogram
+    double max;       ///< Longest duration
+};
+
+/**
+ * \class GripProfiler GripProfiler.h
+ * \brief Aggregates the durations of named phases, such as the dynamics or the
+ * plugin callbacks of a simulation step, into log scale histograms with four
+ * buckets per doubling from 100 ns to over 100 s. Recording only touches a
+ * preallocated histogram, so it can stay on in the simulation loop. Each phase
+ * has its own lock, so phases timed on different threads don't contend.
+ * Phases are meant to be added during setup, before anything records.
+ */
+class GripProfiler
+{
+public:
+
+    /// Number of histogram buckets per doubling of the duration
+    static const int bucketsPerOctave = 4;
+
+    /// Number of histogram buckets
+    static const int numBuckets = 128;
+
+    /// Upper bound of the first histogram bucket in seconds
+    static const double minDuration;
+
+    /// Maximum number of phases
+    static const size_t maxPhases = 64;
+
+    /**
+     * \brief Constructs a GripProfiler with no phases
+     */
+    GripProfiler();
+
+    /**
+     * \brief Destructor for GripProfiler
+     */
+    ~GripProfiler();
+
+    /**
+     * \brief Adds a phase, or finds the phase with the same name
+     * \param name Name of the phase, e.g. "simulation: dynamics"
+     * \return size_t Index of the phase to record durations in
+     */
+    inline size_t addPhase(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(_addMutex);
+        for (size_t i=0; i<_phases.size(); ++i) {
+            if (_phases[i]->name == name) {
+                return i;
+            }
+        }
+
+        if (_phases.size() == maxPhases) {
+            std::cerr << "[GripProfiler] Can't add phase " << name << ", there are already "
+                      << maxPhases << " phases" << std::endl;
+            return maxPhases;
+        }
+
+        GripProfilePhase* phase = new GripProfilePhase;
+        phase->name = name;
+        phase->histogram.resize(numBuckets, 0);
+        phase->count = 0;
+        phase->total = 0;
+        phase->max = 0;
+
+        // Reserved in the constructor, so this never moves the phases being recorded in
+        _phases.push_back(phase);
+        _numPhases = _phases.size();
+        return _phases.size() - 1;
+    }
+
+    /**
+     * \brief Records one duration of a phase. Does nothing while disabled.
+     * \param phase Index of the phase returned by addPhase()
+     * \param duration Duration in seconds
+     * \return void
+     */
+    inline void record(size_t phase, double duration)
+    {
+        if (!_enabled || phase >= _numPhases) {
+            return;
+        }
+        GripProfilePhase* p = _phases[phase];
+        int bucket = _bucket(duration);
+
+        std::lock_guard<std::mutex> lock(p->mutex);
+        ++p->histogram[bucket];
+        ++p->count;
+        p->total += duration;
+        if (duration > p->max) {
+            p->max = duration;
+        }
+    }
+
+    /**
+     * \brief Enables or disables recording
+     * \param enabled Whether or not to record durations
+     * \return void
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * \brief Whether or not durations are recorded
+     * \return bool
+     */
+    bool isEnabled() const;
+
+    /**
+     * \brief Gets the number of phases
+     * \return size_t
+     */
+    size_t getNumPhases() const;
+
+    /**
+     * \brief Gets the summary of a phase's durations so far
+     * \param phase Index of the phase
+     * \return GripPhaseStats Summary, with a count of zero for an invalid index
+     */
+    GripPhaseStats getStats(size_t phase) const;
+
+    /**
+     * \brief Clears the recorded durations of every phase
+     * \return void
+     */
+    void reset();
+
+    /**
+     * \brief Writes the summary of every phase that recorded something to a CSV
+     * file, one row per phase with the durations in microseconds
+     * \param fileName Name of the CSV file
+     * \return bool Whether or not the file was written
+     */
+    bool writeCsv(const std::string& fileName) const;
+
+protected:
+
+    /**
+     * \struct GripProfilePhase
+     * \brief Histogram and totals of one phase
+     */
+    struct GripProfilePhase {
+        std::string name;                 ///< Name of the phase
+        std::vector<size_t> histogram;    ///< Number of durations in each bucket
+        size_t count;                     ///< Number of durations recorded
+        double total;                     ///< Sum of the durations
+        double max;                       ///< Longest duration
+        mutable std::mutex mutex;         ///< Guards the histogram and totals
+    };
+
+    /**
+     * \brief Gets the histogram bucket of a duration
+     * \param duration Duration in seconds
+     * \return int Bucket index
+     */
+    static inline int _bucket(double duration)
+    {
+        if (duration < minDuration) {
+            return 0;
+        }
+        // duration / minDuration = m * 2^e with m in [0.5, 1) and e >= 1, so e
+        // picks the octave and m the bucket within it
+        int e;
+        double m = std::frexp(duration / minDuration, &e);
+        int bucket = 1 + (e - 1) * bucketsPerOctave + (int)((m - 0.5) * 2 * bucketsPerOctave);
+        return (bucket < numBuckets ? bucket : numBuckets - 1);
+    }
+
+    /**
+     * \brief Gets the upper bound of a histogram bucket
+     * \param bucket Bucket index
+     * \return double Upper bound in seconds
+     */
+    static double _bucketUpperBound(int bucket);
+
+    /**
+     * \brief Gets the duration below which a fraction of a phase's durations fall
+     * \param phase Phase to look at. Its lock must be held
+     * \param fraction Fraction between 0 and 1, e.g. 0.99
+     * \return double Upper bound of the bucket the percentile falls in, capped at the max
+     */
+    static double _percentile(const GripProfilePhase& phase, double fraction);
+
+    /// Phases, allocated up front so adding one never moves the others
+    std::vector<GripProfilePhase*> _phases;
+
+    /// Number of phases added. Atomic since recording threads read it
+    std::atomic<size_t> _numPhases;
+
+    /// Serializes adding phases
+    std::mutex _addMutex;
+
+    /// Whether or not durations are recorded
+    std::atomic<bool> _enabled;
+};
+
+/**
+ * \class GripScopedTimer GripProfiler.h
+ * \brief Records the time from its construction to its destruction as one
+ * duration of a phase. Does nothing if the profiler is NULL.
+ */
+class GripScopedTimer
+{
+public:
+
+    /**
+     * \brief Starts timing a phase
+     * \param profiler Profiler to record in, or NULL to not time anything
+     * \param phase Index of the phase returned by GripProfiler::addPhase()
+     */
+    GripScopedTimer(GripProfiler* profiler, size_t phase)
+        : _profiler(profiler), _phase(phase), _start(profiler ? grip::getTime() : 0)
+    {
+    }
+
+    /**
+     * \brief Records the time since construction
+     */
+    ~GripScopedTimer()
+    {
+        if (_profiler) {
+            _profiler->record(_phase, grip::getTime() - _start);
+        }
+    }
+
+protected:
+    GripProfiler* _profiler; ///< Profiler to record in, or NULL
+    size_t _phase;           ///< Index of the phase being timed
+    double _start;           ///< Time the timer started
+};
+
+#endif // GRIP_PROFILER_H
@@ -52,16 +52,20 @@
 
 // QT includes
 #include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
 #include <QtGui/QGridLayout>
 
 // OpenSceneGraph includes
 #include <osgViewer/CompositeViewer>
+#include <osgViewer/Viewer>
 #include <osgViewer/ViewerEventHandlers>
 #include <osgGA/OrbitManipulator>
 #include <osgDB/ReadFile>
 #include <osgQt/GraphicsWindowQt>
 #include <osg/io_utils>
 #include "osgUtils.h"
+#include "FrameCapture.h"
+#include "GripProfiler.h"
 
 // Standard Library includes
 #include <iostream>
@@ -77,9 +81,29 @@ class ViewerWidget : public QWidget, public osgViewer::CompositeViewer
 public:
     /**
      * \brief Constructor for ViewerWidget class
+     * \param threadingModel Threading model of the viewer, see setViewerThreadingModel()
      */
     ViewerWidget(osgViewer::ViewerBase::ThreadingModel threadingModel=osgViewer::CompositeViewer::AutomaticSelection);
 
+    /**
+     * \brief Sets the threading model of the viewer. With DrawThreadPerContext or
+     * CullThreadPerCameraDrawThreadPerContext the next frame's update traversal runs
+     * while the last frame is still being drawn, so anything changed after the scene
+     * is first drawn has to have DYNAMIC data variance. AutomaticSelection uses the
+     * OSG_THREADING environment variable if it's set, and SingleThreaded otherwise,
+     * since the model OpenSceneGraph would pick causes problems on some platforms.
+     * \param threadingModel New threading model
+     * \return void
+     */
+    void setViewerThreadingModel(osgViewer::ViewerBase::ThreadingModel threadingModel);
+
+    /**
+     * \brief Gets the name of a threading model, e.g. for menus and benchmarks
+     * \param threadingModel Threading model
+     * \return const char* Name of the threading model
+     */
+    static const char* getThreadingModelName(osgViewer::ViewerBase::ThreadingModel threadingModel);
+
     /**
      * \brief Add a osgQt::GraphicsWindowQt widget to the ViewerWidget
      * \param camera An osg::Camera pointer
@@ -198,23 +222,186 @@ public:
     void addGrid(uint width, uint depth, uint gridSize);
 
     /**
-     * \brief Renders the scene
+     * \brief Adds a shader based grid with no edge that fades out with distance.
+     * Needs GLSL 1.20; use addGrid on older hardware.
+     * \param gridSize Length of side of each grid square in meters
+     * \param fadeDistance Distance from the eye at which the lines disappear
+     * \return void
+     */
+    void addInfiniteGrid(float gridSize, float fadeDistance);
+
+    /**
+     * \brief Renders the scene, and schedules the next frame if rendering
+     * is continuous or a camera manipulator is still animating
      * \param event QPaint event
      * \return void
      */
-    virtual void paintEvent( QPaintEvent* event )
-    { frame(); }
+    virtual void paintEvent( QPaintEvent* event );
+
+    /**
+     * \brief Requests a redraw for input events, so camera interaction and
+     * widgets changing the scene get rendered. Install it on other objects,
+     * or on the application, to redraw on their input too.
+     * \param object Object receiving the event
+     * \param event Event being received
+     * \return bool Always false, the event isn't filtered out
+     */
+    virtual bool eventFilter(QObject* object, QEvent* event);
+
+    /**
+     * \brief Schedules a frame because the scene changed. Frames are only
+     * rendered when requested, and requests made while a frame is already
+     * scheduled are merged into it, so calling this often is cheap.
+     * \return void
+     */
+    void requestRedraw();
 
     /**
-     * \brief takes a screenshot of the view widget
+     * \brief Sets whether to keep rendering frames, e.g. while simulating,
+     * instead of only when a redraw is requested
+     * \param continuous Whether or not to render continuously
+     * \return void
+     */
+    void setContinuousRendering(bool continuous);
+
+    /**
+     * \brief Whether or not frames are rendered continuously
+     * \return bool
+     */
+    bool isRenderingContinuously() const;
+
+    /**
+     * \brief Sets the maximum number of frames rendered per second
+     * \param fps Maximum frame rate, or 0 for no limit
+     * \return void
+     */
+    void setMaxFrameRate(double fps);
+
+    /**
+     * \brief Gets the maximum number of frames rendered per second
+     * \return double
+     */
+    double getMaxFrameRate() const;
+
+    /**
+     * \brief Sets an interval at which a frame is rendered even if nobody
+     * requested one, for code that changes the scene without calling requestRedraw()
+     * \param msec Interval in milliseconds, or 0 to disable
+     * \return void
+     */
+    void setIdleRedrawInterval(int msec);
+
+    /**
+     * \brief Gets the number of frames rendered since the last resetFrameStats()
+     * \return size_t
+     */
+    size_t getNumFramesRendered() const;
+
+    /**
+     * \brief Gets the number of redraw requests merged into an already
+     * scheduled frame since the last resetFrameStats()
+     * \return size_t
+     */
+    size_t getNumFramesSkipped() const;
+
+    /**
+     * \brief Resets the rendered and skipped frame counters
+     * \return void
+     */
+    void resetFrameStats();
+
+    /**
+     * \brief Sets the profiler every rendered frame is timed in. With a multi-threaded
+     * viewer this is the time until frame() returns, not until the draw finishes.
+     * \param profiler Profiler to record in, or NULL to not time anything
+     * \return void
+     */
+    void setProfiler(GripProfiler* profiler);
+
+    /**
+     * \brief takes a screenshot of the view widget. With a multi-threaded viewer the
+     * graphics threads are stopped for it, since the draw thread owns the GL context.
      * \return void
      */
     QImage takeScreenshot();
 
+    /**
+     * \brief Creates an offscreen pbuffer of a fixed size that renders the
+     * scene of the first view, for recording without a visible window.
+     * Frames are read back asynchronously through pixel buffer objects.
+     * \param width Width of the recorded frames in pixels
+     * \param height Height of the recorded frames in pixels
+     * \param numFramesInFlight Number of frames being read back at once
+     * \return bool Whether the offscreen buffer could be created
+     */
+    bool startOffscreenCapture(int width, int height, uint numFramesInFlight=3);
+
+    /**
+     * \brief Renders one offscreen frame from the first view's camera and
+     * starts reading it back. Does nothing if no capture was started.
+     * \return void
+     */
+    void captureFrame();
+
+    /**
+     * \brief Removes the oldest captured frame that has finished reading back
+     * \param image Image to put the frame in
+     * \return bool Whether there was a frame to take
+     */
+    bool takeCapturedFrame(QImage& image);
+
+    /**
+     * \brief Finishes reading back the frames in flight and destroys the
+     * offscreen buffer. Frames not taken yet can still be taken afterwards.
+     * \return void
+     */
+    void stopOffscreenCapture();
+
+    /**
+     * \brief Whether an offscreen capture is running
+     * \return bool
+     */
+    bool isCapturing() const;
+
 protected:
 
-    // Timer for update the interface
-    QTimer _timer;
+    /// Viewer rendering the scene into the offscreen pbuffer while capturing
+    osg::ref_ptr<osgViewer::Viewer> _offscreenViewer;
+
+    /// Reads back the frames of the offscreen viewer
+    osg::ref_ptr<osgGolems::FrameCapture> _frameCapture;
+
+    /**
+     * \brief Renders one frame of the offscreen viewer. The scene is updated by
+     * this viewer instead of the offscreen one, so a multi-threaded viewer never
+     * draws nodes another viewer's update traversal is changing.
+     * \return void
+     */
+    void _renderOffscreenFrame();
+
+    /**
+     * \brief Whether or not a view's camera manipulator asked for continuous
+     * updates, e.g. to animate, or events are waiting to be handled
+     * \return bool
+     */
+    bool _viewsNeedRedraw();
+
+    /// Single shot timer firing the next requested frame
+    QTimer _redrawTimer;
+
+    /// Timer rendering frames nobody requested, see setIdleRedrawInterval()
+    QTimer _idleTimer;
+
+    /// Time since the last frame was rendered
+    QElapsedTimer _frameClock;
+
+    bool _continuousRendering;   ///< Whether or not to keep rendering frames
+    double _maxFrameRate;        ///< Maximum frames per second, 0 for no limit
+    size_t _numFramesRendered;   ///< Frames rendered since the last resetFrameStats()
+    size_t _numFramesSkipped;    ///< Redraw requests merged into a scheduled frame
+
+    GripProfiler* _profiler;     ///< Profiler frames are timed in, or NULL
+    size_t _phaseFrame;          ///< Profiler phase of a whole frame
 
     /**
      * \brief Determines if the input view number is valid,
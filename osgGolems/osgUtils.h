@@ -154,65 +154,61 @@ inline void addWireFrameMode(osg::Node* node)
 }
 
 /**
- * \brief Turns on wireframe mode for the passed in node
- * If it doesn't have a wireframe mode, one is created.
- * \param node Node for which to turn on wireframe mode
+ * \brief Makes a shallow copy of a node's StateSet to change and then swap in
+ * with setStateSet(), instead of changing the StateSet in place. A multi-threaded
+ * viewer may still be drawing the previous frame with the old StateSet, which stays
+ * alive until the viewer's delete handler releases it.
+ * \param node Node whose StateSet to copy
+ * \return osg::StateSet* Copy of the node's StateSet, or a new one if it had none
+ */
+inline osg::StateSet* copyStateSet(osg::Node* node)
+{
+    if(node->getStateSet()) {
+        return new osg::StateSet(*node->getStateSet(), osg::CopyOp::SHALLOW_COPY);
+    }
+    return new osg::StateSet;
+}
+
+/**
+ * \brief Sets the polygon mode of the passed in node, replacing its StateSet
+ * \param node Node for which to set the polygon mode
+ * \param mode osg::PolygonMode::LINE for wireframe or osg::PolygonMode::FILL
  * \return void
  */
-inline void setWireFrameOn(osg::Node* node)
+inline void setPolygonMode(osg::Node* node, osg::PolygonMode::Mode mode)
 {
     if(!node) {
         std::cerr << "Invalid node. Line " << __LINE__ << " of " << __FILE__ << std::endl;
         return;
     }
 
-    if(!node->getStateSet()) {
-        addWireFrameMode(node);
-    }
-
-    osg::PolygonMode* polyModeObj;
-    polyModeObj = dynamic_cast<osg::PolygonMode*>(node->getStateSet()->
-                                                  getAttribute(osg::StateAttribute::POLYGONMODE));
-
-    if(!polyModeObj) {
-        polyModeObj = new osg::PolygonMode;
-        node->getStateSet()->setAttribute(polyModeObj);
-    }
+    osg::ref_ptr<osg::StateSet> stateSet = copyStateSet(node);
+    stateSet->setAttribute(new osg::PolygonMode(osg::PolygonMode::FRONT_AND_BACK, mode));
+    node->setStateSet(stateSet);
+}
 
-    polyModeObj->setMode(osg::PolygonMode::FRONT_AND_BACK, osg::PolygonMode::LINE);
+/**
+ * \brief Turns on wireframe mode for the passed in node
+ * \param node Node for which to turn on wireframe mode
+ * \return void
+ */
+inline void setWireFrameOn(osg::Node* node)
+{
+    setPolygonMode(node, osg::PolygonMode::LINE);
 }
 
 /**
  * \brief Turns off wireframe mode for the passed in node
- * If it doesn't have a wireframe mode, one is created.
  * \param node Node for which to turn off wireframe mode
  * \return void
  */
 inline void setWireFrameOff(osg::Node* node)
 {
-    if(!node) {
-        std::cerr << "Invalid node. Line " << __LINE__ << " of " << __FILE__ << std::endl;
-        return;
-    }
-
-    if(!node->getStateSet()) {
-        addWireFrameMode(node);
-    }
-
-    osg::PolygonMode* polyModeObj;
-    polyModeObj = dynamic_cast<osg::PolygonMode*>(node->getStateSet()->
-                                                  getAttribute(osg::StateAttribute::POLYGONMODE));
-
-    if(!polyModeObj) {
-        polyModeObj = new osg::PolygonMode;
-        node->getStateSet()->setAttribute(polyModeObj);
-    }
-
-    polyModeObj->setMode(osg::PolygonMode::FRONT_AND_BACK, osg::PolygonMode::FILL);
+    setPolygonMode(node, osg::PolygonMode::FILL);
 }
 
 /**
- * \brief Set the transparency value of a node
+ * \brief Set the transparency value of a node, replacing its StateSet and material
  * Reference: OSG Cookbook p. 239
  * \param node Node of which to change the transparency value
  * \param transparencyValue New transparency value for the node (between 0 and 1)
@@ -220,17 +216,22 @@ inline void setWireFrameOff(osg::Node* node)
  */
 inline void setTransparency(osg::Node* node, float transparencyValue)
 {
-    if(!node->getOrCreateStateSet()->getAttribute(osg::StateAttribute::MATERIAL)) {
-        node->getOrCreateStateSet()->setAttribute(new osg::Material);
+    osg::ref_ptr<osg::StateSet> stateSet = copyStateSet(node);
+
+    osg::ref_ptr<osg::Material> mat;
+    osg::Material* oldMat = dynamic_cast<osg::Material*>(stateSet->getAttribute(osg::StateAttribute::MATERIAL));
+    if(oldMat) {
+        mat = new osg::Material(*oldMat);
+    } else {
+        mat = new osg::Material;
         std::cerr << "Created new material" << std::endl;
     }
-    if(!node->getOrCreateStateSet()->getAttribute(osg::StateAttribute::BLENDFUNC)) {
-        node->getOrCreateStateSet()->setAttributeAndModes(new osg::BlendFunc);
+    if(!stateSet->getAttribute(osg::StateAttribute::BLENDFUNC)) {
+        stateSet->setAttributeAndModes(new osg::BlendFunc);
         std::cerr << "Created new blendfunc" << std::endl;
     }
 
-    node->getOrCreateStateSet()->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
-    osg::ref_ptr<osg::Material> mat = (osg::Material*)node->getOrCreateStateSet()->getAttribute(osg::StateAttribute::MATERIAL);
+    stateSet->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
     osg::Vec4 diffuse = mat->getDiffuse(osg::Material::FRONT_AND_BACK);
     std::cerr << "Diffuse: " << diffuse << std::endl;
     std::cerr << "Ambient: " << mat->getAmbient(osg::Material::FRONT_AND_BACK) << std::endl;
@@ -240,7 +241,8 @@ inline void setTransparency(osg::Node* node, float transparencyValue)
     diffuse.set(diffuse.r(), diffuse.g(), diffuse.b(), transparencyValue);
     mat->setDiffuse(osg::Material::FRONT_AND_BACK, diffuse);
 //    mat->setAlpha(osg::Material::FRONT_AND_BACK, transparencyValue);
-    node->getOrCreateStateSet()->setAttributeAndModes(mat, osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+    stateSet->setAttributeAndModes(mat, osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+    node->setStateSet(stateSet);
 }
 
 } // end of osgGolems namespace
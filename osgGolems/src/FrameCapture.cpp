@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Local includes
+#include "FrameCapture.h"
+
+// OpenSceneGraph includes
+#include <osg/BufferObject>
+#include <osg/GraphicsContext>
+#include <osg/Image>
+
+// C++ Standard includes
+#include <cstring>
+#include <iostream>
+
+using namespace osgGolems;
+
+//-----------------------------------------------
+//            PUBLIC MEMBER FUNCTIONS
+//-----------------------------------------------
+
+FrameCapture::FrameCapture(int width, int height, uint numFramesInFlight)
+    : _width(width), _height(height), _numFramesInFlight(numFramesInFlight),
+      _current(0), _contextID(0), _flush(false)
+{
+    if (_numFramesInFlight < 1) {
+        _numFramesInFlight = 1;
+    }
+}
+
+FrameCapture::~FrameCapture()
+{
+    // Buffers can only be deleted with their context current, which is what flush is for
+    if (!_pixelBuffers.empty()) {
+        std::cerr << "[FrameCapture] Destroyed with frames in flight. Call flush and draw once first" << std::endl;
+    }
+}
+
+void FrameCapture::operator()(osg::RenderInfo& renderInfo) const
+{
+    osg::GraphicsContext* gc = renderInfo.getState()->getGraphicsContext();
+    glReadBuffer(gc->getTraits()->doubleBuffer ? GL_BACK : GL_FRONT);
+
+    bool flush;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        flush = _flush;
+    }
+
+    _contextID = renderInfo.getContextID();
+    osg::GLBufferObject::Extensions* ext = osg::GLBufferObject::getExtensions(_contextID, true);
+
+    if (!ext->isPBOSupported()) {
+        if (!flush) {
+            _readPixels();
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        _flush = false;
+        return;
+    }
+
+    if (flush) {
+        // Drain the ring oldest first, then give the buffers back
+        for (uint i=0; i<_pixelBuffers.size(); ++i) {
+            uint index = (_current + i) % _pixelBuffers.size();
+            if (_pending[index]) {
+                _mapPixelBuffer(index);
+            }
+        }
+        ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
+        if (!_pixelBuffers.empty()) {
+            ext->glDeleteBuffers(_pixelBuffers.size(), &_pixelBuffers[0]);
+        }
+        _pixelBuffers.clear();
+        _pending.clear();
+        _current = 0;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _flush = false;
+        return;
+    }
+
+    if (_pixelBuffers.empty()) {
+        _pixelBuffers.resize(_numFramesInFlight);
+        _pending.assign(_numFramesInFlight, false);
+        ext->glGenBuffers(_numFramesInFlight, &_pixelBuffers[0]);
+        for (uint i=0; i<_numFramesInFlight; ++i) {
+            ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, _pixelBuffers[i]);
+            ext->glBufferData(GL_PIXEL_PACK_BUFFER_ARB, _width * _height * 4, 0, GL_STREAM_READ_ARB);
+        }
+    }
+
+    // Queue the read of this frame. With a pack buffer bound it returns right away
+    ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, _pixelBuffers[_current]);
+    glReadPixels(0, 0, _width, _height, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+    _pending[_current] = true;
+
+    // The next buffer in the ring holds the oldest frame, which is done by now
+    _current = (_current + 1) % _pixelBuffers.size();
+    if (_pending[_current]) {
+        _mapPixelBuffer(_current);
+    }
+    ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
+}
+
+void FrameCapture::flush()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _flush = true;
+}
+
+bool FrameCapture::takeFrame(QImage& image)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_frames.empty()) {
+        return false;
+    }
+    image = _frames.front();
+    _frames.pop_front();
+    return true;
+}
+
+size_t FrameCapture::getNumFrames() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _frames.size();
+}
+
+//-----------------------------------------------
+//          PROTECTED MEMBER FUNCTIONS
+//-----------------------------------------------
+
+void FrameCapture::_mapPixelBuffer(uint index) const
+{
+    osg::GLBufferObject::Extensions* ext = osg::GLBufferObject::getExtensions(_contextID, true);
+    ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, _pixelBuffers[index]);
+    const uchar* pixels = (const uchar*)ext->glMapBuffer(GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB);
+    _pending[index] = false;
+    if (!pixels) {
+        std::cerr << "[FrameCapture] Could not map pixel buffer " << index << ". Dropping frame" << std::endl;
+        return;
+    }
+
+    // BGRA bytes are QImage's RGB32 layout. OpenGL rows start at the bottom
+    QImage image(_width, _height, QImage::Format_RGB32);
+    for (int row=0; row<_height; ++row) {
+        memcpy(image.scanLine(_height - 1 - row), pixels + row * _width * 4, _width * 4);
+    }
+    ext->glUnmapBuffer(GL_PIXEL_PACK_BUFFER_ARB);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _frames.push_back(image);
+}
+
+void FrameCapture::_readPixels() const
+{
+    QImage image(_width, _height, QImage::Format_RGB32);
+    glReadPixels(0, 0, _width, _height, GL_BGRA, GL_UNSIGNED_BYTE, image.bits());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _frames.push_back(image.mirrored());
+}
@@ -45,11 +45,54 @@
 // Local includes
 #include "Grid.h"
 
+// OpenSceneGraph includes
+#include <osg/Program>
+#include <osg/Shader>
+#include <osg/BlendFunc>
+#include <osg/Depth>
+
 // C++ Standard includes
 #include <iostream>
 
 using namespace osgGolems;
 
+// Moves the unit quad under the camera and scales it to the fade distance.
+// osg_ViewMatrixInverse is set by osgUtil::SceneView for every camera.
+static const char* infiniteGridVertexSource =
+    "#version 120\n"
+    "uniform mat4 osg_ViewMatrixInverse;\n"
+    "uniform float fadeDistance;\n"
+    "varying vec2 gridCoord;\n"
+    "varying float eyeDistance;\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 eye = osg_ViewMatrixInverse[3].xy;\n"
+    "    vec4 vertex = vec4(eye + gl_Vertex.xy * fadeDistance, 0.0, 1.0);\n"
+    "    gridCoord = vertex.xy;\n"
+    "    eyeDistance = length((gl_ModelViewMatrix * vertex).xyz);\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vertex;\n"
+    "}\n";
+
+// Antialiased lines from the screen space derivative of the grid coordinates
+static const char* infiniteGridFragmentSource =
+    "#version 120\n"
+    "uniform float gridSize;\n"
+    "uniform float fadeDistance;\n"
+    "uniform vec4 gridColor;\n"
+    "varying vec2 gridCoord;\n"
+    "varying float eyeDistance;\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 coord = gridCoord / gridSize;\n"
+    "    vec2 grid = abs(fract(coord - 0.5) - 0.5) / fwidth(coord);\n"
+    "    float line = 1.0 - min(min(grid.x, grid.y), 1.0);\n"
+    "    float fade = 1.0 - smoothstep(0.25 * fadeDistance, fadeDistance, eyeDistance);\n"
+    "    float alpha = gridColor.a * line * fade;\n"
+    "    if (alpha <= 0.0)\n"
+    "        discard;\n"
+    "    gl_FragColor = vec4(gridColor.rgb, alpha);\n"
+    "}\n";
+
 //-----------------------------------------------
 //            PUBLIC MEMBER FUNCTIONS
 //-----------------------------------------------
@@ -69,20 +112,19 @@ Grid::Grid(uint width, uint depth, uint gridSize, const osg::Vec4& color)
     // Create the perimter vertices and connect them with lines
     _createVertices(width, depth, _makeEven(gridSize));
     _drawGrid(color);
+
+    // setGridColor() changes the color array, which a draw thread may be reading
+    this->setDataVariance(osg::Object::DYNAMIC);
 }
 
 Grid::~Grid(){}
 
 void Grid::setGridColor(const osg::Vec4& color)
 {
-    // Loop through color array and assign input color to it.
-    for (size_t i=0; i<_colors->size(); ++i) {
-        _colors->at(i) = color;
-    }
-
-    // Set color array of the Grid and bind it to the lines
-    this->setColorArray(_colors);
-    this->setColorBinding(osg::Geometry::BIND_PER_PRIMITIVE_SET);
+    // One color for all the lines
+    (*_colors)[0] = color;
+    _colors->dirty();
+    this->dirtyDisplayList();
 }
 
 
@@ -105,8 +147,9 @@ void Grid::_createVertices(uint width, uint depth, uint gridSize)
     int halfwidth = numLinesWidth * gridSize;
     int halfdepth = numLinesDepth * gridSize;
 
-    // Resize vertex array
-    _verts->resize(numLinesWidth*2 + numLinesDepth*2);
+    // Reserve room for the endpoints. Resizing would leave zeroed vertices in front of them
+    _verts->clear();
+    _verts->reserve(numLinesWidth*2 + numLinesDepth*2);
 
     // Create endpoints of width lines
     for (int w=-halfwidth; w<=halfwidth;) {
@@ -127,18 +170,13 @@ void Grid::_createVertices(uint width, uint depth, uint gridSize)
 
 void Grid::_drawGrid(const osg::Vec4& color)
 {
-    for (size_t l=0; l<_verts->size()-1;) {
-        osg::DrawElementsUShort* elem = new osg::DrawElementsUShort(osg::PrimitiveSet::LINES, 0);
-        elem->push_back(l);
-        elem->push_back(l+1);
-        this->addPrimitiveSet(elem);
-        _colors->push_back(color);
-        l += 2;
-    }
+    // Every pair of vertices is a line, so the whole grid is a single draw call
+    this->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, _verts->size()));
 
-    // Set color array of the Grid and bind it to the lines
+    // Set color array of the Grid and bind it to all the lines
+    _colors->push_back(color);
     this->setColorArray(_colors);
-    this->setColorBinding(osg::Geometry::BIND_PER_PRIMITIVE_SET);
+    this->setColorBinding(osg::Geometry::BIND_OVERALL);
 }
 
 uint Grid::_makeEven(uint num)
@@ -150,3 +188,83 @@ uint Grid::_makeEven(uint num)
         return ++num;
     }
 }
+
+//-----------------------------------------------
+//                INFINITE GRID
+//-----------------------------------------------
+
+InfiniteGrid::InfiniteGrid(float gridSize, float fadeDistance, const osg::Vec4& color)
+{
+    _gridSize = new osg::Uniform("gridSize", gridSize);
+    _fadeDistance = new osg::Uniform("fadeDistance", fadeDistance);
+    _gridColor = new osg::Uniform("gridColor", color);
+
+    _createGrid();
+}
+
+InfiniteGrid::~InfiniteGrid(){}
+
+void InfiniteGrid::setGridColor(const osg::Vec4& color)
+{
+    _gridColor->set(color);
+}
+
+void InfiniteGrid::setGridSize(float gridSize)
+{
+    if (gridSize <= 0) {
+        std::cerr << "[InfiniteGrid] Grid size must be positive" << std::endl;
+        return;
+    }
+    _gridSize->set(gridSize);
+}
+
+void InfiniteGrid::setFadeDistance(float fadeDistance)
+{
+    if (fadeDistance <= 0) {
+        std::cerr << "[InfiniteGrid] Fade distance must be positive" << std::endl;
+        return;
+    }
+    _fadeDistance->set(fadeDistance);
+}
+
+//-----------------------------------------------
+//          PROTECTED MEMBER FUNCTIONS
+//-----------------------------------------------
+
+void InfiniteGrid::_createGrid()
+{
+    // Unit quad in the ground plane. The vertex shader places and scales it.
+    osg::ref_ptr<osg::Vec3Array> verts = new osg::Vec3Array;
+    verts->push_back(osg::Vec3(-1, -1, 0));
+    verts->push_back(osg::Vec3( 1, -1, 0));
+    verts->push_back(osg::Vec3(-1,  1, 0));
+    verts->push_back(osg::Vec3( 1,  1, 0));
+
+    osg::Geometry* quad = new osg::Geometry;
+    quad->setVertexArray(verts);
+    quad->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLE_STRIP, 0, verts->size()));
+    quad->setUseDisplayList(false);
+    this->addDrawable(quad);
+
+    // The quad moves in the shader, so its bound is meaningless for culling
+    this->setCullingActive(false);
+
+    osg::Program* program = new osg::Program;
+    program->addShader(new osg::Shader(osg::Shader::VERTEX, infiniteGridVertexSource));
+    program->addShader(new osg::Shader(osg::Shader::FRAGMENT, infiniteGridFragmentSource));
+
+    // The setters change the uniforms, which a draw thread may be applying
+    osg::StateSet* state = this->getOrCreateStateSet();
+    state->setDataVariance(osg::Object::DYNAMIC);
+    state->setAttributeAndModes(program, osg::StateAttribute::ON);
+    state->addUniform(_gridSize);
+    state->addUniform(_fadeDistance);
+    state->addUniform(_gridColor);
+
+    // Blend over the scene without hiding anything drawn after it
+    state->setAttributeAndModes(new osg::BlendFunc(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE_MINUS_SRC_ALPHA));
+    state->setAttributeAndModes(new osg::Depth(osg::Depth::LESS, 0, 1, false));
+    state->setMode(GL_CULL_FACE, osg::StateAttribute::OFF);
+    state->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::PROTECTED);
+    state->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+}
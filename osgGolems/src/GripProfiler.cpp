@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Local includes
+#include "GripProfiler.h"
+
+// C++ Standard includes
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+const double GripProfiler::minDuration = 1e-7;
+
+GripProfiler::GripProfiler()
+    : _numPhases(0),
+      _enabled(true)
+{
+    _phases.reserve(maxPhases);
+}
+
+GripProfiler::~GripProfiler()
+{
+    for (size_t i=0; i<_phases.size(); ++i) {
+        delete _phases[i];
+    }
+}
+
+void GripProfiler::setEnabled(bool enabled)
+{
+    _enabled = enabled;
+}
+
+bool GripProfiler::isEnabled() const
+{
+    return _enabled;
+}
+
+size_t GripProfiler::getNumPhases() const
+{
+    return _numPhases;
+}
+
+GripPhaseStats GripProfiler::getStats(size_t phase) const
+{
+    GripPhaseStats stats;
+    stats.count = 0;
+    stats.total = 0;
+    stats.mean = 0;
+    stats.p50 = 0;
+    stats.p99 = 0;
+    stats.max = 0;
+    if (phase >= _numPhases) {
+        return stats;
+    }
+
+    const GripProfilePhase* p = _phases[phase];
+    std::lock_guard<std::mutex> lock(p->mutex);
+    stats.name = p->name;
+    stats.count = p->count;
+    stats.total = p->total;
+    stats.max = p->max;
+    if (p->count > 0) {
+        stats.mean = p->total / p->count;
+        stats.p50 = _percentile(*p, 0.5);
+        stats.p99 = _percentile(*p, 0.99);
+    }
+    return stats;
+}
+
+void GripProfiler::reset()
+{
+    for (size_t i=0; i<_numPhases; ++i) {
+        GripProfilePhase* p = _phases[i];
+        std::lock_guard<std::mutex> lock(p->mutex);
+        std::fill(p->histogram.begin(), p->histogram.end(), 0);
+        p->count = 0;
+        p->total = 0;
+        p->max = 0;
+    }
+}
+
+bool GripProfiler::writeCsv(const std::string& fileName) const
+{
+    std::ofstream file(fileName.c_str());
+    if (!file.is_open()) {
+        std::cerr << "[GripProfiler] Couldn't open " << fileName << " for writing" << std::endl;
+        return false;
+    }
+
+    file << "phase,count,total_us,mean_us,p50_us,p99_us,max_us\n";
+    for (size_t i=0; i<_numPhases; ++i) {
+        GripPhaseStats stats = getStats(i);
+        if (stats.count == 0) {
+            continue;
+        }
+        file << "\"" << stats.name << "\","
+             << stats.count << ","
+             << 1e6 * stats.total << ","
+             << 1e6 * stats.mean << ","
+             << 1e6 * stats.p50 << ","
+             << 1e6 * stats.p99 << ","
+             << 1e6 * stats.max << "\n";
+    }
+
+    return file.good();
+}
+
+double GripProfiler::_bucketUpperBound(int bucket)
+{
+    if (bucket <= 0) {
+        return minDuration;
+    }
+    // Inverse of _bucket(): the octave and the position within it
+    int e = (bucket - 1) / bucketsPerOctave + 1;
+    int sub = (bucket - 1) % bucketsPerOctave;
+    double m = 0.5 + 0.5 * (sub + 1) / bucketsPerOctave;
+    return std::ldexp(minDuration * m, e);
+}
+
+double GripProfiler::_percentile(const GripProfilePhase& phase, double fraction)
+{
+    // Rank of the duration we're after, counting from 1
+    size_t rank = (size_t)std::ceil(fraction * phase.count);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    size_t seen = 0;
+    for (int i=0; i<numBuckets; ++i) {
+        seen += phase.histogram[i];
+        if (seen >= rank) {
+            double upper = _bucketUpperBound(i);
+            return (upper < phase.max ? upper : phase.max);
+        }
+    }
+    return phase.max;
+}
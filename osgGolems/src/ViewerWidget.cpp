@@ -53,6 +53,13 @@
 // OpenSceneGraph includes
 #include <osg/io_utils>
 #include <osg/ShapeDrawable>
+#include <osg/DeleteHandler>
+
+// QT includes
+#include <QtGui/QMouseEvent>
+
+// Standard includes
+#include <cstdlib>
 
 
 void ViewerWidget::addGrid(uint width, uint depth, uint gridSize)
@@ -65,18 +72,21 @@ void ViewerWidget::addGrid(uint width, uint depth, uint gridSize)
     addNodeToScene(gridGeode);
 }
 
-ViewerWidget::ViewerWidget(osgViewer::ViewerBase::ThreadingModel threadingModel) : QWidget()
+void ViewerWidget::addInfiniteGrid(float gridSize, float fadeDistance)
 {
-//    switch(threadingModel) {
-//        case 0: std::cerr << "SingleThreaded" << std::endl; break;
-//        case 1: std::cerr << "CullDrawThreadPerContext" << std::endl; break;
-//        case 2: std::cerr << "ThreadPerContext" << std::endl; break;
-//        case 3: std::cerr << "DrawThreadPerContext" << std::endl; break;
-//        case 4: std::cerr << "CullThreadPerCameraDrawThreadPerContext" << std::endl; break;
-//    }
-    /// regardless of the threadingModel passed, we are using SingleThreaded for now, which does not cause problems yet.
-    /// In some platforms, auto-selected threading model causes some problems
-    setThreadingModel(osgViewer::ViewerBase::SingleThreaded);
+    addNodeToScene(new osgGolems::InfiniteGrid(gridSize, fadeDistance, osg::Vec4(.3, .3, .3, .5)));
+}
+
+ViewerWidget::ViewerWidget(osgViewer::ViewerBase::ThreadingModel threadingModel)
+    : QWidget(),
+      _continuousRendering(false),
+      _maxFrameRate(60),
+      _numFramesRendered(0),
+      _numFramesSkipped(0),
+      _profiler(NULL),
+      _phaseFrame(0)
+{
+    setViewerThreadingModel(threadingModel);
     this->setRunFrameScheme(osgViewer::CompositeViewer::ON_DEMAND);
 
     // Create scene data
@@ -91,8 +101,167 @@ ViewerWidget::ViewerWidget(osgViewer::ViewerBase::ThreadingModel threadingModel)
     layout->addWidget(widget1);
     setLayout(layout);
 
-    connect(&_timer, SIGNAL(timeout()), this, SLOT(update()));
-    _timer.start(1);
+    // Frames are only rendered when something asks for one
+    if (widget1) {
+        widget1->installEventFilter(this);
+    }
+    _redrawTimer.setSingleShot(true);
+    connect(&_redrawTimer, SIGNAL(timeout()), this, SLOT(update()));
+    connect(&_idleTimer, SIGNAL(timeout()), this, SLOT(update()));
+    _frameClock.start();
+    requestRedraw();
+}
+
+void ViewerWidget::setViewerThreadingModel(osgViewer::ViewerBase::ThreadingModel threadingModel)
+{
+    if (threadingModel == osgViewer::ViewerBase::AutomaticSelection) {
+        threadingModel = (getenv("OSG_THREADING") ? this->suggestBestThreadingModel()
+                                                  : osgViewer::ViewerBase::SingleThreaded);
+    }
+
+    // Nodes removed from the scene can still be in the frame the draw thread is
+    // drawing, so keep deleted objects around for a couple of frames
+    if (threadingModel != osgViewer::ViewerBase::SingleThreaded && !osg::Referenced::getDeleteHandler()) {
+        osg::Referenced::setDeleteHandler(new osg::DeleteHandler(2));
+    }
+
+    // Stops and restarts the graphics threads if the viewer is already realized
+    this->setThreadingModel(threadingModel);
+}
+
+const char* ViewerWidget::getThreadingModelName(osgViewer::ViewerBase::ThreadingModel threadingModel)
+{
+    switch (threadingModel) {
+        case osgViewer::ViewerBase::SingleThreaded: return "SingleThreaded";
+        case osgViewer::ViewerBase::CullDrawThreadPerContext: return "CullDrawThreadPerContext";
+        case osgViewer::ViewerBase::DrawThreadPerContext: return "DrawThreadPerContext";
+        case osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext: return "CullThreadPerCameraDrawThreadPerContext";
+        case osgViewer::ViewerBase::AutomaticSelection: return "AutomaticSelection";
+    }
+    return "Unknown";
+}
+
+void ViewerWidget::paintEvent(QPaintEvent* event)
+{
+    _frameClock.restart();
+    {
+        GripScopedTimer timer(_profiler, _phaseFrame);
+        frame();
+    }
+    ++_numFramesRendered;
+
+    if (_continuousRendering || _viewsNeedRedraw()) {
+        requestRedraw();
+    }
+}
+
+bool ViewerWidget::eventFilter(QObject* object, QEvent* event)
+{
+    switch (event->type()) {
+        case QEvent::MouseMove:
+            // Only drags change anything
+            if (static_cast<QMouseEvent*>(event)->buttons() != Qt::NoButton) {
+                requestRedraw();
+            }
+            break;
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseButtonRelease:
+        case QEvent::MouseButtonDblClick:
+        case QEvent::Wheel:
+        case QEvent::KeyPress:
+        case QEvent::KeyRelease:
+        case QEvent::Resize:
+        case QEvent::Show:
+            requestRedraw();
+            break;
+        default:
+            break;
+    }
+    return QWidget::eventFilter(object, event);
+}
+
+void ViewerWidget::requestRedraw()
+{
+    if (_redrawTimer.isActive()) {
+        ++_numFramesSkipped;
+        return;
+    }
+
+    // Wait out the rest of the frame period to stay under the maximum frame rate
+    int delay = 0;
+    if (_maxFrameRate > 0) {
+        delay = (int)(1000.0 / _maxFrameRate) - (int)_frameClock.elapsed();
+        if (delay < 0) {
+            delay = 0;
+        }
+    }
+    _redrawTimer.start(delay);
+}
+
+void ViewerWidget::setContinuousRendering(bool continuous)
+{
+    _continuousRendering = continuous;
+    if (continuous) {
+        requestRedraw();
+    }
+}
+
+bool ViewerWidget::isRenderingContinuously() const
+{
+    return _continuousRendering;
+}
+
+void ViewerWidget::setMaxFrameRate(double fps)
+{
+    _maxFrameRate = (fps > 0 ? fps : 0);
+}
+
+double ViewerWidget::getMaxFrameRate() const
+{
+    return _maxFrameRate;
+}
+
+void ViewerWidget::setIdleRedrawInterval(int msec)
+{
+    if (msec > 0) {
+        _idleTimer.start(msec);
+    } else {
+        _idleTimer.stop();
+    }
+}
+
+size_t ViewerWidget::getNumFramesRendered() const
+{
+    return _numFramesRendered;
+}
+
+size_t ViewerWidget::getNumFramesSkipped() const
+{
+    return _numFramesSkipped;
+}
+
+void ViewerWidget::resetFrameStats()
+{
+    _numFramesRendered = 0;
+    _numFramesSkipped = 0;
+}
+
+void ViewerWidget::setProfiler(GripProfiler* profiler)
+{
+    _profiler = profiler;
+    if (_profiler) {
+        _phaseFrame = _profiler->addPhase("render: frame");
+    }
+}
+
+bool ViewerWidget::_viewsNeedRedraw()
+{
+    for (uint i = 0; i < this->getNumViews(); ++i) {
+        if (this->getView(i)->getRequestContinousUpdate()) {
+            return true;
+        }
+    }
+    return this->checkEvents();
 }
 
 QWidget* ViewerWidget::addViewWidget(osg::Camera* camera, osg::Node* scene)
@@ -162,6 +331,7 @@ void ViewerWidget::setViewMatrix(uint i, osg::Matrixd m)
         osg::ref_ptr<osgGA::OrbitManipulator> c =
             dynamic_cast<osgGA::OrbitManipulator*>(this->getView(i)->getCameraManipulator());
         c->setCenter(osg::Vec3f(0, 0, 0));
+        requestRedraw();
     }
 }
 
@@ -210,6 +380,7 @@ void ViewerWidget::setCameraMatrix(osg::Matrix& newMatrix, uint viewNum)
         osg::ref_ptr<osgGA::OrbitManipulator> c =
             dynamic_cast<osgGA::OrbitManipulator*>(this->getCameraManipulator(viewNum));
         c->setCenter(osg::Vec3f(0, 0, 0));
+        requestRedraw();
     }
 }
 
@@ -238,6 +409,7 @@ void ViewerWidget::addNodeToScene(osg::Node* node, uint viewNum)
                   << std::endl;
     } else {
         scene->addChild(node);
+        requestRedraw();
     }
 }
 
@@ -254,6 +426,7 @@ void ViewerWidget::removeNodeFromScene(osg::Node* node, uint viewNum)
                   << std::endl;
     } else {
         scene->removeChild(node);
+        requestRedraw();
     }
 }
 
@@ -262,6 +435,7 @@ void ViewerWidget::setBackgroundColor(const osg::Vec4 &color, uint viewNum)
     // If the view number is valid, set the background color the view's camera
     if (viewNumIsValid(viewNum)) {
         this->getView(viewNum)->getCamera()->setClearColor(color);
+        requestRedraw();
     }
 }
 
@@ -280,6 +454,7 @@ void ViewerWidget::setCameraToHomePosition(uint viewNum)
 {
     if (viewNumIsValid(viewNum)) {
         this->getCameraManipulator(viewNum)->home(1.0);
+        requestRedraw();
     }
 }
 
@@ -301,11 +476,122 @@ QImage ViewerWidget::takeScreenshot()
     osg::Camera* camera = view->getCamera();
     osgQt::GraphicsWindowQt* gw = dynamic_cast<osgQt::GraphicsWindowQt*>(camera->getGraphicsContext());
     QGLWidget* glw = gw->getGLWidget();
+
+    // The draw thread has the context current, so take it back while grabbing
+    bool threaded = this->areThreadsRunning();
+    if (threaded) {
+        this->stopThreading();
+    }
     //QSize cur_size = glw->size();
     //glw->resize(1280, 712);
     //glw->update();
     //std::cerr<<glw->size().width()<<" "<<glw->size().height()<<std::endl;
     QImage screenshot = glw->grabFrameBuffer();
     //glw->resize(cur_size);
+    if (threaded) {
+        this->startThreading();
+    }
     return screenshot;
 }
+
+bool ViewerWidget::startOffscreenCapture(int width, int height, uint numFramesInFlight)
+{
+    if (_offscreenViewer.valid()) {
+        stopOffscreenCapture();
+    }
+
+    osg::DisplaySettings* ds = osg::DisplaySettings::instance().get();
+
+    // Single buffered pbuffer, so there's no window and the size is exact
+    osg::ref_ptr<osg::GraphicsContext::Traits> traits = new osg::GraphicsContext::Traits;
+    traits->x = 0;
+    traits->y = 0;
+    traits->width = width;
+    traits->height = height;
+    traits->red = 8;
+    traits->green = 8;
+    traits->blue = 8;
+    traits->alpha = 8;
+    traits->depth = 24;
+    traits->stencil = ds->getMinimumNumStencilBits();
+    traits->sampleBuffers = ds->getMultiSamples();
+    traits->samples = ds->getNumMultiSamples();
+    traits->windowDecoration = false;
+    traits->doubleBuffer = false;
+    traits->pbuffer = true;
+
+    osg::ref_ptr<osg::GraphicsContext> gc = osg::GraphicsContext::createGraphicsContext(traits.get());
+    if (!gc.valid()) {
+        std::cerr << "[ViewerWidget] Could not create a " << width << "x" << height
+                  << " pbuffer for offscreen capture" << std::endl;
+        return false;
+    }
+
+    _frameCapture = new osgGolems::FrameCapture(width, height, numFramesInFlight);
+
+    _offscreenViewer = new osgViewer::Viewer;
+    _offscreenViewer->setThreadingModel(osgViewer::ViewerBase::SingleThreaded);
+    osg::Camera* camera = _offscreenViewer->getCamera();
+    camera->setGraphicsContext(gc.get());
+    camera->setViewport(new osg::Viewport(0, 0, width, height));
+    camera->setDrawBuffer(GL_FRONT);
+    camera->setReadBuffer(GL_FRONT);
+    camera->getOrCreateStateSet()->setGlobalDefaults();
+    camera->setFinalDrawCallback(_frameCapture.get());
+    _offscreenViewer->setSceneData(this->getView(0)->getSceneData());
+    _offscreenViewer->realize();
+
+    return true;
+}
+
+void ViewerWidget::captureFrame()
+{
+    if (!_offscreenViewer.valid()) {
+        return;
+    }
+
+    // Look through the first view's camera, keeping the capture's aspect ratio
+    osg::Camera* camera = this->getView(0)->getCamera();
+    osg::Camera* offscreen = _offscreenViewer->getCamera();
+    double fovy, aspectRatio, zNear, zFar;
+    camera->getProjectionMatrixAsPerspective(fovy, aspectRatio, zNear, zFar);
+    offscreen->setProjectionMatrixAsPerspective(fovy,
+        static_cast<double>(_frameCapture->getWidth())/static_cast<double>(_frameCapture->getHeight()),
+        zNear, zFar);
+    offscreen->setViewMatrix(camera->getViewMatrix());
+    offscreen->setClearColor(camera->getClearColor());
+
+    _renderOffscreenFrame();
+}
+
+bool ViewerWidget::takeCapturedFrame(QImage& image)
+{
+    return _frameCapture.valid() && _frameCapture->takeFrame(image);
+}
+
+void ViewerWidget::stopOffscreenCapture()
+{
+    if (!_offscreenViewer.valid()) {
+        return;
+    }
+
+    // One more draw maps the frames still in flight instead of reading a new one
+    _frameCapture->flush();
+    _renderOffscreenFrame();
+
+    _offscreenViewer->getCamera()->setFinalDrawCallback(NULL);
+    _offscreenViewer = NULL;
+}
+
+bool ViewerWidget::isCapturing() const
+{
+    return _offscreenViewer.valid();
+}
+
+void ViewerWidget::_renderOffscreenFrame()
+{
+    // Like in frame(), the graphics threads are done with the DYNAMIC nodes by now
+    this->updateTraversal();
+    _offscreenViewer->advance();
+    _offscreenViewer->renderingTraversals();
+}
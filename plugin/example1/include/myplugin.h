@@ -60,6 +60,7 @@ public:
      MyPlugin(QWidget *parent = 0);
     ~MyPlugin();
 
+    int getSubscribedEvents() const;
     void GRIPEventSceneLoaded();
     void GRIPEventSimulationBeforeTimestep();
     void GRIPEventSimulationAfterTimestep();
@@ -56,6 +56,15 @@ MyPlugin::MyPlugin(QWidget *parent) : ui(new Ui::MyPluginTab){
 
 MyPlugin::~MyPlugin(){}
 
+/**
+ * \brief Only the events this plugin does something in, so the simulation
+ * loop doesn't call the empty time step functions
+ */
+int MyPlugin::getSubscribedEvents() const
+{
+    return GRIP_EVENT_SCENE_LOADED | GRIP_EVENT_TREEVIEW_SELECTION_CHANGED;
+}
+
 void MyPlugin::GRIPEventSceneLoaded()
 {
     std::cerr << "Rotate LSP (Left Shoulder Pitch) 360 degrees and add it to the timeline" << std::endl;
@@ -78,7 +87,7 @@ void MyPlugin::GRIPEventSceneLoaded()
             skel->setConfig(index, jointValue);
 
             // Save world to timeline
-            _timeline->push_back(GripTimeslice(*_world));
+            _timeline->push_back(*_world);
         }
     } else {
         std::cerr << "No skeleton named GolemHubo" << std::endl;
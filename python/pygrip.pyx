@@ -4,6 +4,20 @@ from libc.stdlib cimport malloc, free
 from libcpp.string cimport string
 from libcpp.vector cimport vector
 
+import numpy as np
+
+cdef extern from "../include/GripRolloutEngine.h":
+    cdef struct GripRolloutMetrics:
+        int index
+        int success
+        int numSteps
+        double simTime
+        double realTime
+        double rmsError
+        double maxError
+        double maxTorque
+        double finalComHeight
+
 cdef extern from "../include/GripInterface.h":
     cdef cppclass GripInterface:
         GripInterface() except +
@@ -18,6 +32,17 @@ cdef extern from "../include/GripInterface.h":
         void simulateSingleStep()
         vector[double] getState()
         void setState(vector[double] state)
+        int runRollouts(string sceneFileName, int numSteps, vector[vector[double]] kp, vector[vector[double]] kd, int numThreads) nogil
+        vector[GripRolloutMetrics] getRolloutMetrics()
+        vector[double] getRolloutTimeline(int rollout)
+        int getRolloutSampleSize()
+        bint step(int numSteps, const double *torques, int numTorques, double *state) nogil
+        void updateStateBuffer(double *state)
+        void setStateFromBuffer(const double *state, int size)
+        int getStateSize()
+        int getTimelineLength()
+        int getTimelineStateSize()
+        int exportTimeline(double *times, double *states, int numRows)
 
 # Place static interface declarations here
 cdef extern from "../include/GripInterface.h" namespace "GripInterface":
@@ -96,4 +121,102 @@ cdef class PyGrip:
         return self.thisptr.getState()
 
     def setState(self, state):
-        self.thisptr.setState(state)
\ No newline at end of file
+        self.thisptr.setState(state)
+
+    def getStateArray(self):
+        '''
+        Returns the current state of the world as a new numpy array, filled
+        in C++ with a single copy and no per-element conversion.
+        '''
+        cdef int n = self.thisptr.getStateSize()
+        cdef double[::1] state = np.empty(n)
+        if n > 0:
+            self.thisptr.updateStateBuffer(&state[0])
+        return np.asarray(state)
+
+    def setStateArray(self, state):
+        '''
+        Sets the state of the world from a numpy array (or anything numpy can
+        convert), read in C++ without per-element conversion. An array
+        returned by getStateArray can be modified and passed back.
+        '''
+        cdef int n = self.thisptr.getStateSize()
+        cdef double[::1] src = np.ascontiguousarray(state, dtype=np.float64)
+        if src.shape[0] != n:
+            raise ValueError("state has %d values, the world state has %d" % (src.shape[0], n))
+        if n > 0:
+            self.thisptr.setStateFromBuffer(&src[0], n)
+
+    def step(self, numSteps=1, torques=None):
+        '''
+        Runs numSteps time steps on the simulation thread and returns the
+        resulting state as a new numpy array once they're done, without
+        polling or sleeping. The torques (one per DOF of the world, skeleton
+        after skeleton) are applied before every step; None leaves the forces
+        alone. The GIL is released while the steps run. Raises RuntimeError if
+        the steps couldn't run, e.g. while the simulation is running.
+        '''
+        cdef double[::1] c_torques
+        cdef const double* ptr = NULL
+        cdef int numTorques = 0
+        cdef int c_steps = numSteps
+        cdef bint ok
+        cdef int n = self.thisptr.getStateSize()
+        cdef double[::1] state = np.empty(max(n, 1))
+        if torques is not None:
+            c_torques = np.ascontiguousarray(torques, dtype=np.float64)
+            numTorques = c_torques.shape[0]
+            if numTorques > 0:
+                ptr = &c_torques[0]
+        with nogil:
+            ok = self.thisptr.step(c_steps, ptr, numTorques, &state[0])
+        if not ok:
+            raise RuntimeError("Couldn't step the simulation")
+        return np.asarray(state[:n])
+
+    def getTimeline(self):
+        '''
+        Returns the recorded timeline as a (times, states) pair of new numpy
+        arrays, with one state per row of the 2-D states array. The timeline
+        is copied once in C++ straight into the arrays, so there's no
+        per-element conversion. Raises RuntimeError while simulating.
+        '''
+        cdef int rows = self.thisptr.getTimelineLength()
+        cdef int cols = self.thisptr.getTimelineStateSize()
+        cdef double[::1] times = np.empty(max(rows, 1))
+        cdef double[:, ::1] states = np.empty((max(rows, 1), max(cols, 1)))
+        rows = self.thisptr.exportTimeline(&times[0], &states[0, 0], rows)
+        if rows < 0:
+            raise RuntimeError("Can't export the timeline while simulating")
+        return np.asarray(times[:rows]), np.asarray(states[:rows, :cols])
+
+    def runRollouts(self, sceneFileName, numSteps, kp, kd=None, numThreads=0):
+        '''
+        Runs one headless rollout of the scene per row of gains in parallel and
+        returns the number of rollouts that ran, or -1 if the scene couldn't be
+        loaded. kp and kd are lists (or 2-D arrays) with one gain per DOF of the
+        controlled skeleton in each row. The GIL is released while they run.
+        '''
+        cdef string c_scene = sceneFileName
+        cdef int c_steps = numSteps
+        cdef int c_threads = numThreads
+        cdef vector[vector[double]] c_kp = [list(row) for row in kp]
+        cdef vector[vector[double]] c_kd = [list(row) for row in (kd if kd is not None else [])]
+        cdef int ret
+        with nogil:
+            ret = self.thisptr.runRollouts(c_scene, c_steps, c_kp, c_kd, c_threads)
+        return ret
+
+    def getRolloutMetrics(self):
+        '''
+        Returns a list with a dict of summary metrics for each rollout of the
+        last runRollouts call
+        '''
+        return self.thisptr.getRolloutMetrics()
+
+    def getRolloutTimeline(self, rollout):
+        '''
+        Returns the recorded timeline of a rollout as a 2-D array with one row
+        per recorded state: the time followed by the world state
+        '''
+        return np.array(self.thisptr.getRolloutTimeline(rollout)).reshape(-1, self.thisptr.getRolloutSampleSize())
@@ -54,7 +54,7 @@
 // Local includes
 #include "TreeViewReturn.h"
 #include "../osgGolems/ViewerWidget.h"
-#include "../include/GripTimeslice.h"
+#include "../include/GripTimeline.h"
 
 // DART includes
 #include <dart/simulation/World.h>
@@ -63,6 +63,36 @@
 #include <QDockWidget>
 #include <QtPlugin>
 
+/**
+ * \enum gripEvent_t
+ * \brief Events a plugin can subscribe to. GripTab::getSubscribedEvents() returns
+ * the events a plugin wants combined with "|"
+ */
+typedef enum {
+    GRIP_EVENT_NONE                       = 0,       ///< No events
+    GRIP_EVENT_SCENE_LOADED               = 1 << 0,  ///< GRIPEventSceneLoaded()
+    GRIP_EVENT_SIMULATION_BEFORE_TIMESTEP = 1 << 1,  ///< GRIPEventSimulationBeforeTimestep()
+    GRIP_EVENT_SIMULATION_AFTER_TIMESTEP  = 1 << 2,  ///< GRIPEventSimulationAfterTimestep() or GRIPEventSimulationAfterTimestepAsync()
+    GRIP_EVENT_SIMULATION_START           = 1 << 3,  ///< GRIPEventSimulationStart()
+    GRIP_EVENT_SIMULATION_STOP            = 1 << 4,  ///< GRIPEventSimulationStop()
+    GRIP_EVENT_PLAYBACK_BEFORE_FRAME      = 1 << 5,  ///< GRIPEventPlaybackBeforeFrame()
+    GRIP_EVENT_PLAYBACK_AFTER_FRAME       = 1 << 6,  ///< GRIPEventPlaybackAfterFrame()
+    GRIP_EVENT_PLAYBACK_START             = 1 << 7,  ///< GRIPEventPlaybackStart()
+    GRIP_EVENT_PLAYBACK_STOP              = 1 << 8,  ///< GRIPEventPlaybackStop()
+    GRIP_EVENT_TREEVIEW_SELECTION_CHANGED = 1 << 9,  ///< GRIPEventTreeViewSelectionChanged()
+    GRIP_EVENT_ALL                        = (1 << 10) - 1 ///< Every event
+} gripEvent_t;
+
+/**
+ * \enum gripCallbackRate_t
+ * \brief How a plugin's simulation time step events are delivered
+ */
+typedef enum {
+    GRIP_CALLBACK_EVERY_STEP,    ///< Called on the simulation thread around every time step
+    GRIP_CALLBACK_EVERY_N_STEPS, ///< Called on the simulation thread every GripTab::getCallbackPeriod() time steps
+    GRIP_CALLBACK_ASYNC          ///< Snapshots of the state are queued to GRIPEventSimulationAfterTimestepAsync() on the plugin's own thread
+} gripCallbackRate_t;
+
 
 /**
  * \class GripTab GripTab.h
@@ -81,10 +111,10 @@ protected:
     /// pointer to simulation world object that is being rendered and simulated
     dart::simulation::World *_world;
 
-    /// pointer to the timeline, which holds a GripTimeslice objects.
-    /// These contain the state and time of the world. To use just call
-    /// timeline->push_back(GripTimeslice(*world));
-    std::vector<GripTimeslice> *_timeline;
+    /// pointer to the timeline, which holds the state and time of the world
+    /// for each timeslice. To use just call
+    /// timeline->push_back(*world);
+    GripTimeline *_timeline;
 
 public:
     /**
@@ -98,12 +128,12 @@ public:
      * \param ret Pointer to object returned by the TreeView
      * \param viewer Pointer to composite viewer object where things are rendered
 	 * \param world Pointer to the dart world simulation object
-	 * \param timeline Array of GripTimeslice object for simulation and kinematic playback
+	 * \param timeline Timeline of world states for simulation and kinematic playback
      */
     virtual void Load(TreeViewReturn *ret,
                       ViewerWidget *viewer,
                       dart::simulation::World *world,
-                      std::vector<GripTimeslice> *timeline)
+                      GripTimeline *timeline)
     {
         _activeNode = ret;
         _viewWidget = viewer;
@@ -111,6 +141,40 @@ public:
         _timeline = timeline;
     }
 
+    /**
+     * \brief Events the plugin wants to receive, combined with "|". Only subscribed
+     * events are called, so a plugin that doesn't need the time step events should
+     * leave them out to keep them off the simulation loop. Read when the plugin is
+     * loaded and whenever a simulation starts. Defaults to every event.
+     * \return int gripEvent_t flags
+     */
+    virtual int getSubscribedEvents() const { return GRIP_EVENT_ALL; }
+
+    /**
+     * \brief How the simulation time step events are delivered. With GRIP_CALLBACK_ASYNC
+     * GRIPEventSimulationBeforeTimestep() and GRIPEventSimulationAfterTimestep() aren't
+     * called. Instead a copy of the state after a time step is queued to
+     * GRIPEventSimulationAfterTimestepAsync(), which runs on a thread of the plugin's own,
+     * so slow work there never holds up the physics. Snapshots are dropped, oldest first,
+     * when the plugin falls behind.
+     * \return gripCallbackRate_t Callback rate. Defaults to every step
+     */
+    virtual gripCallbackRate_t getCallbackRate() const { return GRIP_CALLBACK_EVERY_STEP; }
+
+    /**
+     * \brief Number of time steps between time step events for GRIP_CALLBACK_EVERY_N_STEPS
+     * and GRIP_CALLBACK_ASYNC
+     * \return size_t Number of time steps. Defaults to 1
+     */
+    virtual size_t getCallbackPeriod() const { return 1; }
+
+    /**
+     * \brief Whether or not the plugin subscribed to an event
+     * \param event Event to check
+     * \return bool
+     */
+    bool isSubscribed(gripEvent_t event) const { return (getSubscribedEvents() & event) != 0; }
+
     /**
      * \brief called when a new scene file (urdf, sdf) is loaded into Grip.
      * This signifies that there are skeletons in the world, the viewer is displaying
@@ -130,6 +194,16 @@ public:
      */
     virtual void GRIPEventSimulationAfterTimestep(){}
 
+    /**
+     * \brief called on the plugin's own thread with a copy of the world state after
+     * a simulation time step, for plugins whose callback rate is GRIP_CALLBACK_ASYNC.
+     * The world is being stepped meanwhile, so use the state instead of reading _world,
+     * and don't touch widgets from here.
+     * \param time Simulation time of the state
+     * \param state World state, as in dart::simulation::World::getState()
+     */
+    virtual void GRIPEventSimulationAfterTimestepAsync(double time, const Eigen::VectorXd& state){}
+
     /**
      * \brief called from the main window whenever the simulation is executing
      * This method is executed at the start of the simulation
@@ -94,10 +94,10 @@ public:
     int getSliderValue();
 
     /**
-     * \brief returns the playback speed from the spinbox
-     * \return int
+     * \brief returns the playback speed from the spinbox, as a multiple of simulated time
+     * \return double
      */
-    size_t getPlaybackSpeed();
+    double getPlaybackSpeed();
 
     /// UI object which holds all the widgets
     Ui::PlaybackWidget *ui;
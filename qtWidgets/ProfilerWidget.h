@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file ProfilerWidget.h
+ * \brief Dock widget showing the timings of a GripProfiler
+ */
+
+#ifndef PROFILER_WIDGET_H
+#define PROFILER_WIDGET_H
+
+// Qt includes
+#include <QDockWidget>
+#include <QTableWidget>
+#include <QPushButton>
+#include <QTimer>
+
+// Local includes
+#include "GripProfiler.h"
+
+/**
+ * \class ProfilerWidget ProfilerWidget.h
+ * \brief Dock widget with a table of the count, mean, median, 99th percentile
+ * and maximum duration of every phase of a GripProfiler, in microseconds. The
+ * table is refreshed twice a second while the widget is visible.
+ */
+class ProfilerWidget : public QDockWidget {
+
+    /// MetaObject macro for using signals and slots
+    Q_OBJECT
+
+public:
+    /**
+     * \brief Constructs a ProfilerWidget object
+     * \param profiler Profiler to show. The widget doesn't take ownership
+     * \param parent Parent widget
+     */
+    ProfilerWidget(GripProfiler* profiler, QWidget* parent=0);
+
+    /**
+     * \brief Destructs this ProfilerWidget object
+     */
+    ~ProfilerWidget();
+
+public slots:
+    /**
+     * \brief Fills the table with the current timings of the profiler
+     * \return void
+     */
+    void refresh();
+
+    /**
+     * \brief Clears the timings of the profiler and the table
+     * \return void
+     */
+    void reset();
+
+    /**
+     * \brief Writes the timings to a CSV file chosen with a dialog, e.g. for
+     * comparing runs
+     * \return void
+     */
+    void save();
+
+protected:
+    /**
+     * \brief Starts refreshing the table when the widget is shown
+     * \param event Show event
+     * \return void
+     */
+    void showEvent(QShowEvent* event);
+
+    /**
+     * \brief Stops refreshing the table when the widget is hidden
+     * \param event Hide event
+     * \return void
+     */
+    void hideEvent(QHideEvent* event);
+
+    GripProfiler* _profiler;    ///< Profiler being shown
+    QTableWidget* _table;       ///< One row per phase
+    QPushButton* _resetButton;  ///< Clears the timings
+    QPushButton* _saveButton;   ///< Writes the timings to a CSV file
+    QTimer _refreshTimer;       ///< Refreshes the table while visible
+
+}; // end class ProfilerWidget
+
+#endif // PROFILER_WIDGET_H
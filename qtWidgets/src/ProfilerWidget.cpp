@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Local includes
+#include "ProfilerWidget.h"
+
+// Qt includes
+#include <QDir>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QVBoxLayout>
+
+ProfilerWidget::ProfilerWidget(GripProfiler* profiler, QWidget* parent)
+    : QDockWidget(parent),
+      _profiler(profiler)
+{
+    this->setObjectName("ProfilerWidget");
+    this->setWindowTitle(tr("Profiler"));
+
+    QStringList headers;
+    headers << tr("Phase") << tr("Count") << tr("Mean (us)") << tr("p50 (us)")
+            << tr("p99 (us)") << tr("Max (us)");
+    _table = new QTableWidget(0, headers.size());
+    _table->setHorizontalHeaderLabels(headers);
+    _table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _table->setSelectionMode(QAbstractItemView::NoSelection);
+    _table->verticalHeader()->hide();
+    _table->horizontalHeader()->setStretchLastSection(true);
+
+    _resetButton = new QPushButton(tr("Reset"));
+    connect(_resetButton, SIGNAL(released()), this, SLOT(reset()));
+
+    _saveButton = new QPushButton(tr("Save..."));
+    connect(_saveButton, SIGNAL(released()), this, SLOT(save()));
+
+    QHBoxLayout* buttons = new QHBoxLayout;
+    buttons->addWidget(_resetButton);
+    buttons->addWidget(_saveButton);
+
+    QWidget* widget = new QWidget(this);
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->addWidget(_table);
+    layout->addLayout(buttons);
+    widget->setLayout(layout);
+    this->setWidget(widget);
+
+    _refreshTimer.setInterval(500);
+    connect(&_refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+ProfilerWidget::~ProfilerWidget()
+{
+}
+
+void ProfilerWidget::refresh()
+{
+    if (!_profiler) {
+        return;
+    }
+
+    size_t numPhases = _profiler->getNumPhases();
+    if ((size_t)_table->rowCount() != numPhases) {
+        _table->setRowCount(numPhases);
+        for (size_t row=0; row<numPhases; ++row) {
+            for (int column=0; column<_table->columnCount(); ++column) {
+                QTableWidgetItem* item = new QTableWidgetItem;
+                if (column > 0) {
+                    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                }
+                _table->setItem(row, column, item);
+            }
+        }
+    }
+
+    for (size_t row=0; row<numPhases; ++row) {
+        GripPhaseStats stats = _profiler->getStats(row);
+        _table->item(row, 0)->setText(QString::fromStdString(stats.name));
+        _table->item(row, 1)->setText(QString::number(stats.count));
+        _table->item(row, 2)->setText(QString::number(1e6 * stats.mean, 'f', 1));
+        _table->item(row, 3)->setText(QString::number(1e6 * stats.p50, 'f', 1));
+        _table->item(row, 4)->setText(QString::number(1e6 * stats.p99, 'f', 1));
+        _table->item(row, 5)->setText(QString::number(1e6 * stats.max, 'f', 1));
+    }
+}
+
+void ProfilerWidget::reset()
+{
+    if (_profiler) {
+        _profiler->reset();
+    }
+    refresh();
+}
+
+void ProfilerWidget::save()
+{
+    if (!_profiler) {
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save Timings"),
+                                                    QDir::homePath() + "/grip-profile.csv",
+                                                    tr("CSV files (*.csv)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (!_profiler->writeCsv(fileName.toStdString())) {
+        QMessageBox::warning(this, tr("Save Timings"), tr("Could not write %1").arg(fileName));
+    }
+}
+
+void ProfilerWidget::showEvent(QShowEvent* event)
+{
+    refresh();
+    _refreshTimer.start();
+    QDockWidget::showEvent(event);
+}
+
+void ProfilerWidget::hideEvent(QHideEvent* event)
+{
+    _refreshTimer.stop();
+    QDockWidget::hideEvent(event);
+}
@@ -98,7 +98,9 @@ void TreeView::treeViewItemSelected(QTreeWidgetItem * item, int column)
 
     emit itemSelected(_activeItem);
     for (int i = 0; i < _tabs->size(); ++i) {
-        _tabs->at(i)->GRIPEventTreeViewSelectionChanged();
+        if (_tabs->at(i)->isSubscribed(GRIP_EVENT_TREEVIEW_SELECTION_CHANGED)) {
+            _tabs->at(i)->GRIPEventTreeViewSelectionChanged();
+        }
     }
 }
 
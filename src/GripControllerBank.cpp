@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Local includes
+#include "GripControllerBank.h"
+#include "gripTime.h"
+
+// Qt includes
+#include <QRunnable>
+#include <QThread>
+
+// C++ Standard includes
+#include <iostream>
+#include <sstream>
+
+/**
+ * \brief Thread pool task computing the torques of one controller of a
+ * GripControllerBank. Kept by the bank and started again every time step.
+ */
+class GripControllerTask : public QRunnable
+{
+public:
+    GripControllerTask(GripControllerBank* bank, size_t index)
+        : _bank(bank), _index(index)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        _bank->_compute(_index);
+    }
+
+protected:
+    GripControllerBank* _bank;
+    size_t _index;
+};
+
+GripControllerBank::GripControllerBank(int numThreads)
+    : _pool(new QThreadPool),
+      _profiler(NULL),
+      _phaseCompute(0),
+      _phaseApply(0),
+      _time(0),
+      _computeDuration(0)
+{
+    setMaxThreadCount(numThreads > 0 ? numThreads : QThread::idealThreadCount());
+
+    // Threads are needed again after every step, so don't let them expire
+    _pool->setExpiryTimeout(-1);
+}
+
+GripControllerBank::~GripControllerBank()
+{
+    _pool->waitForDone();
+    delete _pool;
+    for (size_t i=0; i<_controllers.size(); ++i) {
+        delete _tasks[i];
+        delete _controllers[i];
+    }
+}
+
+size_t GripControllerBank::addController(HuboController* controller)
+{
+    size_t index = _controllers.size();
+    _controllers.push_back(controller);
+    _tasks.push_back(new GripControllerTask(this, index));
+    _torques.push_back(Eigen::VectorXd::Zero(controller->skel->getNumGenCoords()));
+    _durations.push_back(0);
+    _phases.push_back(0);
+    if (_profiler) {
+        _addPhase(index);
+    }
+    return index;
+}
+
+size_t GripControllerBank::getNumControllers() const
+{
+    return _controllers.size();
+}
+
+HuboController* GripControllerBank::getController(size_t index)
+{
+    if (index >= _controllers.size()) {
+        std::cerr << "[GripControllerBank] Invalid controller index " << index << std::endl;
+        return NULL;
+    }
+    return _controllers[index];
+}
+
+void GripControllerBank::computeTorques(double t)
+{
+    if (_controllers.empty()) {
+        return;
+    }
+
+    GripScopedTimer timer(_profiler, _phaseCompute);
+    double start = grip::getTime();
+    _time = t;
+
+    // The calling thread takes the last controller instead of just waiting
+    for (size_t i=0; i+1<_controllers.size(); ++i) {
+        _pool->start(_tasks[i]);
+    }
+    _compute(_controllers.size() - 1);
+    _pool->waitForDone();
+
+    _computeDuration = grip::getTime() - start;
+}
+
+void GripControllerBank::applyTorques()
+{
+    GripScopedTimer timer(_profiler, _phaseApply);
+    for (size_t i=0; i<_controllers.size(); ++i) {
+        _controllers[i]->skel->setInternalForceVector(_torques[i]);
+    }
+}
+
+void GripControllerBank::update(double t)
+{
+    computeTorques(t);
+    applyTorques();
+}
+
+const Eigen::VectorXd& GripControllerBank::getTorques(size_t index) const
+{
+    return _torques.at(index);
+}
+
+double GripControllerBank::getLastDuration(size_t index) const
+{
+    return (index < _durations.size() ? _durations[index] : 0);
+}
+
+double GripControllerBank::getLastComputeDuration() const
+{
+    return _computeDuration;
+}
+
+void GripControllerBank::setProfiler(GripProfiler* profiler)
+{
+    _profiler = profiler;
+    if (_profiler) {
+        _phaseCompute = _profiler->addPhase("controllers: compute torques");
+        _phaseApply = _profiler->addPhase("controllers: apply torques");
+        for (size_t i=0; i<_controllers.size(); ++i) {
+            _addPhase(i);
+        }
+    }
+}
+
+void GripControllerBank::setMaxThreadCount(int numThreads)
+{
+    _pool->setMaxThreadCount(numThreads > 0 ? numThreads : 1);
+}
+
+void GripControllerBank::_compute(size_t index)
+{
+    HuboController* controller = _controllers[index];
+    double start = grip::getTime();
+    controller->getTorques(controller->skel->get_q(), controller->skel->get_dq(), _time, _torques[index]);
+    _durations[index] = grip::getTime() - start;
+
+    if (_profiler) {
+        _profiler->record(_phases[index], _durations[index]);
+    }
+}
+
+void GripControllerBank::_addPhase(size_t index)
+{
+    std::ostringstream name;
+    name << "controllers: " << index << " " << _controllers[index]->skel->getName();
+    _phases[index] = _profiler->addPhase(name.str());
+}
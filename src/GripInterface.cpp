@@ -1,8 +1,14 @@
 #include "../include/GripInterface.h"
 
+#include "gripTime.h"
+
 #include <QApplication>
+#include <QCoreApplication>
+#include <QThread>
 #include <X11/Xlib.h>
 #include <iostream>
+#include <cstdlib>
+#include <algorithm>
 #include <unistd.h>
 #include <Eigen/Geometry>
 
@@ -12,7 +18,7 @@
     #include <dispatch/dispatch.h>
 #endif
 
-GripInterface::GripInterface() : _app(NULL), _window(NULL), _gripthread(NULL)
+GripInterface::GripInterface() : _app(NULL), _window(NULL), _gripthread(NULL), _rolloutEngine(NULL)
 {
 }
 
@@ -24,6 +30,7 @@ GripInterface::~GripInterface()
     // std::cerr << "window should have exited" << std::endl;    
     if (_gripthread != NULL)
         _gripthread->join();
+    delete _rolloutEngine;
 }
 
 /**
@@ -41,11 +48,17 @@ void GripInterface::show_usage() //(std::ostream &ostr) don't know how to make a
             "  -d|--debug                Print debug statements\n"
             "  -f|--file sceneFile       Load scene \"sceneFile\" (.urdf, .sdf)\n"
             "  -c|--config configFile    Load workspace \"configFile\" (.gripconfig)\n"
+            "  --headless                Simulate without a window (needs -f and -n)\n"
+            "  -n|--steps numSteps       Number of time steps to simulate in headless mode\n"
+            "  -o|--output timelineFile  Record the headless simulation to \"timelineFile\"\n"
+            "  --retention seconds       Only keep the last \"seconds\" of the timeline in memory\n"
+            "  --spill                   Spill older parts of the timeline to disk instead of dropping them\n"
             "  -h|--help                 Show this help message\n"
             "\n"
             "Examples\n"
             "  grip -d\n"
             "  grip -d -f ~/sceneFiles/robot.urdf\n"
+            "  grip --headless -f ~/sceneFiles/robot.urdf --steps 10000 -o robot.griptimeline\n"
             "  grip --help\n";
 }
 
@@ -53,8 +66,13 @@ int GripInterface::_create(int argc, char **argv)
 {
     // Variables for command line parsing
     bool debug = false;
+    bool headless = false;
+    int numSteps = 0;
     std::string sceneFilePath;
     std::string configFilePath;
+    std::string outputFilePath;
+    double retention = 0;
+    bool spill = false;
 
     // Parse command line arguments. See "showUsage" function for description
     std::vector<std::string> args(argv, argv + argc);
@@ -66,12 +84,27 @@ int GripInterface::_create(int argc, char **argv)
             sceneFilePath = args[i+1];
         } else if ("-c" == args[i] || "--config" == args[i]) {
             configFilePath = args[i+1];
+        } else if ("--headless" == args[i]) {
+            headless = true;
+        } else if (("-n" == args[i] || "--steps" == args[i]) && i+1 < args.size()) {
+            numSteps = atoi(args[i+1].c_str());
+        } else if (("-o" == args[i] || "--output" == args[i]) && i+1 < args.size()) {
+            outputFilePath = args[i+1];
+        } else if ("--retention" == args[i] && i+1 < args.size()) {
+            retention = atof(args[i+1].c_str());
+        } else if ("--spill" == args[i]) {
+            spill = true;
         } else if ("-h" == args[i] || "--help" == args[i]) {
             show_usage();
             exit(1);
         }
     }
 
+    if (headless) {
+        return _createHeadless(argc, argv, sceneFilePath, numSteps, outputFilePath,
+                               retention, spill, debug);
+    }
+
     // Initialize Xlib support for concurrent threads
     XInitThreads();
 
@@ -85,6 +118,78 @@ int GripInterface::_create(int argc, char **argv)
     return 0;
 }
 
+int GripInterface::_createHeadless(int argc, char **argv, std::string sceneFileName, int numSteps,
+                                   std::string outputFileName, double retention, bool spill, bool debug)
+{
+    if (sceneFileName.empty() || numSteps <= 0) {
+        std::cerr << "[GripInterface] Headless mode needs a scene file (-f) and a number of steps (-n)" << std::endl;
+        show_usage();
+        return 1;
+    }
+
+    dart::simulation::World* world = _loadWorld(sceneFileName, debug);
+    if (!world) {
+        return 1;
+    }
+
+    // Only a core application is needed to run the event loops for the signals and
+    // slots between this thread and the simulation thread. No window is ever created.
+    QCoreApplication app(argc, argv);
+    GripTimeline timeline;
+    timeline.setRetention(retention, spill);
+    QList<GripTab*> pluginList;
+    GripSimulation* simulation = new GripSimulation(world, &timeline, &pluginList, NULL, debug);
+    QObject::connect(simulation, SIGNAL(simulationStoppedSignal()), &app, SLOT(quit()));
+
+    int result = 0;
+    if (!outputFileName.empty() && !simulation->setTimelineFile(outputFileName)) {
+        result = 1;
+    } else {
+        double startTime = grip::getTime();
+        QMetaObject::invokeMethod(simulation, "simulateBatch", Qt::QueuedConnection, Q_ARG(int, numSteps));
+        app.exec();
+        double duration = grip::getTime() - startTime;
+
+        std::cerr << "[GripInterface] Simulated " << numSteps << " steps (" << world->getTime()
+                  << " s of simulation time) in " << duration << " s of real time ("
+                  << world->getTime() / duration << "x real time)" << std::endl;
+    }
+
+    // Shut down the simulation thread, then free everything before returning. Deleting
+    // the simulation closes the timeline file and posts the deletion of its thread
+    QThread* simulationThread = simulation->thread();
+    simulationThread->quit();
+    simulationThread->wait();
+    delete simulation;
+    QCoreApplication::sendPostedEvents(0, QEvent::DeferredDelete);
+    delete world;
+
+    return result;
+}
+
+dart::simulation::World* GripInterface::_loadWorld(std::string sceneFileName, bool debug)
+{
+    // Parsed exactly like the scenes loaded in the window
+    dart::simulation::World* sceneWorld = GripSceneLoader::parseScene(sceneFileName, debug);
+    if (!sceneWorld) {
+        return NULL;
+    }
+
+    // Same ground and time step as GripMainWindow::sceneLoaded. The parsed world is
+    // used as is, since a World deletes its skeletons and they can't be moved out of it.
+    // The ground has no DOFs, so coming last leaves the state laid out like in the window
+    sceneWorld->setTime(0);
+    sceneWorld->setTimeStep(0.001);
+    sceneWorld->addSkeleton(GripMainWindow::createGround());
+
+    if (debug) {
+        std::cerr << "[GripInterface] Loaded " << sceneWorld->getNumSkeletons()
+                  << " skeletons from " << sceneFileName << std::endl;
+    }
+
+    return sceneWorld;
+}
+
 #if defined(__linux) || defined(__linux__) || defined(linux)
 /**
  * Runs Grip QT application in a thread -- linux version
@@ -139,7 +244,7 @@ void GripInterface::loadScene(std::string sceneFileName)
     if (_window == NULL)
         std::cerr << "Grip window pointer is NULL.  Call create()." << std::endl;
     else
-        _window->doLoad(sceneFileName);
+        _window->doLoad(sceneFileName, false);
 }
 
 void GripInterface::loadPluginFile(std::string pluginFileName)
@@ -167,23 +272,165 @@ void GripInterface::simulateSingleStep()
     _window->simulateSingleStep();
 }
 
-std::vector<double> GripInterface::getState()
+bool GripInterface::step(int numSteps, const double *torques, int numTorques, double *state)
 {
-    /* Note: would be nice to memory map this, but stl vector 
-       doesn't seem to support it.
-    */ 
-    // Eigen::Map<Eigen::VectorXd>(state.data(), _estate.rows(), _estate.cols()) = _estate;
+    if (_window == NULL) {
+        std::cerr << "Grip window pointer is NULL.  Call create()." << std::endl;
+        return false;
+    }
+
+    Eigen::VectorXd _et;
+    if (torques != NULL && numTorques > 0)
+        _et = Eigen::Map<const Eigen::VectorXd>(torques, numTorques);
+
+    Eigen::VectorXd _es;
+    if (!_window->simulation->stepSynchronous(numSteps > 0 ? numSteps : 0, _et, _es))
+        return false;
 
+    // Hand the state back, and let the window know the world moved on its own thread
+    if (state != NULL)
+        Eigen::Map<Eigen::VectorXd>(state, _es.size()) = _es;
+    if (!QMetaObject::invokeMethod(_window, "worldChangedExternally", Qt::QueuedConnection))
+        std::cerr << "[GripInterface] Could not tell the window the world changed" << std::endl;
+
+    return true;
+}
+
+std::vector<double> GripInterface::step(int numSteps, const std::vector<double> &torques)
+{
+    std::vector<double> state(getStateSize());
+    if (!step(numSteps, torques.data(), torques.size(), state.data()))
+        return std::vector<double>();
+    return state;
+}
+
+std::vector<double> GripInterface::getState()
+{
     Eigen::VectorXd _es = _window->world->getState();
     std::vector<double> state(_es.rows());
-    for (int i=0; i<_es.rows(); i++)
-        state[i] = _es[i];
-    
+    Eigen::Map<Eigen::VectorXd>(state.data(), state.size()) = _es;
+
     return state;
 }
 
 void GripInterface::setState(const std::vector<double> &state)
 {
-    Eigen::Map<const Eigen::VectorXd> _es(state.data(), state.size());
-    _window->world->setState(_es);
-}
\ No newline at end of file
+    setStateFromBuffer(state.data(), state.size());
+}
+
+void GripInterface::updateStateBuffer(double *state)
+{
+    Eigen::VectorXd _es = _window->world->getState();
+    Eigen::Map<Eigen::VectorXd>(state, _es.size()) = _es;
+}
+
+void GripInterface::setStateFromBuffer(const double *state, int size)
+{
+    if (size != getStateSize()) {
+        std::cerr << "[GripInterface] State has " << size
+                  << " values but the world state has " << getStateSize() << std::endl;
+        return;
+    }
+    _applyState(Eigen::Map<const Eigen::VectorXd>(state, size));
+}
+
+void GripInterface::_applyState(const Eigen::Map<const Eigen::VectorXd> &state)
+{
+    // Applied on the window's thread so its state applier knows the skeletons moved
+    _window->_externalState = state;
+    if (!QMetaObject::invokeMethod(_window, "setWorldFromExternalState",
+                                   QThread::currentThread() == _window->thread()
+                                   ? Qt::DirectConnection : Qt::BlockingQueuedConnection))
+        std::cerr << "[GripInterface] Could not set the world state in the window" << std::endl;
+}
+
+int GripInterface::getStateSize()
+{
+    int size = 0;
+    for (int i=0; i<_window->world->getNumSkeletons(); i++)
+        size += 2 * _window->world->getSkeleton(i)->getNumGenCoords();
+    return size;
+}
+
+int GripInterface::getTimelineLength()
+{
+    GripTimeline *timeline = _window->timeline;
+    return timeline->size() - timeline->getFirstIndex();
+}
+
+int GripInterface::getTimelineStateSize()
+{
+    return _window->timeline->getStateSize();
+}
+
+int GripInterface::exportTimeline(double *times, double *states, int numRows)
+{
+    if (_window->_simulating) {
+        std::cerr << "[GripInterface] Not exporting the timeline while simulating" << std::endl;
+        return -1;
+    }
+
+    // Slices may have been evicted since the caller asked for the length
+    GripTimeline *timeline = _window->timeline;
+    size_t first = timeline->getFirstIndex();
+    size_t count = std::min(timeline->size() - first, (size_t)std::max(numRows, 0));
+    if (count > 0)
+        timeline->copyTo(first, count, times, states);
+
+    return count;
+}
+
+int GripInterface::runRollouts(std::string sceneFileName, int numSteps,
+                               const std::vector<std::vector<double> > &kp,
+                               const std::vector<std::vector<double> > &kd,
+                               int numThreads)
+{
+    if (_rolloutEngine == NULL)
+        _rolloutEngine = new GripRolloutEngine(&GripInterface::_loadWorld, numThreads);
+    else
+        _rolloutEngine->setMaxThreadCount(numThreads > 0 ? numThreads : QThread::idealThreadCount());
+
+    if (!_rolloutEngine->setScene(sceneFileName))
+        return -1;
+
+    size_t numRollouts = std::max(kp.size(), kd.size());
+    std::vector<GripRolloutParams> params(numRollouts);
+    for (size_t i=0; i<numRollouts; i++) {
+        if (i < kp.size())
+            params[i].Kp = Eigen::Map<const Eigen::VectorXd>(kp[i].data(), kp[i].size());
+        if (i < kd.size())
+            params[i].Kd = Eigen::Map<const Eigen::VectorXd>(kd[i].data(), kd[i].size());
+    }
+
+    return _rolloutEngine->run(params, numSteps > 0 ? numSteps : 0);
+}
+
+std::vector<GripRolloutMetrics> GripInterface::getRolloutMetrics()
+{
+    if (_rolloutEngine == NULL)
+        return std::vector<GripRolloutMetrics>();
+    return _rolloutEngine->getMetrics();
+}
+
+std::vector<double> GripInterface::getRolloutTimeline(int rollout)
+{
+    if (_rolloutEngine == NULL || rollout < 0 || rollout >= (int)_rolloutEngine->getNumRollouts())
+        return std::vector<double>();
+
+    const Eigen::VectorXd &times = _rolloutEngine->getTimes(rollout);
+    const Eigen::MatrixXf &states = _rolloutEngine->getStates(rollout);
+    int sampleSize = states.rows() + 1;
+    std::vector<double> timeline(times.size() * sampleSize);
+    for (int i=0; i<times.size(); i++) {
+        timeline[i*sampleSize] = times[i];
+        Eigen::Map<Eigen::VectorXd>(&timeline[i*sampleSize + 1], states.rows()) = states.col(i).cast<double>();
+    }
+    return timeline;
+}
+
+int GripInterface::getRolloutSampleSize()
+{
+    if (_rolloutEngine == NULL)
+        return 0;
+    return _rolloutEngine->getStateSize() + 1;
+}
@@ -55,6 +55,7 @@
 #include "Grid.h"
 #include "Line.h"
 #include "DartNode.h"
+#include "gripTime.h"
 
 // Qt includes
 #include <QtGui>
@@ -71,6 +72,9 @@
 #include <dart/dynamics/WeldJoint.h>
 #include <dart/utils/urdf/DartLoader.h>
 
+// C++ Standard includes
+#include <cmath>
+
 GripMainWindow::GripMainWindow(bool debug, std::string sceneFile, std::string configFile) :
     MainWindow(),
     world(new dart::simulation::World()),
@@ -81,15 +85,34 @@ GripMainWindow::GripMainWindow(bool debug, std::string sceneFile, std::string co
     _simulating(false),
     _playingBack(false),
     _curPlaybackTick(0),
-    _playbackSpeed(5),
+    _playbackTime(0),
+    _playbackWallTime(0),
+    _playForward(true),
     _simulationDirty(false),
-    _recordVideo(false)
+    _loadingScene(false)
 {
     /// object initialization
     world->setTime(0);
+    recordSize = QSize(1024, 768);
     playbackWidget = new PlaybackWidget(this);
-    timeline = new std::vector<GripTimeslice>(0);
+    timeline = new GripTimeline();
+    // Playback and plugins hold views into the timeline on this thread, so chunks
+    // are only evicted here and not by the simulation thread pushing to it
+    timeline->setDeferredEviction(true);
+    profiler = new GripProfiler();
     simulation = new GripSimulation(world, timeline, pluginList, this, debug);
+    snapshotBuffer = new osgDart::WorldSnapshotBuffer();
+    _stateApplier.setWorld(world);
+    simulation->setSnapshotBuffer(snapshotBuffer);
+    worldNode->setSnapshotBuffer(snapshotBuffer);
+    simulation->setProfiler(profiler);
+    worldNode->setProfiler(profiler);
+    sceneLoader = new GripSceneLoader(this, debug);
+    videoEncoder = new GripVideoEncoder();
+    playbackTimer = new QTimer(this);
+    if (!connect(playbackTimer, SIGNAL(timeout()), this, SLOT(slotPlaybackTick()))) {
+        std::cerr << "[GripMainWindow] Could not connect the playback timer" << std::endl;
+    }
     pluginPathList = new QList<QString*>;
     sceneFilePath = new QString();
     std::cerr<<sceneFilePath->toStdString()<<std::endl;
@@ -97,6 +120,7 @@ GripMainWindow::GripMainWindow(bool debug, std::string sceneFile, std::string co
     /// create objects for widget classes
     createTreeView();
     createRenderingWindow();
+    viewWidget->setProfiler(profiler);
     createTabs();
 
     /// load widgets in the user interface and manages the layout
@@ -106,7 +130,16 @@ GripMainWindow::GripMainWindow(bool debug, std::string sceneFile, std::string co
     /// set the status bar for the Grip Window
     this->setStatusBar(this->statusBar());
 
+    // GripInterface calls these by name, which only works for slots declared in MainWindow
+    const char* externalSlots[] = {"setWorldFromExternalState()", "worldChangedExternally()"};
+    for (size_t i = 0; i < sizeof(externalSlots) / sizeof(externalSlots[0]); ++i) {
+        if (this->metaObject()->indexOfSlot(externalSlots[i]) < 0) {
+            std::cerr << "[GripMainWindow] Missing slot " << externalSlots[i] << std::endl;
+        }
+    }
+
     connect(this, SIGNAL(destroyed()), simulation, SLOT(deleteLater()));
+    connect(this, SIGNAL(destroyed()), sceneLoader, SLOT(deleteLater()));
 
     // Load config file passed in by user, if specified
     if (!configFile.empty()) {
@@ -122,11 +155,30 @@ GripMainWindow::GripMainWindow(bool debug, std::string sceneFile, std::string co
 
 }
 
-GripMainWindow::~GripMainWindow() {}
+GripMainWindow::~GripMainWindow()
+{
+    delete videoEncoder;
+
+    // Keep the timings of the session around for comparing runs, unless turned off
+    if (saveProfileOnExitAct->isChecked()) {
+        std::string profileFile = QDir::homePath().toStdString() + "/grip-profile.csv";
+        if (profiler->writeCsv(profileFile) && _debug) {
+            std::cerr << "[GripMainWindow] Wrote timings to " << profileFile << std::endl;
+        }
+    }
+}
 
 void GripMainWindow::doLoad(std::string sceneFileName)
 {
-    sceneFilePath = new QString(QString::fromStdString(sceneFileName));
+    doLoad(sceneFileName, true);
+}
+
+void GripMainWindow::doLoad(std::string sceneFileName, bool async)
+{
+    if (_loadingScene) {
+        slotSetStatusBarMessage(tr("Already loading a scene"));
+        return;
+    }
 
     if (_simulating || _playingBack) {
         if (!stopSimulationWithDialog()) {
@@ -140,11 +192,45 @@ void GripMainWindow::doLoad(std::string sceneFileName)
         this->clear();
     }
 
+    // Parsing and building the scene graph happens on the loader's thread pool,
+    // and sceneLoaded() adds the result to the world on this thread
+    _loadingScene = true;
+    this->slotSetStatusBarMessage("Loading scene " + QString::fromStdString(sceneFileName));
+    if (async) {
+        QMetaObject::invokeMethod(sceneLoader, "load", Qt::QueuedConnection,
+                                  Q_ARG(QString, QString::fromStdString(sceneFileName)));
+    } else {
+        sceneLoaded(sceneLoader->loadScene(sceneFileName));
+    }
+}
+
+void GripMainWindow::sceneLoadProgress(int numDone, int numTotal, QString stage)
+{
+    if (!_loadingScene) {
+        return;
+    }
+    this->slotSetStatusBarMessage(tr("Loading scene: %1 (%2/%3)").arg(stage).arg(numDone).arg(numTotal));
+}
+
+void GripMainWindow::sceneLoaded(bool success)
+{
+    _loadingScene = false;
+    std::string sceneFileName = sceneLoader->getFileName();
+
+    if (!success) {
+        this->slotSetStatusBarMessage("Failed to load scene " + QString::fromStdString(sceneFileName));
+        return;
+    }
+
+    sceneFilePath = new QString(QString::fromStdString(sceneFileName));
+
     world->setTimeStep(0.001);
 
     world->addSkeleton(createGround());
     worldNode->addWorld(world);
-    worldNode->addWorld(sceneFileName);
+    dart::simulation::World* sceneWorld = sceneLoader->takeWorld();
+    worldNode->addWorld(sceneWorld, sceneLoader->takeSkeletonNodes());
+    _stateApplier.setWorld(world);
 
     viewWidget->addNodeToScene(worldNode);
 
@@ -160,7 +246,9 @@ void GripMainWindow::doLoad(std::string sceneFileName)
 
     // Tell all the tabs that a new scene has been loaded
     for (int i = 0; i < pluginList->size(); ++i) {
-        pluginList->at(i)->GRIPEventSceneLoaded();
+        if (pluginList->at(i)->isSubscribed(GRIP_EVENT_SCENE_LOADED)) {
+            pluginList->at(i)->GRIPEventSceneLoaded();
+        }
     }
 }
 
@@ -213,10 +301,12 @@ void GripMainWindow::clear()
             world->removeSkeleton(world->getSkeleton(0));
         }
         world->setTime(0);
+        _stateApplier.setWorld(world);
         treeviewer->reset();
         simulation->reset();
         playbackWidget->reset();
         timeline->clear();
+        recordTimelineAct->setChecked(false);
         sceneFilePath = NULL;
         for (int i = 0; i < pluginList->size(); ++i) {
             pluginList->at(i)->Refresh();
@@ -228,42 +318,85 @@ void GripMainWindow::simulationStopped()
 {
     if(_debug) std::cerr << "Got simulationStopped signal" << std::endl;
     _simulating = false;
+    timeline->evict();
+    viewWidget->setContinuousRendering(false);
+    viewWidget->requestRedraw();
     playbackWidget->ui->sliderMain->setEnabled(true);
-    playbackWidget->slotUpdateSliderMinMax(0, timeline->size() - 1);
+    playbackWidget->slotUpdateSliderMinMax(timeline->getFirstIndex(), timeline->size() - 1);
     playbackWidget->setSliderValue(timeline->size() - 1);
+
+    // The simulation loop is done with the world by now
+    for (int i = 0; i < pluginList->size(); ++i) {
+        if (pluginList->at(i)->isSubscribed(GRIP_EVENT_SIMULATION_STOP)) {
+            pluginList->at(i)->GRIPEventSimulationStop();
+        }
+    }
 }
 
 void GripMainWindow::slotSetWorldFromPlayback(int sliderTick)
 {
-    if (_simulating || timeline->size() <= 0) {
+    if (_simulating || timeline->empty()) {
         playbackWidget->setSliderValue(0);
         return;
     }
 
+    // Slices before the first index have been dropped by the timeline's retention policy
+    if (sliderTick < (int)timeline->getFirstIndex()) {
+        sliderTick = timeline->getFirstIndex();
+    }
+
+    // Playback moves the slider itself. Dragging it moves the playback time
+    if (_playingBack) {
+        if ((size_t)sliderTick != _curPlaybackTick) {
+            _curPlaybackTick = sliderTick;
+            _playbackTime = timeline->getTime(_curPlaybackTick);
+        }
+        return;
+    }
+
+    // The simulation or GripInterface may have moved the skeletons since the last state was applied
     _curPlaybackTick = sliderTick;
-    world->setTime(timeline->at(_curPlaybackTick).getTime());
-    this->setWorldState_Issue122(timeline->at(sliderTick).getState());
+    GripTimesliceView timeslice = timeline->at(_curPlaybackTick);
+    world->setTime(timeslice.getTime());
+    _stateApplier.invalidate();
+    this->setWorldState_Issue122(timeslice.getState());
     playbackWidget->slotSetTimeDisplays(world->getTime(), 0);
-    playbackWidget->slotUpdateSliderMinMax(0, timeline->size() - 1);
+    playbackWidget->slotUpdateSliderMinMax(timeline->getFirstIndex(), timeline->size() - 1);
+    viewWidget->requestRedraw();
 }
 
-void GripMainWindow::setWorldState_Issue122(const Eigen::VectorXd &_newState)
+void GripMainWindow::setWorldFromExternalState()
 {
-    // Before setting states, make sure the FreeJoints get their mT_Joints set
-    for (int i = 0; i < world->getNumSkeletons(); i++) {
-        int start = 2 * world->getIndex(i);
-        int size = 2 * (world->getSkeleton(i)->getNumGenCoords());
-        Eigen::VectorXd q = _newState.segment(start, size / 2);
-        // Set config calls updateTransform() [NO updateTransform_Issue122], which correctly initializes mT_Joint for FREE JOINT
-        world->getSkeleton(i)->setConfig(q);
-        // The usual line. The line above is actually repeating some processing, but there is no other way, unless you want to touch DART itself
-        world->getSkeleton(i)->setState(_newState.segment(start, size));
+    if (_simulating) {
+        std::cerr << "[GripMainWindow] Not setting the world state while simulating" << std::endl;
+        return;
     }
+
+    // The skeletons may have been moved without going through the applier
+    _stateApplier.invalidate();
+    this->setWorldState_Issue122(_externalState);
+    viewWidget->requestRedraw();
+}
+
+void GripMainWindow::worldChangedExternally()
+{
+    _stateApplier.invalidate();
+    viewWidget->requestRedraw();
+}
+
+void GripMainWindow::setWorldState_Issue122(const Eigen::VectorXd &_newState)
+{
+    _stateApplier.apply(_newState);
+}
+
+void GripMainWindow::setWorldState_Issue122(const Eigen::Map<const Eigen::VectorXd> &_newState)
+{
+    _stateApplier.apply(_newState);
 }
 
 void GripMainWindow::slotPlaybackStart()
 {
-    if (timeline->size() <= 0) {
+    if (timeline->empty()) {
         return;
     }
 
@@ -278,38 +411,47 @@ void GripMainWindow::slotPlaybackStart()
     }
 
     _curPlaybackTick = playbackWidget->getSliderValue();
+    _playbackTime = timeline->getTime(_curPlaybackTick);
+    _playbackWallTime = grip::getTime();
+    _playbackInterpolator.setWorld(*world);
+    _stateApplier.invalidate();
     _simulationDirty = true;
 
     for (int i = 0; i < pluginList->size(); ++i) {
-        pluginList->at(i)->GRIPEventPlaybackStart();
+        if (pluginList->at(i)->isSubscribed(GRIP_EVENT_PLAYBACK_START)) {
+            pluginList->at(i)->GRIPEventPlaybackStart();
+        }
     }
 
     _playingBack = true;
-    this->slotPlaybackTimeStep(true);
+    startPlaybackTimer(true);
 }
 
 void GripMainWindow::slotPlaybackPause()
 {
-    if (timeline->size() <= 0 || !_playingBack) {
+    if (timeline->empty() || !_playingBack) {
         return;
     }
 
     this->slotSetStatusBarMessage(tr(qPrintable("Pausing playback")));
 
     _playingBack = false;
+    playbackTimer->stop();
 
     for (int i = 0; i < pluginList->size(); ++i) {
-        pluginList->at(i)->GRIPEventPlaybackStop();
+        if (pluginList->at(i)->isSubscribed(GRIP_EVENT_PLAYBACK_STOP)) {
+            pluginList->at(i)->GRIPEventPlaybackStop();
+        }
     }
 }
 
 void GripMainWindow::slotPlaybackReverse()
 {
-    if (timeline->size() <= 0) {
+    if (timeline->empty()) {
         return;
     }
 
-    if (playbackWidget->getSliderValue() == 0) {
+    if (playbackWidget->getSliderValue() <= (int)timeline->getFirstIndex()) {
         _curPlaybackTick = timeline->size() - 1;
         playbackWidget->setSliderValue(_curPlaybackTick);
         world->setTime(timeline->back().getTime());
@@ -324,29 +466,34 @@ void GripMainWindow::slotPlaybackReverse()
     }
 
     _curPlaybackTick = playbackWidget->getSliderValue();
+    _playbackTime = timeline->getTime(_curPlaybackTick);
+    _playbackWallTime = grip::getTime();
+    _playbackInterpolator.setWorld(*world);
+    _stateApplier.invalidate();
 
     for (int i = 0; i < pluginList->size(); ++i) {
-        pluginList->at(i)->GRIPEventPlaybackStart();
+        if (pluginList->at(i)->isSubscribed(GRIP_EVENT_PLAYBACK_START)) {
+            pluginList->at(i)->GRIPEventPlaybackStart();
+        }
     }
 
     _playingBack = true;
-    this->slotPlaybackTimeStep(false);
+    startPlaybackTimer(false);
 }
 
 void GripMainWindow::slotPlaybackBeginning()
 {
-    if (timeline->size() <= 0) {
+    if (timeline->empty()) {
         return;
     }
 
     this->slotSetStatusBarMessage(tr("Setting playback to beginning"));
 
-    _curPlaybackTick = 0;
+    _curPlaybackTick = timeline->getFirstIndex();
     playbackWidget->setSliderValue(_curPlaybackTick);
-    if (timeline->size() > 0) {
-        world->setTime(timeline->at(_curPlaybackTick).getTime());
-        this->setWorldState_Issue122(timeline->front().getState());
-    }
+    GripTimesliceView timeslice = timeline->front();
+    world->setTime(timeslice.getTime());
+    this->setWorldState_Issue122(timeslice.getState());
     playbackWidget->slotSetTimeDisplays(world->getTime(), 0);
 }
 
@@ -354,51 +501,62 @@ void GripMainWindow::slotPlaybackTimeStep(bool playForward)
 {
     if (_playingBack) {
 
-        if (_playbackSpeed != 5 * playbackWidget->getPlaybackSpeed())
-            _playbackSpeed = 5 * playbackWidget->getPlaybackSpeed();
-
         // Call user tab functions before time step
         for (int i = 0; i < pluginList->size(); ++i) {
-            pluginList->at(i)->GRIPEventPlaybackBeforeFrame();
+            if (pluginList->at(i)->isSubscribed(GRIP_EVENT_PLAYBACK_BEFORE_FRAME)) {
+                pluginList->at(i)->GRIPEventPlaybackBeforeFrame();
+            }
         }
 
-        // Play time step
-        world->setTime(timeline->at(_curPlaybackTick).getTime());
-        this->setWorldState_Issue122(timeline->at(_curPlaybackTick).getState());
-        playbackWidget->slotSetTimeDisplays(world->getTime(), 0);
-
-        std::cerr << "cur: " << _curPlaybackTick << ", " << _curPlaybackTick + _playbackSpeed << ", " << timeline->size()-1 << std::endl;
-        if ((_curPlaybackTick == 0 && !playForward)
-                || (_curPlaybackTick == (timeline->size() - 1) && playForward)) {
+        // Advance by the wall clock time since the last step, scaled by the playback speed
+        double now = grip::getTime();
+        double elapsed = playbackWidget->getPlaybackSpeed() * (now - _playbackWallTime);
+        _playbackWallTime = now;
+        _playbackTime += (playForward ? elapsed : -elapsed);
+
+        double startTime = timeline->getTime(timeline->getFirstIndex());
+        double endTime = timeline->getTime(timeline->size() - 1);
+        if ((_playbackTime <= startTime && !playForward)
+                || (_playbackTime >= endTime && playForward)) {
+            _playbackTime = (playForward ? endTime : startTime);
             _playingBack = false;
             std::cerr << "Done playing back" << std::endl;
-        } else if (((_curPlaybackTick - _playbackSpeed) < 0 && !playForward)
-                || ((_curPlaybackTick + _playbackSpeed) > (timeline->size() - 1) && playForward)) {
-            _curPlaybackTick = (playForward ? timeline->size() - 1 : 0); 
-        } else {
-            playForward ? _curPlaybackTick = _curPlaybackTick + _playbackSpeed
-                    : _curPlaybackTick = _curPlaybackTick - _playbackSpeed;
         }
 
+        // Show the state in between the timeslices around the playback time
+        _curPlaybackTick = _playbackInterpolator.interpolate(*timeline, _playbackTime, _playbackState);
+        world->setTime(_playbackTime);
+        this->setWorldState_Issue122(_playbackState);
+        playbackWidget->slotSetTimeDisplays(world->getTime(), 0);
         playbackWidget->setSliderValue(_curPlaybackTick);
-        if(_recordVideo){
-            recordImageList->append(recordViewWidget->takeScreenshot());
-        }
+        viewWidget->requestRedraw();
 
         // Call user tab functions after time step
         for (int i = 0; i < pluginList->size(); ++i) {
-            pluginList->at(i)->GRIPEventPlaybackAfterFrame();
+            if (pluginList->at(i)->isSubscribed(GRIP_EVENT_PLAYBACK_AFTER_FRAME)) {
+                pluginList->at(i)->GRIPEventPlaybackAfterFrame();
+            }
         }
 
-    } else {
-        if(_recordVideo)
-            QMetaObject::invokeMethod(this, "saveVideo", Qt::QueuedConnection);
-            _recordVideo = false;
-        return;
     }
 
-    QMetaObject::invokeMethod(this, "slotPlaybackTimeStep",
-                              Qt::QueuedConnection, Q_ARG(bool, playForward));
+    if (!_playingBack) {
+        playbackTimer->stop();
+    }
+}
+
+void GripMainWindow::slotPlaybackTick()
+{
+    slotPlaybackTimeStep(_playForward);
+}
+
+void GripMainWindow::startPlaybackTimer(bool playForward)
+{
+    // One playback step per displayed frame. Without a frame rate limit, pace it at 60 Hz
+    double fps = viewWidget->getMaxFrameRate();
+    _playForward = playForward;
+    playbackTimer->start((int)(1000.0 / (fps > 0 ? fps : 60)));
+    this->slotPlaybackTimeStep(playForward);
 }
 
 int GripMainWindow::saveText(std::string scenepath, const QString &filename)
@@ -436,7 +594,7 @@ void GripMainWindow::side()
 void GripMainWindow::xga1024x768()
 {
     if(!xga1024x768Act->isChecked())
-        recordSize = QSize(1024, 760);
+        recordSize = QSize(1024, 768);
     else {
         if(vga640x480Act->isChecked())
             vga640x480Act->toggle();
@@ -444,14 +602,14 @@ void GripMainWindow::xga1024x768()
         if(hd1280x720Act->isChecked())
             hd1280x720Act->toggle();
 
-        recordSize = QSize(1024, 760);
+        recordSize = QSize(1024, 768);
     }
 }
 
 void GripMainWindow::vga640x480()
 {
     if(!vga640x480Act->isChecked())
-        recordSize = QSize(640, 472);
+        recordSize = QSize(640, 480);
     else {
         if(xga1024x768Act->isChecked())
             xga1024x768Act->toggle();
@@ -459,14 +617,14 @@ void GripMainWindow::vga640x480()
         if(hd1280x720Act->isChecked())
             hd1280x720Act->toggle();
 
-        recordSize = QSize(640, 472);
+        recordSize = QSize(640, 480);
     }
 }
 
 void GripMainWindow::hd1280x720()
 {
     if(!hd1280x720Act->isChecked())
-        recordSize = QSize(1280, 712);
+        recordSize = QSize(1280, 720);
     else {
         if(vga640x480Act->isChecked())
             vga640x480Act->toggle();
@@ -474,7 +632,7 @@ void GripMainWindow::hd1280x720()
         if(xga1024x768Act->isChecked())
             xga1024x768Act->toggle();
 
-        recordSize = QSize(1280, 712);
+        recordSize = QSize(1280, 720);
     }
 }
 
@@ -488,12 +646,10 @@ void GripMainWindow::startSimulation()
     // If we have a valid world, start simulating
     if (world->getNumSkeletons()) {
         if (_simulationDirty) {
-            while (timeline->size() > _curPlaybackTick + 1) {
-                timeline->erase(timeline->end());
-            }
+            timeline->truncate(_curPlaybackTick + 1);
 
             // Set world back to last simulated timestep
-            if (timeline->size() > 0) {
+            if (!timeline->empty()) {
                 world->setTime(timeline->at(_curPlaybackTick).getTime());
                 this->setWorldState_Issue122(timeline->at(_curPlaybackTick).getState());
             }
@@ -502,7 +658,16 @@ void GripMainWindow::startSimulation()
 
         playbackWidget->ui->sliderMain->setDisabled(true);
 
+        for (int i = 0; i < pluginList->size(); ++i) {
+            if (pluginList->at(i)->isSubscribed(GRIP_EVENT_SIMULATION_START)) {
+                pluginList->at(i)->GRIPEventSimulationStart();
+            }
+        }
+
+        // The simulation moves the skeletons behind the state applier's back
+        _stateApplier.invalidate();
         _simulating = true;
+        viewWidget->setContinuousRendering(true);
         simulation->startSimulation();
         // FIXME: Maybe use qsignalmapping or std::map for this
         swapStartStopButtons();
@@ -516,6 +681,7 @@ void GripMainWindow::stopSimulation()
 {
     simulation->stopSimulation();
     _simulating = false;
+    viewWidget->setContinuousRendering(false);
     // FIXME: Maybe use qsignalmapping or std::map for this
     swapStartStopButtons();
 }
@@ -533,7 +699,9 @@ void GripMainWindow::swapStartStopButtons()
 
 void GripMainWindow::simulateSingleStep()
 {
+    _stateApplier.invalidate();
     simulation->simulateSingleTimeStep();
+    viewWidget->requestRedraw();
 }
 
 void GripMainWindow::renderDuringSimulation(){}
@@ -558,11 +726,100 @@ void GripMainWindow::resetCamera()
     viewWidget->setCameraToHomePosition();
 }
 
+void GripMainWindow::setTimelineRetention()
+{
+    if (_simulating) {
+        slotSetStatusBarMessage(tr("Stop simulation first"));
+        return;
+    }
+    if (_playingBack) {
+        slotPlaybackPause();
+    }
+
+    bool ok;
+    double seconds = QInputDialog::getDouble(this, tr("Timeline Retention"),
+                                             tr("Seconds of simulation to keep in memory (0 keeps everything).\n"
+                                                "Changing this clears the timeline."),
+                                             timeline->getRetention(), 0, 1e9, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    bool spill = false;
+    if (seconds > 0) {
+        spill = (QMessageBox::Yes == QMessageBox::question(this, tr("Timeline Retention"),
+                     tr("Spill older parts of the timeline to disk instead of dropping them?"),
+                     QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes));
+    }
+
+    timeline->setRetention(seconds, spill);
+    _curPlaybackTick = 0;
+    playbackWidget->reset();
+    slotSetStatusBarMessage(seconds > 0 ? tr("Keeping the last %1 s of the timeline in memory").arg(seconds)
+                                        : tr("Keeping the whole timeline in memory"));
+}
+
+void GripMainWindow::setMaxFrameRate()
+{
+    QString stats = tr("%1 frames rendered, %2 redraw requests merged")
+            .arg(viewWidget->getNumFramesRendered()).arg(viewWidget->getNumFramesSkipped());
+    slotSetStatusBarMessage(stats);
+
+    bool ok;
+    int fps = QInputDialog::getInt(this, tr("Maximum Frame Rate"),
+                                   tr("%1 so far.\nFrames rendered per second while simulating (0 for no limit):").arg(stats),
+                                   (int)viewWidget->getMaxFrameRate(), 0, 1000, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    viewWidget->setMaxFrameRate(fps);
+    viewWidget->resetFrameStats();
+    slotSetStatusBarMessage(fps > 0 ? tr("Rendering at most %1 frames per second").arg(fps)
+                                    : tr("Not limiting the frame rate"));
+}
+
+void GripMainWindow::setRenderingThreads()
+{
+    const osgViewer::ViewerBase::ThreadingModel models[] = {
+        osgViewer::ViewerBase::SingleThreaded,
+        osgViewer::ViewerBase::CullDrawThreadPerContext,
+        osgViewer::ViewerBase::DrawThreadPerContext,
+        osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext
+    };
+    const int numModels = sizeof(models) / sizeof(models[0]);
+
+    QStringList names;
+    int current = 0;
+    for (int i=0; i<numModels; ++i) {
+        names << ViewerWidget::getThreadingModelName(models[i]);
+        if (models[i] == viewWidget->getThreadingModel()) {
+            current = i;
+        }
+    }
+
+    bool ok;
+    QString name = QInputDialog::getItem(this, tr("Rendering Threads"), tr("Threading model:"),
+                                         names, current, false, &ok);
+    if (!ok) {
+        return;
+    }
+
+    viewWidget->setViewerThreadingModel(models[names.indexOf(name)]);
+    viewWidget->requestRedraw();
+    slotSetStatusBarMessage(tr("Rendering with %1").arg(name));
+}
+
 void GripMainWindow::createRenderingWindow()
 {
     viewWidget = new ViewerWidget();
     viewWidget->setGeometry(100, 100, 800, 600);
     viewWidget->addGrid(20, 20, 1);
+
+    // The scene is only rendered when it changes. Input anywhere in the window can
+    // change it through a tab or plugin, and the idle redraw catches anything else
+    qApp->installEventFilter(viewWidget);
+    viewWidget->setIdleRedrawInterval(1000);
 }
 
 void GripMainWindow::createTreeView()
@@ -635,6 +892,7 @@ void GripMainWindow::loadPluginFile(QString pluginFileName)
 
 void GripMainWindow::setSimulationRelativeTime(double time)
 {
+    timeline->evict();
     playbackWidget->slotSetTimeDisplays(world->getTime(), time);
 }
 
@@ -642,6 +900,7 @@ void GripMainWindow::createTabs()
 {
     inspectorTab = new InspectorTab(this, world, treeviewer);
     visualizationTab = new VisualizationTab(worldNode, treeviewer, this);
+    profilerWidget = new ProfilerWidget(profiler, this);
 }
 
 dart::dynamics::Skeleton* GripMainWindow::createGround()
@@ -691,6 +950,10 @@ void GripMainWindow::manageLayout()
     tabifyDockWidget(inspectorTab, visualizationTab);
     visualizationTab->show();
     visualizationTab->raise();
+
+    /// adding the profiler, which is only shown when asked for
+    this->addDockWidget(Qt::RightDockWidgetArea, profilerWidget);
+    profilerWidget->hide();
 }
 
 void GripMainWindow::createPluginMenu()
@@ -908,72 +1171,235 @@ void GripMainWindow::camera()
 
 void GripMainWindow::film()
 {
-    recordImageList = new QList<QImage>;
-
-    recordWidget = new QWidget;
-    recordWidget->resize(recordSize);
+    if (_simulating) {
+        slotSetStatusBarMessage(tr("Stop simulation first"));
+        return;
+    }
+    if (_playingBack) {
+        slotPlaybackPause();
+    }
+    if (timeline->empty()) {
+        slotSetStatusBarMessage(tr("Nothing in the timeline to record"));
+        return;
+    }
 
-    recordViewWidget = new ViewerWidget();
-    recordViewWidget->setGeometry(100, 100, 800, 600);
-    recordViewWidget->addGrid(20, 20, 1);
-    recordViewWidget->addNodeToScene(worldNode);
-    recordViewWidget->setViewMatrix(0, viewWidget->getViewMatrix());
-    recordViewWidget->getCameraManipulator(0)->setByMatrix(viewWidget->getCameraMatrix(0));
+    // Frames are written while recording, so pick where they go first
+    QString fileName = getVideoFileName();
+    if (fileName.isEmpty()) {
+        slotSetStatusBarMessage(tr("Not recording the playback"));
+        return;
+    }
 
-    QHBoxLayout* hLayout = new QHBoxLayout;
-    hLayout->addWidget(recordViewWidget);
+    // What playback would show from the slider to the end, one frame every 30th of a second
+    double speed = playbackWidget->getPlaybackSpeed();
+    if (speed <= 0) {
+        slotSetStatusBarMessage(tr("Set a playback speed above zero to record the playback"));
+        return;
+    }
+    slotSetStatusBarMessage(tr("Recording playback to %1").arg(fileName));
+    renderVideo(fileName, 30, timeline->getTime(playbackWidget->getSliderValue()), speed / 30);
+}
 
-    recordWidget->setLayout(hLayout);
-    recordWidget->setWindowTitle("Recording Window");
-    recordWidget->show();
+void GripMainWindow::exportVideo()
+{
+    if (_simulating) {
+        slotSetStatusBarMessage(tr("Stop simulation first"));
+        return;
+    }
+    if (_playingBack) {
+        slotPlaybackPause();
+    }
+    if (timeline->empty()) {
+        slotSetStatusBarMessage(tr("Nothing in the timeline to export"));
+        return;
+    }
 
-    QTime dieTime = QTime::currentTime().addMSecs(1000);
-    while(QTime::currentTime() < dieTime);
+    bool ok;
+    int fps = QInputDialog::getInt(this, tr("Export Video"), tr("Frames per second of simulated time:"),
+                                   30, 1, 1000, 1, &ok);
+    if (!ok) {
+        return;
+    }
 
-    _recordVideo = true;
-    slotPlaybackStart();
-    recordImageList->append(recordViewWidget->takeScreenshot());
+    QString fileName = getVideoFileName();
+    if (fileName.isEmpty()) {
+        slotSetStatusBarMessage(tr("Not exporting the timeline"));
+        return;
+    }
 
-    slotPlaybackTimeStep(true);
+    renderVideo(fileName, fps, timeline->front().getTime(), 1.0 / fps);
 }
 
-void GripMainWindow::saveVideo()
+void GripMainWindow::renderVideo(const QString &fileName, int fps, double startTime, double timeStep)
 {
-    _recordVideo = false;
+    if (!viewWidget->startOffscreenCapture(recordSize.width(), recordSize.height())) {
+        slotSetStatusBarMessage(tr("Could not create an offscreen buffer for recording"));
+        return;
+    }
+    videoEncoder->start(fileName, GripVideoEncoder::outputFromFileName(fileName), fps);
+
+    // One frame per output sample, whatever the simulation time step was
+    _playbackInterpolator.setWorld(*world);
+    double endTime = timeline->back().getTime();
+    int numFrames = (int)std::floor((endTime - startTime) / timeStep + 1e-9) + 1;
+
+    QProgressDialog progress(tr("Exporting video"), tr("Cancel"), 0, numFrames, this);
+    progress.setWindowModality(Qt::WindowModal);
+
+    QImage frame;
+    for (int i = 0; i < numFrames && !progress.wasCanceled(); ++i) {
+        // From the frame number, so the rounding error doesn't build up
+        double time = startTime + i * timeStep;
+
+        _playbackInterpolator.interpolate(*timeline, time, _playbackState);
+        world->setTime(time);
+        this->setWorldState_Issue122(_playbackState);
+        viewWidget->captureFrame();
+        while (viewWidget->takeCapturedFrame(frame)) {
+            videoEncoder->addFrame(frame);
+        }
+        progress.setValue(i);
+    }
 
-    recordWidget->close();
-    delete recordViewWidget;
-    recordViewWidget = NULL;
-    delete recordWidget;
-    recordWidget = NULL;
+    viewWidget->stopOffscreenCapture();
+    while (viewWidget->takeCapturedFrame(frame)) {
+        videoEncoder->addFrame(frame);
+    }
+    progress.setValue(numFrames);
+    saveVideo();
 
-    QString fileName;
-    QStringList dirNames; //stores the entire path of the file that it attempts to open
-    QString format = "png";
-    QStringList filters; //setting file filters
-    filters << "PNG Image files (*.png)"
+    // Put the world back where the playback slider is
+    slotSetWorldFromPlayback(playbackWidget->getSliderValue());
+}
+
+void GripMainWindow::saveTimeline()
+{
+    if (timeline->empty()) {
+        slotSetStatusBarMessage(tr("Nothing in the timeline to save"));
+        return;
+    }
+
+    QStringList filters;
+    filters << "Timeline files (*.griptimeline)"
             << "Any files (*)";
 
-    //initializing the File dialog box
-    //the static QFileDialog does not seem to be working correctly in Ubuntu 12.04 with unity.
-    //as per the documentation it may work correctly with gnome
-    //the method used below should work correctly on all desktops and is supposedly more powerful
     QFileDialog dialog(this);
     dialog.setNameFilters(filters);
     dialog.setAcceptMode(QFileDialog::AcceptSave);
-    dialog.setFileMode(QFileDialog::Directory);
-    //dialog.setOption(QFileDialog::ShowDirsOnly, true);
-    if (dialog.exec())
-        dirNames = dialog.selectedFiles();
+    dialog.setFileMode(QFileDialog::AnyFile);
+    dialog.setDefaultSuffix("griptimeline");
+    if (!dialog.exec() || dialog.selectedFiles().isEmpty()) {
+        return;
+    }
 
-    if (dirNames.isEmpty()) {
-        std::cerr << "No file was selected" << std::endl;
+    QString fileName = dialog.selectedFiles().front();
+    if (timeline->save(fileName.toStdString(), *world)) {
+        slotSetStatusBarMessage(tr(qPrintable("Saved timeline to " + fileName)));
+    } else {
+        slotSetStatusBarMessage(tr(qPrintable("Failed to save timeline to " + fileName)));
+    }
+}
+
+void GripMainWindow::loadTimeline()
+{
+    if (_simulating) {
+        slotSetStatusBarMessage(tr("Stop simulation first"));
+        return;
+    }
+    if (_playingBack) {
+        slotPlaybackPause();
+    }
+
+    QStringList filters;
+    filters << "Timeline files (*.griptimeline)"
+            << "Any files (*)";
+
+    QFileDialog dialog(this);
+    dialog.setNameFilters(filters);
+    dialog.setAcceptMode(QFileDialog::AcceptOpen);
+    dialog.setFileMode(QFileDialog::ExistingFile);
+    if (!dialog.exec() || dialog.selectedFiles().isEmpty()) {
+        return;
+    }
+
+    QString fileName = dialog.selectedFiles().front();
+    if (!timeline->load(fileName.toStdString(), *world)) {
+        slotSetStatusBarMessage(tr(qPrintable("Failed to load timeline " + fileName + ". Is the matching scene loaded?")));
+        return;
+    }
+
+    _curPlaybackTick = 0;
+    _simulationDirty = true;
+    playbackWidget->slotUpdateSliderMinMax(timeline->getFirstIndex(), timeline->size() - 1);
+    playbackWidget->setSliderValue(0);
+    slotSetWorldFromPlayback(0);
+    slotSetStatusBarMessage(tr(qPrintable("Loaded timeline " + fileName)));
+}
+
+void GripMainWindow::recordTimeline(bool record)
+{
+    if (!record) {
+        // The simulation thread may be appending to the file, so it has to be closed
+        // there. Blocking, so a new file can't be opened before this one is closed
+        QMetaObject::invokeMethod(simulation, "closeTimelineFile", Qt::BlockingQueuedConnection);
+        return;
+    }
+
+    if (_simulating) {
+        slotSetStatusBarMessage(tr("Stop simulation first"));
+        recordTimelineAct->setChecked(false);
+        return;
+    }
+
+    QStringList filters;
+    filters << "Timeline files (*.griptimeline)"
+            << "Any files (*)";
+
+    QFileDialog dialog(this);
+    dialog.setNameFilters(filters);
+    dialog.setAcceptMode(QFileDialog::AcceptSave);
+    dialog.setFileMode(QFileDialog::AnyFile);
+    dialog.setDefaultSuffix("griptimeline");
+    if (!dialog.exec() || dialog.selectedFiles().isEmpty()
+            || !simulation->setTimelineFile(dialog.selectedFiles().front().toStdString())) {
+        slotSetStatusBarMessage(tr("Not recording simulation to file"));
+        recordTimelineAct->setChecked(false);
         return;
+    }
+
+    slotSetStatusBarMessage(tr(qPrintable("Recording simulation to " + dialog.selectedFiles().front())));
+}
+
+QString GripMainWindow::getVideoFileName()
+{
+    QStringList filters;
+    filters << "Video files (*.mp4 *.avi *.mkv)"
+            << "PNG Image files (*.png)"
+            << "Raw BGRA frames (*.raw)";
+
+    QFileDialog dialog(this);
+    dialog.setNameFilters(filters);
+    dialog.setAcceptMode(QFileDialog::AcceptSave);
+    dialog.setFileMode(QFileDialog::AnyFile);
+    if (!dialog.exec() || dialog.selectedFiles().isEmpty()) {
+        return QString();
+    }
+
+    QString fileName = dialog.selectedFiles().front();
+    if (QFileInfo(fileName).suffix().isEmpty()) {
+        int filter = filters.indexOf(dialog.selectedNameFilter());
+        fileName += (filter == 1 ? ".png" : (filter == 2 ? ".raw" : ".mp4"));
+    }
+    return fileName;
+}
+
+void GripMainWindow::saveVideo()
+{
+    bool success = videoEncoder->finish();
+    int numFrames = videoEncoder->getNumFramesWritten();
+    if (success) {
+        slotSetStatusBarMessage(tr("Recorded %1 frames").arg(numFrames));
     } else {
-        for(int i = 0; i < recordImageList->count(); ++i) {
-            recordImageList->at(i).save(fileName.sprintf("%s/image%06d", dirNames.front().toStdString().c_str(), i), format.toAscii());
-        }
+        slotSetStatusBarMessage(tr("Recording failed, only %1 frames were written").arg(numFrames));
     }
-    delete recordImageList;
-    recordImageList = NULL;
 }
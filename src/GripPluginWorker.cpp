@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Local includes
+#include "GripPluginWorker.h"
+#include "GripTab.h"
+
+GripPluginWorker::GripPluginWorker(GripTab* plugin, size_t maxQueuedStates)
+    : QThread(),
+      _plugin(plugin),
+      _times(maxQueuedStates > 0 ? maxQueuedStates : 1),
+      _states(maxQueuedStates > 0 ? maxQueuedStates : 1),
+      _head(0),
+      _numQueued(0),
+      _numDropped(0),
+      _numDelivered(0),
+      _stopping(false)
+{
+    this->start();
+}
+
+GripPluginWorker::~GripPluginWorker()
+{
+    stop();
+}
+
+bool GripPluginWorker::post(double time, const Eigen::VectorXd& state)
+{
+    QMutexLocker locker(&_mutex);
+    if (_stopping) {
+        return false;
+    }
+
+    // Overwrite the oldest snapshot when the plugin is behind
+    bool dropped = false;
+    if (_numQueued == _states.size()) {
+        _head = (_head + 1) % _states.size();
+        --_numQueued;
+        ++_numDropped;
+        dropped = true;
+    }
+
+    // The slot keeps its storage, so this only allocates the first time around
+    size_t slot = (_head + _numQueued) % _states.size();
+    _times[slot] = time;
+    _states[slot] = state;
+    ++_numQueued;
+
+    _statePosted.wakeOne();
+    return !dropped;
+}
+
+void GripPluginWorker::stop()
+{
+    {
+        QMutexLocker locker(&_mutex);
+        _stopping = true;
+        _statePosted.wakeOne();
+    }
+    this->wait();
+}
+
+GripTab* GripPluginWorker::getPlugin() const
+{
+    return _plugin;
+}
+
+size_t GripPluginWorker::getNumDropped() const
+{
+    QMutexLocker locker(&_mutex);
+    return _numDropped;
+}
+
+size_t GripPluginWorker::getNumDelivered() const
+{
+    QMutexLocker locker(&_mutex);
+    return _numDelivered;
+}
+
+void GripPluginWorker::run()
+{
+    double time;
+    Eigen::VectorXd state;
+
+    while (true) {
+        {
+            QMutexLocker locker(&_mutex);
+            while (_numQueued == 0 && !_stopping) {
+                _statePosted.wait(&_mutex);
+            }
+            if (_numQueued == 0) {
+                return;
+            }
+
+            // Swap the snapshot out so the plugin runs without holding the lock
+            time = _times[_head];
+            state.swap(_states[_head]);
+            _head = (_head + 1) % _states.size();
+            --_numQueued;
+        }
+
+        _plugin->GRIPEventSimulationAfterTimestepAsync(time, state);
+
+        QMutexLocker locker(&_mutex);
+        ++_numDelivered;
+    }
+}
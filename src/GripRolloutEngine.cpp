@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Local includes
+#include "GripRolloutEngine.h"
+#include "HuboController.h"
+#include "gripTime.h"
+
+// DART includes
+#include <dart/dynamics/Skeleton.h>
+
+// Qt includes
+#include <QRunnable>
+#include <QThread>
+
+// C++ Standard includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+/**
+ * \brief Thread pool task running the rollouts of one worker of a GripRolloutEngine
+ */
+class GripRolloutTask : public QRunnable
+{
+public:
+    GripRolloutTask(GripRolloutEngine* engine, size_t worker)
+        : _engine(engine), _worker(worker) {}
+
+    void run()
+    {
+        _engine->_work(_worker);
+    }
+
+protected:
+    GripRolloutEngine* _engine;
+    size_t _worker;
+};
+
+GripRolloutEngine::GripRolloutEngine(GripWorldLoader loader, int numThreads, bool debug)
+    : _loader(loader),
+      _params(NULL),
+      _nextRollout(0),
+      _pool(new QThreadPool),
+      _skeletonIndex(0),
+      _recordInterval(10),
+      _numSteps(0),
+      _numThreads(1),
+      _debug(debug)
+{
+    setMaxThreadCount(numThreads > 0 ? numThreads : QThread::idealThreadCount());
+}
+
+GripRolloutEngine::~GripRolloutEngine()
+{
+    _pool->waitForDone();
+    delete _pool;
+    _clearWorlds();
+}
+
+bool GripRolloutEngine::setScene(const std::string& sceneFileName)
+{
+    if (sceneFileName == _sceneFileName && !_worlds.empty()) {
+        return true;
+    }
+
+    _clearWorlds();
+    _sceneFileName.clear();
+
+    dart::simulation::World* world = _loader(sceneFileName, _debug);
+    if (!world) {
+        std::cerr << "[GripRolloutEngine] Couldn't load scene " << sceneFileName << std::endl;
+        return false;
+    }
+    _worlds.push_back(world);
+    _initialState = world->getState();
+    _sceneFileName = sceneFileName;
+    return true;
+}
+
+void GripRolloutEngine::setControlledSkeleton(size_t skeletonIndex)
+{
+    _skeletonIndex = skeletonIndex;
+}
+
+void GripRolloutEngine::setRecordInterval(size_t numSteps)
+{
+    _recordInterval = (numSteps > 0 ? numSteps : 1);
+}
+
+void GripRolloutEngine::setMaxThreadCount(int numThreads)
+{
+    _numThreads = (numThreads > 0 ? numThreads : 1);
+    _pool->setMaxThreadCount(_numThreads);
+}
+
+size_t GripRolloutEngine::run(const std::vector<GripRolloutParams>& params, size_t numSteps)
+{
+    if (_worlds.empty()) {
+        std::cerr << "[GripRolloutEngine] No scene to run rollouts in. Call setScene() first" << std::endl;
+        return 0;
+    }
+    if (_skeletonIndex >= (size_t)_worlds[0]->getNumSkeletons()) {
+        std::cerr << "[GripRolloutEngine] The scene has no skeleton " << _skeletonIndex << std::endl;
+        return 0;
+    }
+
+    // DART can't copy a world, so every extra worker parses its own copy of the
+    // scene once. They're kept for later runs and reset before every rollout
+    size_t numWorkers = std::min((size_t)_numThreads, params.size());
+    while (_worlds.size() < numWorkers) {
+        dart::simulation::World* world = _loader(_sceneFileName, _debug);
+        if (!world) {
+            break;
+        }
+        _worlds.push_back(world);
+    }
+    numWorkers = std::min(numWorkers, _worlds.size());
+
+    _params = &params;
+    _numSteps = numSteps;
+    _metrics.assign(params.size(), GripRolloutMetrics());
+    _times.assign(params.size(), Eigen::VectorXd());
+    _states.assign(params.size(), Eigen::MatrixXf());
+    _nextRollout = 0;
+
+    double startTime = grip::getTime();
+    for (size_t i=0; i<numWorkers; ++i) {
+        _pool->start(new GripRolloutTask(this, i));
+    }
+    _pool->waitForDone();
+    _params = NULL;
+
+    size_t numRun = 0;
+    for (size_t i=0; i<_metrics.size(); ++i) {
+        numRun += _metrics[i].success;
+    }
+
+    if (_debug) {
+        std::cerr << "[GripRolloutEngine] Ran " << numRun << " of " << params.size() << " rollouts of "
+                  << numSteps << " steps on " << numWorkers << " threads in "
+                  << grip::getTime() - startTime << " s" << std::endl;
+    }
+    return numRun;
+}
+
+size_t GripRolloutEngine::getNumRollouts() const
+{
+    return _metrics.size();
+}
+
+const std::vector<GripRolloutMetrics>& GripRolloutEngine::getMetrics() const
+{
+    return _metrics;
+}
+
+const Eigen::VectorXd& GripRolloutEngine::getTimes(size_t rollout) const
+{
+    return _times.at(rollout);
+}
+
+const Eigen::MatrixXf& GripRolloutEngine::getStates(size_t rollout) const
+{
+    return _states.at(rollout);
+}
+
+int GripRolloutEngine::getStateSize() const
+{
+    return _initialState.size();
+}
+
+void GripRolloutEngine::_work(size_t worker)
+{
+    dart::simulation::World* world = _worlds[worker];
+    size_t rollout;
+    while ((rollout = _nextRollout++) < _params->size()) {
+        _runRollout(world, rollout);
+    }
+}
+
+void GripRolloutEngine::_runRollout(dart::simulation::World* world, size_t rollout)
+{
+    const GripRolloutParams& params = (*_params)[rollout];
+    GripRolloutMetrics& metrics = _metrics[rollout];
+    metrics.index = rollout;
+    metrics.success = 0;
+    metrics.numSteps = 0;
+    metrics.simTime = 0;
+    metrics.realTime = 0;
+    metrics.rmsError = 0;
+    metrics.maxError = 0;
+    metrics.maxTorque = 0;
+    metrics.finalComHeight = 0;
+
+    world->setTime(0);
+    _resetWorld(world);
+    dart::dynamics::Skeleton* skel = world->getSkeleton(_skeletonIndex);
+    int n = skel->getNumGenCoords();
+
+    bool controlled = (params.Kp.size() > 0 || params.Kd.size() > 0);
+    if (controlled && (params.Kp.size() != n || params.Kd.size() != n)) {
+        std::cerr << "[GripRolloutEngine] Rollout " << rollout << " has " << params.Kp.size() << " Kp and "
+                  << params.Kd.size() << " Kd gains for a skeleton with " << n << " DOFs" << std::endl;
+        return;
+    }
+
+    // Hold the skeleton where it starts. The first tick is at time 0, so the
+    // controller starts a time step earlier to see a full step there
+    HuboController controller(skel, (controlled ? params.Kp : Eigen::VectorXd::Zero(n)),
+                              Eigen::VectorXd::Zero(n), (controlled ? params.Kd : Eigen::VectorXd::Zero(n)),
+                              Eigen::VectorXd::Ones(n), -world->getTimeStep());
+    controller.refPos = skel->get_q();
+    Eigen::VectorXd torques = Eigen::VectorXd::Zero(n);
+    Eigen::VectorXd error(n);
+
+    size_t numSamples = _numSteps / _recordInterval + 1;
+    Eigen::VectorXd& times = _times[rollout];
+    Eigen::MatrixXf& states = _states[rollout];
+    times.resize(numSamples);
+    states.resize(_initialState.size(), numSamples);
+    times[0] = 0;
+    states.col(0) = _initialState.cast<float>();
+    size_t sample = 1;
+
+    double start = grip::getTime();
+    double sumSquaredError = 0;
+    for (size_t step=0; step<_numSteps; ++step) {
+        if (controlled) {
+            controller.getTorques(skel->get_q(), skel->get_dq(), world->getTime(), torques);
+            skel->setInternalForceVector(torques);
+            metrics.maxTorque = std::max(metrics.maxTorque, torques.cwiseAbs().maxCoeff());
+        }
+
+        world->step();
+
+        error = skel->get_q() - controller.refPos;
+        sumSquaredError += error.squaredNorm();
+        metrics.maxError = std::max(metrics.maxError, error.cwiseAbs().maxCoeff());
+
+        if ((step + 1) % _recordInterval == 0) {
+            times[sample] = world->getTime();
+            states.col(sample) = world->getState().cast<float>();
+            ++sample;
+        }
+    }
+
+    // The next rollout in this world starts without our torques
+    skel->setInternalForceVector(Eigen::VectorXd::Zero(n));
+
+    metrics.success = 1;
+    metrics.numSteps = _numSteps;
+    metrics.simTime = world->getTime();
+    metrics.realTime = grip::getTime() - start;
+    metrics.rmsError = (_numSteps > 0 && n > 0 ? std::sqrt(sumSquaredError / (_numSteps * n)) : 0);
+    metrics.finalComHeight = skel->getWorldCOM()[2];
+}
+
+void GripRolloutEngine::_resetWorld(dart::simulation::World* world)
+{
+    for (int i=0; i<world->getNumSkeletons(); ++i) {
+        dart::dynamics::Skeleton* skel = world->getSkeleton(i);
+        int start = 2 * world->getIndex(i);
+        int n = skel->getNumGenCoords();
+
+        // setConfig does the forward kinematics, and unlike setState it sets
+        // up the FreeJoint transforms properly (DART issue 122)
+        skel->set_dq(_initialState.segment(start + n, n));
+        skel->setConfig(_initialState.segment(start, n));
+    }
+}
+
+void GripRolloutEngine::_clearWorlds()
+{
+    for (size_t i=0; i<_worlds.size(); ++i) {
+        delete _worlds[i];
+    }
+    _worlds.clear();
+}
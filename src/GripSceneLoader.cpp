@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Local includes
+#include "GripSceneLoader.h"
+#include "MeshCache.h"
+
+// DART includes
+#include <dart/dynamics/Skeleton.h>
+#include <dart/dynamics/BodyNode.h>
+#include <dart/dynamics/Shape.h>
+#include <dart/dynamics/MeshShape.h>
+#include <dart/utils/urdf/DartLoader.h>
+#include <dart/utils/sdf/SdfParser.h>
+
+// Standard C++ includes
+#include <iostream>
+#include <set>
+
+// QT includes
+#include <QThread>
+#include <QRunnable>
+
+/**
+ * \brief Thread pool task converting one mesh into the osgDart::MeshCache
+ */
+class GripMeshTask : public QRunnable
+{
+public:
+    GripMeshTask(GripSceneLoader* loader, const aiScene* aiscene)
+        : _loader(loader), _aiscene(aiscene) {}
+
+    void run()
+    {
+        osgDart::MeshCache::getNode(_aiscene);
+        _loader->_taskDone(QObject::tr("converting meshes"));
+    }
+
+protected:
+    GripSceneLoader* _loader;
+    const aiScene* _aiscene;
+};
+
+/**
+ * \brief Thread pool task building the SkeletonNode of one skeleton. Every task
+ * writes to its own element of the loader's SkeletonNode array.
+ */
+class GripSkeletonNodeTask : public QRunnable
+{
+public:
+    GripSkeletonNodeTask(GripSceneLoader* loader, size_t skeletonIndex)
+        : _loader(loader), _skeletonIndex(skeletonIndex) {}
+
+    void run()
+    {
+        const dart::dynamics::Skeleton& skel = *_loader->_world->getSkeleton(_skeletonIndex);
+        _loader->_skeletonNodes[_skeletonIndex] = new osgDart::SkeletonNode(skel, _loader->_debug);
+        _loader->_taskDone(QObject::tr("building skeletons"));
+    }
+
+protected:
+    GripSceneLoader* _loader;
+    size_t _skeletonIndex;
+};
+
+GripSceneLoader::GripSceneLoader(MainWindow* parent, bool debug)
+    : QObject(),
+      _world(NULL),
+      _pool(new QThreadPool),
+      _thread(new QThread),
+      _numDone(0),
+      _numTotal(0),
+      _debug(debug)
+{
+    // Signals and slots for the worker object and thread
+    connect(this, SIGNAL(destroyed()), _thread, SLOT(quit()));
+    connect(_thread, SIGNAL(finished()), _thread, SLOT(deleteLater()));
+
+    if (parent) {
+        connect(this, SIGNAL(progressChanged(int,int,QString)), parent, SLOT(sceneLoadProgress(int,int,QString)));
+        connect(this, SIGNAL(sceneLoaded(bool)), parent, SLOT(sceneLoaded(bool)));
+    }
+
+    // Move class instance to its own thread and start the thread
+    this->moveToThread(_thread);
+    _thread->start();
+}
+
+GripSceneLoader::~GripSceneLoader()
+{
+    _pool->waitForDone();
+    delete _pool;
+    _thread->deleteLater();
+}
+
+void GripSceneLoader::load(QString fileName)
+{
+    bool success = loadScene(fileName.toStdString());
+    emit sceneLoaded(success);
+}
+
+bool GripSceneLoader::loadScene(std::string fileName)
+{
+    // Anything from the last scene that wasn't taken is still ours
+    _fileName = fileName;
+    _skeletonNodes.clear();
+    delete _world;
+    _world = parseScene(fileName, _debug);
+    if (!_world) {
+        return false;
+    }
+
+    // Every distinct mesh in the scene. Shapes sharing an aiScene only need one task
+    std::set<const aiScene*> meshes;
+    for (int i=0; i<_world->getNumSkeletons(); ++i) {
+        dart::dynamics::Skeleton* skel = _world->getSkeleton(i);
+        for (int j=0; j<skel->getNumBodyNodes(); ++j) {
+            dart::dynamics::BodyNode* node = skel->getBodyNode(j);
+            for (int k=0; k<node->getNumVisualizationShapes(); ++k) {
+                if (node->getVisualizationShape(k)->getShapeType() == dart::dynamics::Shape::MESH) {
+                    meshes.insert(static_cast<dart::dynamics::MeshShape*>(node->getVisualizationShape(k))->getMesh());
+                }
+            }
+            for (int k=0; k<node->getNumCollisionShapes(); ++k) {
+                if (node->getCollisionShape(k)->getShapeType() == dart::dynamics::Shape::MESH) {
+                    meshes.insert(static_cast<dart::dynamics::MeshShape*>(node->getCollisionShape(k))->getMesh());
+                }
+            }
+        }
+    }
+    meshes.erase(NULL);
+
+    _numDone = 0;
+    _numTotal = meshes.size() + _world->getNumSkeletons();
+    if (_debug) {
+        std::cerr << "[GripSceneLoader] Loading " << meshes.size() << " meshes and "
+                  << _world->getNumSkeletons() << " skeletons from " << fileName
+                  << " on " << _pool->maxThreadCount() << " threads" << std::endl;
+    }
+
+    // Convert the meshes first so the SkeletonNodes only hit the cache. The pool
+    // deletes the tasks when they're done
+    for (std::set<const aiScene*>::const_iterator it = meshes.begin(); it != meshes.end(); ++it) {
+        _pool->start(new GripMeshTask(this, *it));
+    }
+    _pool->waitForDone();
+
+    // Each skeleton is only read by its own task, and the nodes aren't in a scene graph yet
+    _skeletonNodes.resize(_world->getNumSkeletons());
+    for (int i=0; i<_world->getNumSkeletons(); ++i) {
+        _pool->start(new GripSkeletonNodeTask(this, i));
+    }
+    _pool->waitForDone();
+
+    return true;
+}
+
+dart::simulation::World* GripSceneLoader::parseScene(std::string fileName, bool debug)
+{
+    dart::simulation::World* sceneWorld = NULL;
+    dart::dynamics::Skeleton* sceneSkeleton = NULL;
+
+    std::string extension = fileName.substr(fileName.find_last_of(".") + 1);
+    if (extension == "sdf") {
+        dart::utils::SdfParser sdfParser;
+        sceneWorld = sdfParser.readSdfFile(fileName);
+    } else if (extension == "urdf") {
+        dart::utils::DartLoader urdfLoader;
+        sceneWorld = urdfLoader.parseWorld(fileName);
+        if (!sceneWorld) {
+            sceneSkeleton = urdfLoader.parseSkeleton(fileName);
+        }
+    } else {
+        std::cerr << "[GripSceneLoader] Unknown scene file type \"" << extension << "\" of " << fileName
+                  << ". Only .urdf and .sdf files can be loaded" << std::endl;
+        return NULL;
+    }
+
+    if (!sceneWorld && !sceneSkeleton) {
+        std::cerr << "[GripSceneLoader] Failed to parse scene file " << fileName
+                  << ". Line " << __LINE__ << " of " << __FILE__ << std::endl;
+        return NULL;
+    }
+
+    // Adding the skeleton to a world initializes it, which building its nodes needs
+    if (!sceneWorld) {
+        sceneWorld = new dart::simulation::World();
+        sceneWorld->addSkeleton(sceneSkeleton);
+    }
+
+    if (debug) {
+        std::cerr << "[GripSceneLoader] Parsed " << sceneWorld->getNumSkeletons()
+                  << " skeletons from " << fileName << std::endl;
+    }
+    return sceneWorld;
+}
+
+dart::simulation::World* GripSceneLoader::takeWorld()
+{
+    dart::simulation::World* world = _world;
+    _world = NULL;
+    return world;
+}
+
+std::vector<osg::ref_ptr<osgDart::SkeletonNode> > GripSceneLoader::takeSkeletonNodes()
+{
+    std::vector<osg::ref_ptr<osgDart::SkeletonNode> > skeletonNodes;
+    skeletonNodes.swap(_skeletonNodes);
+    return skeletonNodes;
+}
+
+std::string GripSceneLoader::getFileName() const
+{
+    return _fileName;
+}
+
+void GripSceneLoader::setMaxThreadCount(int numThreads)
+{
+    _pool->setMaxThreadCount(numThreads > 0 ? numThreads : QThread::idealThreadCount());
+}
+
+void GripSceneLoader::_taskDone(const QString& stage)
+{
+    int numDone = ++_numDone;
+    emit progressChanged(numDone, _numTotal, stage);
+}
@@ -57,13 +57,30 @@
 // QT includes
 #include <QThread>
 
-GripSimulation::GripSimulation(dart::simulation::World* world, std::vector<GripTimeslice>* timeline,
+GripSimulation::GripSimulation(dart::simulation::World* world, GripTimeline* timeline,
                                QList<GripTab*>* pluginList, MainWindow* parent, bool debug)
     : QObject(),
       _world(world),
       _timeline(timeline),
+      _timelineFile(NULL),
+      _timelineFileStart(0),
+      _snapshotBuffer(NULL),
       _plugins(pluginList),
+      _numSteps(0),
+      _profiler(NULL),
+      _phaseStep(0),
+      _phasePluginsBefore(0),
+      _phaseDynamics(0),
+      _phaseTimeline(0),
+      _phaseSnapshot(0),
+      _phasePluginsAfter(0),
+      _phaseSignals(0),
+      _stepPending(false),
+      _stepSucceeded(false),
+      _stepCount(0),
       _thread(new QThread),
+      _batchCheckSteps(1000),
+      _batchCheckInterval(0.1),
       _simulating(false),
       _simulateOneFrame(false),
       _debug(debug)
@@ -72,14 +89,17 @@ GripSimulation::GripSimulation(dart::simulation::World* world, std::vector<GripT
     connect(this, SIGNAL(destroyed()), _thread, SLOT(quit()));
     connect(_thread, SIGNAL(finished()), _thread, SLOT(deleteLater()));
 
-    // Signal and slot for informing the parent that the simulation loop in stopped
-    connect(this, SIGNAL(simulationStoppedSignal()), parent, SLOT(simulationStopped()));
+    // Only hook up to the parent if there is one. In headless mode there's no main window
+    if (parent) {
+        // Signal and slot for informing the parent that the simulation loop in stopped
+        connect(this, SIGNAL(simulationStoppedSignal()), parent, SLOT(simulationStopped()));
 
-    // Signal and slot for sending the simulation time relative to real time (instantaneous) to the parent
-    connect(this, SIGNAL(signalRelTimeChanged(double)), parent, SLOT(setSimulationRelativeTime(double)));
+        // Signal and slot for sending the simulation time relative to real time (instantaneous) to the parent
+        connect(this, SIGNAL(signalRelTimeChanged(double)), parent, SLOT(setSimulationRelativeTime(double)));
 
-    // Signal and slot for sending a message to the status bar
-    connect(this, SIGNAL(signalSendMessage(QString)), parent, SLOT(slotSetStatusBarMessage(QString)));
+        // Signal and slot for sending a message to the status bar
+        connect(this, SIGNAL(signalSendMessage(QString)), parent, SLOT(slotSetStatusBarMessage(QString)));
+    }
 
     // Move class instance to its own thread and start the thread
     this->moveToThread(_thread);
@@ -89,6 +109,14 @@ GripSimulation::GripSimulation(dart::simulation::World* world, std::vector<GripT
 
 GripSimulation::~GripSimulation()
 {
+    closeTimelineFile();
+
+    // Lets the asynchronous plugins finish what's queued for them
+    std::map<GripTab*, GripPluginWorker*>::iterator it;
+    for (it = _pluginWorkers.begin(); it != _pluginWorkers.end(); ++it) {
+        delete it->second;
+    }
+
     _thread->deleteLater();
 }
 
@@ -100,13 +128,134 @@ void GripSimulation::reset()
     _prevTime = 0;
 }
 
+void GripSimulation::setBatchCheckRate(size_t numSteps, double interval)
+{
+    _batchCheckSteps = (numSteps > 0 ? numSteps : 1);
+    _batchCheckInterval = interval;
+}
+
+bool GripSimulation::setTimelineFile(std::string fileName)
+{
+    closeTimelineFile();
+
+    if (!_world) {
+        std::cerr << "[GripSimulation] Can't record to " << fileName << " because there's no world yet" << std::endl;
+        return false;
+    }
+
+    _timelineFile = new GripTimelineFile();
+    if (!_timelineFile->create(fileName, *_world)) {
+        delete _timelineFile;
+        _timelineFile = NULL;
+        return false;
+    }
+
+    _timelineFileStart = _timeline->size();
+
+    if (_debug) {
+        std::cerr << "[GripSimulation] Recording timeline to " << fileName << std::endl;
+    }
+    return true;
+}
+
+void GripSimulation::closeTimelineFile()
+{
+    delete _timelineFile;
+    _timelineFile = NULL;
+}
+
+void GripSimulation::_truncateTimelineFile()
+{
+    if (!_timelineFile) {
+        return;
+    }
+
+    // Starting over from an earlier slice cuts the timeline back, and the file has to follow
+    size_t size = _timeline->size();
+    if (size >= _timelineFileStart + _timelineFile->size()) {
+        return;
+    }
+    if (size < _timelineFileStart) {
+        _timelineFileStart = size;
+    }
+    _timelineFile->truncate(size - _timelineFileStart);
+}
+
+void GripSimulation::setSnapshotBuffer(osgDart::WorldSnapshotBuffer* snapshotBuffer)
+{
+    _snapshotBuffer = snapshotBuffer;
+}
+
+void GripSimulation::setProfiler(GripProfiler* profiler)
+{
+    _profiler = profiler;
+    if (_profiler) {
+        _phaseStep = _profiler->addPhase("simulation: time step");
+        _phasePluginsBefore = _profiler->addPhase("simulation: plugins before step");
+        _phaseDynamics = _profiler->addPhase("simulation: dynamics and collision");
+        _phaseTimeline = _profiler->addPhase("simulation: timeline");
+        _phaseSnapshot = _profiler->addPhase("simulation: snapshot");
+        _phasePluginsAfter = _profiler->addPhase("simulation: plugins after step");
+        _phaseSignals = _profiler->addPhase("simulation: signal emission");
+    }
+}
+
 void GripSimulation::addWorldToTimeline(const dart::simulation::World& worldToAdd)
 {
     assert(worldToAdd.getTime() >= 0);
-    assert(worldToAdd.getState().rows() >= 0);
 
-    GripTimeslice timeslice(worldToAdd);
-    _timeline->push_back(timeslice);
+    _state = worldToAdd.getState();
+    _timeline->push_back(worldToAdd.getTime(), _state);
+    if (_timelineFile) {
+        _timelineFile->append(worldToAdd.getTime(), _state.data());
+    }
+}
+
+void GripSimulation::_updateSubscriptions()
+{
+    _beforeStepSubscribers.clear();
+    _afterStepSubscribers.clear();
+
+    for (int i=0; i<_plugins->size(); ++i) {
+        GripTab* plugin = _plugins->at(i);
+
+        GripStepSubscriber subscriber;
+        subscriber.plugin = plugin;
+        subscriber.period = 1;
+        subscriber.worker = NULL;
+
+        gripCallbackRate_t rate = plugin->getCallbackRate();
+        if (rate != GRIP_CALLBACK_EVERY_STEP && plugin->getCallbackPeriod() > 1) {
+            subscriber.period = plugin->getCallbackPeriod();
+        }
+
+        if (rate == GRIP_CALLBACK_ASYNC) {
+            // Asynchronous plugins only get state snapshots after time steps
+            if (!plugin->isSubscribed(GRIP_EVENT_SIMULATION_AFTER_TIMESTEP)) {
+                continue;
+            }
+            std::map<GripTab*, GripPluginWorker*>::iterator it = _pluginWorkers.find(plugin);
+            if (it == _pluginWorkers.end()) {
+                it = _pluginWorkers.insert(std::make_pair(plugin, new GripPluginWorker(plugin))).first;
+            }
+            subscriber.worker = it->second;
+            _afterStepSubscribers.push_back(subscriber);
+            continue;
+        }
+
+        if (plugin->isSubscribed(GRIP_EVENT_SIMULATION_BEFORE_TIMESTEP)) {
+            _beforeStepSubscribers.push_back(subscriber);
+        }
+        if (plugin->isSubscribed(GRIP_EVENT_SIMULATION_AFTER_TIMESTEP)) {
+            _afterStepSubscribers.push_back(subscriber);
+        }
+    }
+
+    if (_debug) {
+        std::cerr << "[GripSimulation] " << _beforeStepSubscribers.size() << " plugins before and "
+                  << _afterStepSubscribers.size() << " after each time step, "
+                  << _pluginWorkers.size() << " asynchronous" << std::endl;
+    }
 }
 
 void GripSimulation::startSimulation()
@@ -118,14 +267,22 @@ void GripSimulation::startSimulation()
     _simulating = true;
 
     if (_world) {
+        _updateSubscriptions();
         emit this->signalSendMessage(tr("Simulating"));
         _simulationStartTime = grip::getTime();
         _prevTime = grip::getTime();
 
+        _truncateTimelineFile();
         if (_timeline->size() == 0) {
             addWorldToTimeline(*_world);
         }
 
+        // From here on the renderer only draws published snapshots
+        if (_snapshotBuffer) {
+            _snapshotBuffer->setLive(true);
+            _snapshotBuffer->publish(*_world);
+        }
+
         simulateTimeStep();
     } else {
         emit signalSendMessage(tr("Not simulating b/c there's no world"));
@@ -135,30 +292,70 @@ void GripSimulation::startSimulation()
     }
 
 }
-void GripSimulation::simulateTimeStep()
+void GripSimulation::stepWorld()
 {
-    if (_simulating) {
+    GripScopedTimer stepTimer(_profiler, _phaseStep);
 
-        // Run each tabs doBeforeSimulationTimeStep function
-        for (int i=0; i<_plugins->size(); ++i) {
-            _plugins->at(i)->GRIPEventSimulationBeforeTimestep();
+    // Run the before time step function of each subscribed plugin that's due
+    {
+        GripScopedTimer timer(_profiler, _phasePluginsBefore);
+        for (size_t i=0; i<_beforeStepSubscribers.size(); ++i) {
+            if (_numSteps % _beforeStepSubscribers[i].period == 0) {
+                _beforeStepSubscribers[i].plugin->GRIPEventSimulationBeforeTimestep();
+            }
         }
+    }
 
-        // Simulate timestep by stepping the world dynamics forward one step
+    // Simulate timestep by stepping the world dynamics forward one step. Collision
+    // detection happens inside World::step, so it's timed along with the dynamics
+    {
+        GripScopedTimer timer(_profiler, _phaseDynamics);
         _world->step();
+    }
+    {
+        GripScopedTimer timer(_profiler, _phaseTimeline);
         addWorldToTimeline(*_world);
+    }
+    if (_snapshotBuffer) {
+        GripScopedTimer timer(_profiler, _phaseSnapshot);
+        _snapshotBuffer->publish(*_world);
+    }
 
-        // Run each tabs doBeforeSimulationTimeStep function
-        for (int i=0; i<_plugins->size(); ++i) {
-            _plugins->at(i)->GRIPEventSimulationAfterTimestep();
+    // Run the after time step function of each subscribed plugin that's due, or
+    // hand asynchronous plugins a copy of the state
+    {
+        GripScopedTimer timer(_profiler, _phasePluginsAfter);
+        for (size_t i=0; i<_afterStepSubscribers.size(); ++i) {
+            const GripStepSubscriber& subscriber = _afterStepSubscribers[i];
+            if (_numSteps % subscriber.period != 0) {
+                continue;
+            }
+            if (subscriber.worker) {
+                subscriber.worker->post(_world->getTime(), _state);
+            } else {
+                subscriber.plugin->GRIPEventSimulationAfterTimestep();
+            }
         }
+    }
+
+    ++_numSteps;
+}
+
+void GripSimulation::simulateTimeStep()
+{
+    if (_simulating) {
+
+        stepWorld();
 
         double curTime = grip::getTime();
         double timeStepDuration = curTime - _prevTime;
         _simulationDuration = _simulationDuration + timeStepDuration;
         _simTimeRelToRealTimeInstantaneous = _world->getTimeStep() / timeStepDuration;
         _prevTime = curTime;
-        emit signalRelTimeChanged(_simTimeRelToRealTimeInstantaneous);
+        {
+            GripScopedTimer timer(_profiler, _phaseSignals);
+            emit signalRelTimeChanged(_simTimeRelToRealTimeInstantaneous);
+        }
 
 //        std::cerr << "Sim2 | Real | RelInst | RelOverall: "
 //                  << _world->getTime() << " | "
@@ -175,6 +372,13 @@ void GripSimulation::simulateTimeStep()
             QMetaObject::invokeMethod(this, "simulateTimeStep", Qt::QueuedConnection);
         }
     } else { // Get out of this function so we don't call ourselves again
+        if (_timelineFile) {
+            _timelineFile->flush();
+        }
+        // The world isn't stepped anymore, so the renderer can read it directly again
+        if (_snapshotBuffer) {
+            _snapshotBuffer->setLive(false);
+        }
         emit simulationStoppedSignal();
         return;
     }
@@ -184,6 +388,7 @@ void GripSimulation::simulateSingleTimeStep()
 {
     _simulating = true;
     _simulateOneFrame = true;
+    _updateSubscriptions();
 
     if (_debug) {
         emit signalSendMessage(tr("[GripSimulation] Simulating a single timestep"));
@@ -195,6 +400,178 @@ void GripSimulation::simulateSingleTimeStep()
     _simulateOneFrame = false;
 }
 
+void GripSimulation::simulateBatch(int numSteps)
+{
+    if (!_world) {
+        emit signalSendMessage(tr("Not simulating b/c there's no world"));
+        std::cerr << "[GripSimulation] Not simulating because there's no world yet. From line "
+                  << __LINE__ << " of " << __FILE__
+                  << std::endl;
+        emit simulationStoppedSignal();
+        return;
+    }
+
+    if (_debug) {
+        std::cerr << "[GripSimulation] Simulating " << numSteps << " steps in batch mode" << std::endl;
+    }
+
+    _simulating = true;
+    _simulateOneFrame = false;
+    _updateSubscriptions();
+    emit signalSendMessage(tr("Simulating"));
+
+    _truncateTimelineFile();
+    if (_timeline->size() == 0) {
+        addWorldToTimeline(*_world);
+    }
+
+    if (_snapshotBuffer) {
+        _snapshotBuffer->setLive(true);
+        _snapshotBuffer->publish(*_world);
+    }
+
+    _simulationStartTime = grip::getTime();
+    _prevTime = _simulationStartTime;
+    size_t stepsSinceCheck = 0;
+
+    // Step the world without going through the event loop. The stop flag and
+    // the clock are only looked at every so often to keep the loop tight
+    for (int step = 0; step < numSteps; ++step) {
+        stepWorld();
+        ++stepsSinceCheck;
+
+        bool lastStep = (step + 1 == numSteps);
+        double curTime = grip::getTime();
+        if (stepsSinceCheck >= _batchCheckSteps || curTime - _prevTime >= _batchCheckInterval || lastStep) {
+            double checkDuration = curTime - _prevTime;
+            _simulationDuration = _simulationDuration + checkDuration;
+            if (checkDuration > 0) {
+                _simTimeRelToRealTimeInstantaneous = stepsSinceCheck * _world->getTimeStep() / checkDuration;
+            }
+            _prevTime = curTime;
+            stepsSinceCheck = 0;
+            {
+                GripScopedTimer timer(_profiler, _phaseSignals);
+                emit signalRelTimeChanged(_simTimeRelToRealTimeInstantaneous);
+            }
+
+            if (!_simulating) {
+                break;
+            }
+        }
+    }
+
+    _simulating = false;
+    if (_timelineFile) {
+        _timelineFile->flush();
+    }
+    if (_snapshotBuffer) {
+        _snapshotBuffer->setLive(false);
+    }
+    emit simulationStoppedSignal();
+}
+
+bool GripSimulation::stepSynchronous(size_t numSteps, const Eigen::VectorXd& torques, Eigen::VectorXd& state)
+{
+    if (!_world) {
+        std::cerr << "[GripSimulation] Can't step because there's no world yet" << std::endl;
+        return false;
+    }
+    if (_simulating) {
+        std::cerr << "[GripSimulation] Can't step while the simulation is running" << std::endl;
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(_stepMutex);
+    if (_stepPending) {
+        std::cerr << "[GripSimulation] Can't step while another step request is running" << std::endl;
+        return false;
+    }
+    _stepPending = true;
+    _stepCount = numSteps;
+    _stepTorques = torques;
+
+    if (QThread::currentThread() == this->thread()) {
+        // Waiting for our own event loop would never return
+        lock.unlock();
+        bool success = _runStepRequest();
+        lock.lock();
+        _stepPending = false;
+        state = _stepState;
+        return success;
+    }
+
+    QMetaObject::invokeMethod(this, "processStepRequest", Qt::QueuedConnection);
+    while (_stepPending) {
+        _stepDone.wait(lock);
+    }
+    state = _stepState;
+    return _stepSucceeded;
+}
+
+void GripSimulation::processStepRequest()
+{
+    bool success = _runStepRequest();
+
+    std::lock_guard<std::mutex> lock(_stepMutex);
+    _stepSucceeded = success;
+    _stepPending = false;
+    _stepDone.notify_all();
+}
+
+bool GripSimulation::_runStepRequest()
+{
+    // The simulation may have been started after the request was queued
+    if (_simulating) {
+        std::cerr << "[GripSimulation] Can't step while the simulation is running" << std::endl;
+        return false;
+    }
+
+    // Only this thread touches the request until _stepPending is cleared
+    int numDofs = 0;
+    for (int i=0; i<_world->getNumSkeletons(); ++i) {
+        numDofs += _world->getSkeleton(i)->getNumGenCoords();
+    }
+    if (_stepTorques.size() != 0 && _stepTorques.size() != numDofs) {
+        std::cerr << "[GripSimulation] Got " << _stepTorques.size() << " torques for a world with "
+                  << numDofs << " DOFs" << std::endl;
+        return false;
+    }
+
+    _updateSubscriptions();
+    _truncateTimelineFile();
+    if (_timeline->size() == 0) {
+        addWorldToTimeline(*_world);
+    }
+    if (_snapshotBuffer) {
+        _snapshotBuffer->setLive(true);
+        _snapshotBuffer->publish(*_world);
+    }
+
+    for (size_t step=0; step<_stepCount; ++step) {
+        if (_stepTorques.size() != 0) {
+            int offset = 0;
+            for (int i=0; i<_world->getNumSkeletons(); ++i) {
+                dart::dynamics::Skeleton* skel = _world->getSkeleton(i);
+                int n = skel->getNumGenCoords();
+                skel->setInternalForceVector(_stepTorques.segment(offset, n));
+                offset += n;
+            }
+        }
+        stepWorld();
+    }
+
+    if (_timelineFile) {
+        _timelineFile->flush();
+    }
+    if (_snapshotBuffer) {
+        _snapshotBuffer->setLive(false);
+    }
+
+    _stepState = (_stepCount > 0 ? _state : _world->getState());
+    return true;
+}
+
 void GripSimulation::stopSimulation()
 {
     if (_debug) {
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Local includes
+#include "GripStateApplier.h"
+
+// DART includes
+#include <dart/dynamics/Skeleton.h>
+
+GripStateApplier::GripStateApplier(dart::simulation::World* world)
+    : _world(world),
+      _numSkipped(0)
+{
+}
+
+void GripStateApplier::setWorld(dart::simulation::World* world)
+{
+    _world = world;
+    _skeletons.clear();
+}
+
+void GripStateApplier::apply(const Eigen::Map<const Eigen::VectorXd>& state)
+{
+    if (!_world) {
+        return;
+    }
+    if (!_layoutIsValid()) {
+        _layout();
+    }
+
+    _numSkipped = 0;
+    for (size_t i = 0; i < _skeletons.size(); ++i) {
+        int n = _q[i].size();
+        if (_starts[i] + 2 * n > state.size()) {
+            continue;
+        }
+
+        if (_applied[i] && _q[i] == state.segment(_starts[i], n)
+                && _dq[i] == state.segment(_starts[i] + n, n)) {
+            ++_numSkipped;
+            continue;
+        }
+
+        // Same sizes as before, so these copy without allocating
+        _q[i] = state.segment(_starts[i], n);
+        _dq[i] = state.segment(_starts[i] + n, n);
+
+        // setConfig does the one forward kinematics pass, and unlike setState
+        // it sets up the FreeJoint transforms properly (DART issue 122)
+        _skeletons[i]->set_dq(_dq[i]);
+        _skeletons[i]->setConfig(_q[i]);
+        _applied[i] = true;
+    }
+}
+
+void GripStateApplier::apply(const Eigen::VectorXd& state)
+{
+    apply(Eigen::Map<const Eigen::VectorXd>(state.data(), state.size()));
+}
+
+void GripStateApplier::invalidate()
+{
+    _applied.assign(_applied.size(), false);
+}
+
+int GripStateApplier::getNumSkipped() const
+{
+    return _numSkipped;
+}
+
+void GripStateApplier::_layout()
+{
+    int numSkeletons = _world->getNumSkeletons();
+    _skeletons.resize(numSkeletons);
+    _starts.resize(numSkeletons);
+    _q.resize(numSkeletons);
+    _dq.resize(numSkeletons);
+    _applied.assign(numSkeletons, false);
+
+    for (int i = 0; i < numSkeletons; ++i) {
+        _skeletons[i] = _world->getSkeleton(i);
+        _starts[i] = 2 * _world->getIndex(i);
+        _q[i].resize(_skeletons[i]->getNumGenCoords());
+        _dq[i].resize(_skeletons[i]->getNumGenCoords());
+    }
+}
+
+bool GripStateApplier::_layoutIsValid() const
+{
+    if ((int)_skeletons.size() != _world->getNumSkeletons()) {
+        return false;
+    }
+    for (size_t i = 0; i < _skeletons.size(); ++i) {
+        if (_skeletons[i] != _world->getSkeleton(i)
+                || (int)_q[i].size() != _skeletons[i]->getNumGenCoords()) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,925 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GripTimeline.h"
+#include <stdexcept>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <unistd.h>
+
+static const size_t NO_INDEX = std::numeric_limits<size_t>::max();
+
+/**
+ * \brief Bit pattern of a double, for XOR deltas
+ */
+static inline uint64_t doubleToBits(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * \brief Double from its bit pattern
+ */
+static inline double bitsToDouble(uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * \brief Number of low order bytes needed to hold x
+ */
+static inline unsigned int significantBytes(uint64_t x)
+{
+    unsigned int n = 0;
+    while (x) {
+        x >>= 8;
+        ++n;
+    }
+    return n;
+}
+
+/**
+ * \brief Appends a signed integer as a zigzag varint (small magnitudes take one byte)
+ */
+static inline void appendVarint(std::vector<unsigned char>& out, int64_t value)
+{
+    uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    while (zigzag >= 0x80) {
+        out.push_back((unsigned char)(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    out.push_back((unsigned char)zigzag);
+}
+
+/**
+ * \brief Reads a zigzag varint starting at offset and advances offset past it
+ */
+static inline int64_t readVarint(const unsigned char* data, size_t& offset)
+{
+    uint64_t zigzag = 0;
+    unsigned int shift = 0;
+    unsigned char byte;
+    do {
+        byte = data[offset++];
+        zigzag |= (uint64_t)(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+}
+
+/**
+ * \brief Nearest integer multiple of the resolution. Converting NaN or a value out
+ * of range to an integer is undefined, so NaN becomes zero and the rest is clamped
+ * to +-2^61, which keeps the deltas between two clamped values in range too
+ */
+static inline int64_t quantize(double value, double resolution, bool& clamped)
+{
+    static const double limit = 2305843009213693952.0;
+    double q = std::floor(value / resolution + 0.5);
+    if (q != q) {
+        clamped = true;
+        return 0;
+    }
+    if (q > limit || q < -limit) {
+        clamped = true;
+        q = (q > 0 ? limit : -limit);
+    }
+    return (int64_t)q;
+}
+
+/**
+ * \brief Appends one state to a compressed block as a delta against prev (all
+ * zeros for a keyframe) and updates prev to the encoded state
+ * \return False if some values couldn't be quantized and were clamped
+ */
+static bool encodeRow(std::vector<unsigned char>& out, const double* state, size_t n,
+                      timelineCompression_t compression, double resolution,
+                      std::vector<uint64_t>& prev)
+{
+    bool clamped = false;
+    if (compression == TIMELINE_LOSSLESS) {
+        // One nibble per value with the number of significant bytes in its XOR
+        // with the previous value, then those bytes. Unchanged values cost half a byte
+        size_t headerStart = out.size();
+        out.resize(headerStart + (n + 1) / 2, 0);
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t bits = doubleToBits(state[i]);
+            uint64_t x = bits ^ prev[i];
+            unsigned int numBytes = significantBytes(x);
+            out[headerStart + i / 2] |= (unsigned char)(numBytes << (4 * (i % 2)));
+            for (unsigned int b = 0; b < numBytes; ++b) {
+                out.push_back((unsigned char)(x >> (8 * b)));
+            }
+            prev[i] = bits;
+        }
+    } else {
+        // Integer multiples of the resolution, stored as varint deltas. The deltas
+        // are exact, so the error doesn't accumulate between keyframes
+        for (size_t i = 0; i < n; ++i) {
+            int64_t q = quantize(state[i], resolution, clamped);
+            appendVarint(out, q - (int64_t)prev[i]);
+            prev[i] = (uint64_t)q;
+        }
+    }
+    return !clamped;
+}
+
+/**
+ * \brief Applies one encoded row starting at offset to prev and advances offset past it
+ */
+static void decodeRow(const unsigned char* data, size_t& offset, size_t n,
+                      timelineCompression_t compression, std::vector<uint64_t>& prev)
+{
+    if (compression == TIMELINE_LOSSLESS) {
+        size_t headerStart = offset;
+        offset += (n + 1) / 2;
+        for (size_t i = 0; i < n; ++i) {
+            unsigned int numBytes = (data[headerStart + i / 2] >> (4 * (i % 2))) & 0xf;
+            uint64_t x = 0;
+            for (unsigned int b = 0; b < numBytes; ++b) {
+                x |= (uint64_t)data[offset++] << (8 * b);
+            }
+            prev[i] ^= x;
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            prev[i] += (uint64_t)readVarint(data, offset);
+        }
+    }
+}
+
+/**
+ * \brief Converts an encoded state back to doubles
+ */
+static void encodedToState(const std::vector<uint64_t>& encoded, timelineCompression_t compression,
+                           double resolution, double* state)
+{
+    for (size_t i = 0; i < encoded.size(); ++i) {
+        state[i] = (compression == TIMELINE_LOSSLESS ? bitsToDouble(encoded[i])
+                                                     : (int64_t)encoded[i] * resolution);
+    }
+}
+
+GripTimesliceView::GripTimesliceView(double time, const double* state, size_t stateSize)
+    : _time(time), _state(state), _stateSize(stateSize)
+{
+}
+
+double GripTimesliceView::getTime() const
+{
+    return _time;
+}
+
+Eigen::Map<const Eigen::VectorXd> GripTimesliceView::getState() const
+{
+    return Eigen::Map<const Eigen::VectorXd>(_decoded.size() ? _decoded.data() : _state, _stateSize);
+}
+
+GripTimeline::GripTimeline(size_t chunkSize)
+    : _chunkSize(chunkSize > 0 ? chunkSize : 1), _stateSize(0), _size(0),
+      _firstIndex(0), _memFirstChunk(0),
+      _retention(0), _spillToDisk(false), _deferEviction(false), _spillFile(NULL), _spilledBytes(0),
+      _spillBufferChunk(NO_INDEX),
+      _compression(TIMELINE_RAW), _keyframeInterval(64), _resolution(1e-6),
+      _clampWarned(false), _file(NULL), _decodedIndex(NO_INDEX), _decodeOffset(0)
+{
+}
+
+GripTimeline::~GripTimeline()
+{
+    _clear();
+}
+
+void GripTimeline::setCompression(timelineCompression_t compression, size_t keyframeInterval,
+                                  double resolution)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _clear();
+
+    if (compression == TIMELINE_QUANTIZED && !(resolution > 0)) {
+        std::cerr << "[GripTimeline] Quantization resolution must be positive, not " << resolution
+                  << ". Using lossless compression instead" << std::endl;
+        compression = TIMELINE_LOSSLESS;
+    }
+
+    _compression = compression;
+    _keyframeInterval = (keyframeInterval > 0 ? keyframeInterval : 1);
+    if (resolution > 0) {
+        _resolution = resolution;
+    }
+
+    // Chunks hold a whole number of blocks so they can be evicted block by block
+    if (_compression != TIMELINE_RAW && _chunkSize % _keyframeInterval) {
+        _chunkSize += _keyframeInterval - _chunkSize % _keyframeInterval;
+    }
+}
+
+timelineCompression_t GripTimeline::getCompression() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _compression;
+}
+
+void GripTimeline::setRetention(double seconds, bool spillToDisk)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _clear();
+    _retention = seconds;
+    _spillToDisk = spillToDisk;
+}
+
+double GripTimeline::getRetention() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _retention;
+}
+
+void GripTimeline::setDeferredEviction(bool deferred)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _deferEviction = deferred;
+}
+
+void GripTimeline::evict()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_retention > 0 && !_timeChunks.empty()) {
+        _evict();
+    }
+}
+
+void GripTimeline::push_back(const dart::simulation::World& world)
+{
+    push_back(world.getTime(), world.getState());
+}
+
+void GripTimeline::push_back(const GripTimeslice& timeslice)
+{
+    push_back(timeslice.getTime(), timeslice.getState());
+}
+
+void GripTimeline::push_back(double time, const Eigen::VectorXd& state)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _push(time, state);
+}
+
+void GripTimeline::_push(double time, const Eigen::VectorXd& state)
+{
+    if (_file) {
+        _detachFile(_size);
+    }
+
+    if (_size == _firstIndex) {
+        _stateSize = state.size();
+    } else if ((size_t)state.size() != _stateSize) {
+        std::cerr << "[GripTimeline] State of size " << state.size()
+                  << " doesn't match the timeline's state size of " << _stateSize
+                  << ". Not adding it. Line " << __LINE__ << " of " << __FILE__ << std::endl;
+        return;
+    }
+
+    _reserveRow();
+
+    size_t row = _size % _chunkSize;
+    _timeChunks.back()[row] = time;
+    if (_compression == TIMELINE_RAW) {
+        if (_stateSize > 0) {
+            Eigen::Map<Eigen::VectorXd>(&_stateChunks.back()[row * _stateSize], _stateSize) = state;
+        }
+    } else {
+        _encode(state);
+    }
+    ++_size;
+
+    if (_retention > 0 && !_deferEviction) {
+        _evict();
+    }
+}
+
+GripTimesliceView GripTimeline::at(size_t index) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _checkIndex(index, "GripTimeline::at index out of range");
+    return _view(index);
+}
+
+double GripTimeline::at(size_t index, Eigen::VectorXd& state) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _checkIndex(index, "GripTimeline::at index out of range");
+    if ((size_t)state.size() != _stateSize) {
+        state.resize(_stateSize);
+    }
+    return _read(index, state.data());
+}
+
+void GripTimeline::_checkIndex(size_t index, const char* what) const
+{
+    if (index >= _size || index < _firstIndex) {
+        throw std::out_of_range(what);
+    }
+}
+
+GripTimesliceView GripTimeline::_view(size_t index) const
+{
+    if (_file) {
+        return _file->at(index);
+    }
+
+    // Raw states in memory are mapped, everything else is decoded into the view
+    if (_compression == TIMELINE_RAW && index / _chunkSize >= _memFirstChunk) {
+        size_t chunk = index / _chunkSize - _memFirstChunk;
+        size_t row = index % _chunkSize;
+        return GripTimesliceView(_timeChunks[chunk][row],
+                                 _stateChunks[chunk].data() + row * _stateSize,
+                                 _stateSize);
+    }
+
+    GripTimesliceView view(0, NULL, _stateSize);
+    view._decoded.resize(_stateSize);
+    view._time = _read(index, view._decoded.data());
+    return view;
+}
+
+double GripTimeline::_read(size_t index, double* state) const
+{
+    if (_file) {
+        GripTimesliceView slice = _file->at(index);
+        std::memcpy(state, slice.getState().data(), _stateSize * sizeof(double));
+        return slice.getTime();
+    }
+
+    timelineCompression_t compression = (_compression == TIMELINE_RAW ? TIMELINE_LOSSLESS : _compression);
+    if (index / _chunkSize < _memFirstChunk) {
+        double time = _decodeSpilled(index);
+        encodedToState(_decodePrev, compression, _resolution, state);
+        return time;
+    }
+
+    size_t chunk = index / _chunkSize - _memFirstChunk;
+    size_t row = index % _chunkSize;
+    if (_compression == TIMELINE_RAW) {
+        std::memcpy(state, _stateChunks[chunk].data() + row * _stateSize, _stateSize * sizeof(double));
+    } else {
+        _decode(index);
+        encodedToState(_decodePrev, _compression, _resolution, state);
+    }
+    return _timeChunks[chunk][row];
+}
+
+double GripTimeline::getTime(size_t index) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _checkIndex(index, "GripTimeline::getTime index out of range");
+    return _getTime(index);
+}
+
+double GripTimeline::_getTime(size_t index) const
+{
+    // Times of slices in memory are stored raw even when states are compressed
+    if (_file) {
+        return _file->at(index).getTime();
+    }
+    if (index / _chunkSize < _memFirstChunk) {
+        return _decodeSpilled(index);
+    }
+    return _timeChunks[index / _chunkSize - _memFirstChunk][index % _chunkSize];
+}
+
+void GripTimeline::copyTo(size_t first, size_t count, double* times, double* states) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (first < _firstIndex || first + count > _size) {
+        throw std::out_of_range("GripTimeline::copyTo range out of range");
+    }
+
+    size_t index = first;
+    size_t end = first + count;
+    while (index < end) {
+        size_t chunkNum = index / _chunkSize;
+        size_t row = index % _chunkSize;
+
+        // Raw chunks in memory are already rows of states, so take the rest of the chunk at once
+        if (!_file && _compression == TIMELINE_RAW && chunkNum >= _memFirstChunk) {
+            size_t chunk = chunkNum - _memFirstChunk;
+            size_t numRows = std::min(_chunkSize - row, end - index);
+            std::memcpy(times, &_timeChunks[chunk][row], numRows * sizeof(double));
+            std::memcpy(states, _stateChunks[chunk].data() + row * _stateSize,
+                        numRows * _stateSize * sizeof(double));
+            times += numRows;
+            states += numRows * _stateSize;
+            index += numRows;
+            continue;
+        }
+
+        *times++ = _read(index, states);
+        states += _stateSize;
+        ++index;
+    }
+}
+
+size_t GripTimeline::findIndex(double time) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_size == _firstIndex) {
+        throw std::out_of_range("GripTimeline::findIndex on an empty timeline");
+    }
+
+    // Times only increase, so keep the answer in [lo, hi)
+    size_t lo = _firstIndex;
+    size_t hi = _size;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (_getTime(mid) <= time) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+GripTimesliceView GripTimeline::front() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _checkIndex(_firstIndex, "GripTimeline::front on an empty timeline");
+    return _view(_firstIndex);
+}
+
+GripTimesliceView GripTimeline::back() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _checkIndex(_size - 1, "GripTimeline::back on an empty timeline");
+    return _view(_size - 1);
+}
+
+size_t GripTimeline::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _size;
+}
+
+size_t GripTimeline::getFirstIndex() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _firstIndex;
+}
+
+bool GripTimeline::empty() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _size == _firstIndex;
+}
+
+void GripTimeline::truncate(size_t newSize)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (newSize >= _size) {
+        return;
+    }
+
+    if (_file) {
+        _detachFile(newSize);
+        return;
+    }
+
+    if (newSize <= _firstIndex) {
+        _clear();
+        return;
+    }
+
+    if ((newSize - 1) / _chunkSize < _memFirstChunk) {
+        _unspill(newSize);
+        return;
+    }
+
+    if (_compression != TIMELINE_RAW) {
+        size_t firstBlock = _memFirstChunk * (_chunkSize / _keyframeInterval);
+        if (newSize % _keyframeInterval) {
+            // Cut the last block just past the new last slice and continue encoding from it
+            _decode(newSize - 1);
+            _blocks.resize((newSize + _keyframeInterval - 1) / _keyframeInterval - firstBlock);
+            _blocks.back().resize(_decodeOffset);
+            _encodePrev = _decodePrev;
+        } else {
+            _blocks.resize(newSize / _keyframeInterval - firstBlock);
+        }
+    }
+    if (_decodedIndex != NO_INDEX && _decodedIndex >= newSize) {
+        _decodedIndex = NO_INDEX;
+    }
+
+    _size = newSize;
+    size_t numChunks = (_size + _chunkSize - 1) / _chunkSize - _memFirstChunk;
+    _timeChunks.resize(numChunks);
+    _stateChunks.resize(numChunks);
+}
+
+void GripTimeline::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _clear();
+}
+
+void GripTimeline::_clear()
+{
+    delete _file;
+    _file = NULL;
+    _timeChunks.clear();
+    _stateChunks.clear();
+    _spareTimeChunk.clear();
+    _spareStateChunk.clear();
+    _blocks.clear();
+    _encodePrev.clear();
+    _decodedIndex = NO_INDEX;
+    _clampWarned = false;
+    _size = 0;
+    _firstIndex = 0;
+    _memFirstChunk = 0;
+    _stateSize = 0;
+
+    if (_spillFile) {
+        fclose(_spillFile);
+        _spillFile = NULL;
+    }
+    _spilledBytes = 0;
+    _spillOffsets.clear();
+    _spillKeyframes.clear();
+    _spillBuffer.clear();
+    _spillBufferChunk = NO_INDEX;
+}
+
+size_t GripTimeline::getStateSize() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stateSize;
+}
+
+size_t GripTimeline::getChunkSize() const
+{
+    return _chunkSize;
+}
+
+size_t GripTimeline::getMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t bytes = (_timeChunks.size() * _chunkSize + _spareTimeChunk.capacity()) * sizeof(double);
+    for (size_t i = 0; i < _stateChunks.size(); ++i) {
+        bytes += _stateChunks[i].capacity() * sizeof(double);
+    }
+    bytes += _spareStateChunk.capacity() * sizeof(double);
+    for (size_t i = 0; i < _blocks.size(); ++i) {
+        bytes += _blocks[i].capacity();
+    }
+    return bytes;
+}
+
+size_t GripTimeline::getRawMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (_size - _firstIndex) * (_stateSize + 1) * sizeof(double);
+}
+
+size_t GripTimeline::getSpilledBytes() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _spilledBytes;
+}
+
+bool GripTimeline::save(const std::string& fileName, const dart::simulation::World& world) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Overwriting the file we're reading from would pull it out from under the map
+    if (_file && _file->getFileName() == fileName) {
+        std::cerr << "[GripTimeline] Timeline is already saved in " << fileName << std::endl;
+        return true;
+    }
+
+    GripTimelineFile file;
+    if (!file.create(fileName, world)) {
+        return false;
+    }
+
+    if (_size != _firstIndex && file.getStateSize() != _stateSize) {
+        std::cerr << "[GripTimeline] World state size " << file.getStateSize()
+                  << " doesn't match the timeline's state size of " << _stateSize << std::endl;
+        return false;
+    }
+
+    std::vector<double> state(_stateSize);
+    for (size_t i = _firstIndex; i < _size; ++i) {
+        double time = _read(i, state.data());
+        if (!file.append(time, state.data())) {
+            return false;
+        }
+    }
+    file.close();
+    return true;
+}
+
+bool GripTimeline::load(const std::string& fileName, const dart::simulation::World& world)
+{
+    GripTimelineFile* file = new GripTimelineFile();
+    if (!file->open(fileName)) {
+        delete file;
+        return false;
+    }
+
+    if (!file->matchesWorld(world)) {
+        std::cerr << "[GripTimeline] The skeletons in " << fileName
+                  << " don't match the ones in the world. Not loading it" << std::endl;
+        delete file;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _clear();
+    _file = file;
+    _size = file->size();
+    _stateSize = file->getStateSize();
+    return true;
+}
+
+void GripTimeline::_detachFile(size_t numSlices)
+{
+    GripTimelineFile* file = _file;
+    _file = NULL;
+    _size = 0;
+
+    for (size_t i = 0; i < numSlices && i < file->size(); ++i) {
+        GripTimesliceView slice = file->at(i);
+        _push(slice.getTime(), slice.getState());
+    }
+    delete file;
+}
+
+void GripTimeline::_reserveRow()
+{
+    if (_size < (_memFirstChunk + _timeChunks.size()) * _chunkSize) {
+        return;
+    }
+
+    // Chunks are created at their full size and never resized afterwards, so
+    // existing slices never move. Growing the deques only moves the chunk
+    // handles, not the data. Evicted chunks are reused rather than freed
+    _timeChunks.push_back(std::vector<double>());
+    if (_spareTimeChunk.size() == _chunkSize) {
+        _timeChunks.back().swap(_spareTimeChunk);
+    } else {
+        _timeChunks.back().resize(_chunkSize);
+    }
+
+    _stateChunks.push_back(std::vector<double>());
+    if (_compression == TIMELINE_RAW) {
+        if (_spareStateChunk.size() == _chunkSize * _stateSize) {
+            _stateChunks.back().swap(_spareStateChunk);
+        } else {
+            _stateChunks.back().resize(_chunkSize * _stateSize);
+        }
+    }
+}
+
+void GripTimeline::_evict()
+{
+    double newest = _timeChunks.back()[(_size - 1) % _chunkSize];
+
+    // Every chunk but the last one is full, so its last slice is its newest
+    while (_timeChunks.size() > 1 && _timeChunks.front()[_chunkSize - 1] < newest - _retention) {
+        if (_spillToDisk) {
+            _spillChunk();
+        }
+
+        _spareTimeChunk.swap(_timeChunks.front());
+        _timeChunks.pop_front();
+        _spareStateChunk.swap(_stateChunks.front());
+        _stateChunks.pop_front();
+        if (_compression != TIMELINE_RAW) {
+            for (size_t i = 0; i < _chunkSize / _keyframeInterval; ++i) {
+                _blocks.pop_front();
+            }
+        }
+
+        ++_memFirstChunk;
+        if (!_spillToDisk) {
+            _firstIndex = _memFirstChunk * _chunkSize;
+        }
+        _decodedIndex = NO_INDEX;
+    }
+}
+
+void GripTimeline::_spillChunk()
+{
+    if (!_spillFile) {
+        _spillFile = tmpfile();
+        if (!_spillFile) {
+            std::cerr << "[GripTimeline] Unable to create spill file: " << strerror(errno)
+                      << ". Dropping old slices instead" << std::endl;
+            _spillToDisk = false;
+            _firstIndex = _memFirstChunk * _chunkSize;
+            return;
+        }
+    }
+
+    // Raw timelines are spilled losslessly, compressed ones with their own compression
+    timelineCompression_t compression = (_compression == TIMELINE_RAW ? TIMELINE_LOSSLESS : _compression);
+
+    // Segment layout: the chunk's times, then its states with a keyframe every
+    // _keyframeInterval rows
+    std::vector<unsigned char> segment(_chunkSize * sizeof(double));
+    std::memcpy(&segment[0], _timeChunks.front().data(), segment.size());
+    std::vector<uint32_t> keyframes;
+    std::vector<uint64_t> prev;
+    std::vector<double> state(_stateSize);
+    size_t start = _memFirstChunk * _chunkSize;
+    for (size_t row = 0; row < _chunkSize; ++row) {
+        if (row % _keyframeInterval == 0) {
+            keyframes.push_back(segment.size());
+            prev.assign(_stateSize, 0);
+        }
+        _read(start + row, state.data());
+        encodeRow(segment, state.data(), _stateSize, compression, _resolution, prev);
+    }
+
+    if (pwrite(fileno(_spillFile), &segment[0], segment.size(), _spilledBytes) != (ssize_t)segment.size()) {
+        std::cerr << "[GripTimeline] Unable to write to spill file: " << strerror(errno)
+                  << ". Dropping old slices instead" << std::endl;
+        _spillToDisk = false;
+        _firstIndex = _memFirstChunk * _chunkSize;
+        return;
+    }
+
+    _spillOffsets.push_back(_spilledBytes);
+    _spillKeyframes.push_back(keyframes);
+    _spilledBytes += segment.size();
+}
+
+double GripTimeline::_decodeSpilled(size_t index) const
+{
+    size_t chunk = index / _chunkSize;
+    size_t row = index % _chunkSize;
+    timelineCompression_t compression = (_compression == TIMELINE_RAW ? TIMELINE_LOSSLESS : _compression);
+
+    if (_spillBufferChunk != chunk) {
+        size_t end = (chunk + 1 < _spillOffsets.size() ? _spillOffsets[chunk + 1] : _spilledBytes);
+        _spillBuffer.resize(end - _spillOffsets[chunk]);
+        if (pread(fileno(_spillFile), &_spillBuffer[0], _spillBuffer.size(), _spillOffsets[chunk])
+                != (ssize_t)_spillBuffer.size()) {
+            std::cerr << "[GripTimeline] Unable to read from spill file: " << strerror(errno) << std::endl;
+        }
+        _spillBufferChunk = chunk;
+        _decodedIndex = NO_INDEX;
+    }
+
+    double time;
+    std::memcpy(&time, &_spillBuffer[row * sizeof(double)], sizeof(double));
+
+    if (index != _decodedIndex) {
+        size_t keyframe = row / _keyframeInterval;
+        size_t startRow;
+        if (_decodedIndex != NO_INDEX && _decodedIndex < index
+                && _decodedIndex / _chunkSize == chunk
+                && (_decodedIndex % _chunkSize) / _keyframeInterval == keyframe) {
+            startRow = _decodedIndex % _chunkSize + 1;
+        } else {
+            startRow = keyframe * _keyframeInterval;
+            _decodeOffset = _spillKeyframes[chunk][keyframe];
+            _decodePrev.assign(_stateSize, 0);
+        }
+        for (size_t r = startRow; r <= row; ++r) {
+            decodeRow(&_spillBuffer[0], _decodeOffset, _stateSize, compression, _decodePrev);
+        }
+        _decodedIndex = index;
+    }
+
+    return time;
+}
+
+void GripTimeline::_unspill(size_t newSize)
+{
+    // Read the slices of the new last chunk back before the spill file is cut
+    size_t chunk = (newSize - 1) / _chunkSize;
+    std::vector<double> times;
+    std::vector<Eigen::VectorXd> states;
+    for (size_t i = chunk * _chunkSize; i < newSize; ++i) {
+        states.push_back(Eigen::VectorXd(_stateSize));
+        times.push_back(_read(i, states.back().data()));
+    }
+
+    _timeChunks.clear();
+    _stateChunks.clear();
+    _blocks.clear();
+    _spilledBytes = _spillOffsets[chunk];
+    _spillOffsets.resize(chunk);
+    _spillKeyframes.resize(chunk);
+    if (ftruncate(fileno(_spillFile), _spilledBytes) != 0) {
+        std::cerr << "[GripTimeline] Unable to shrink spill file: " << strerror(errno) << std::endl;
+    }
+    _spillBufferChunk = NO_INDEX;
+    _decodedIndex = NO_INDEX;
+
+    _memFirstChunk = chunk;
+    _size = chunk * _chunkSize;
+    for (size_t i = 0; i < times.size(); ++i) {
+        _push(times[i], states[i]);
+    }
+}
+
+void GripTimeline::_encode(const Eigen::VectorXd& state)
+{
+    // Keyframes are encoded as deltas against an all zero state
+    if (_size % _keyframeInterval == 0) {
+        if (!_blocks.empty()) {
+            // Trim the finished block's spare capacity
+            std::vector<unsigned char>(_blocks.back()).swap(_blocks.back());
+        }
+        _blocks.push_back(std::vector<unsigned char>());
+        _encodePrev.assign(_stateSize, 0);
+    }
+    std::vector<unsigned char>& block = _blocks.back();
+    if (!encodeRow(block, state.data(), _stateSize, _compression, _resolution, _encodePrev)
+            && !_clampWarned) {
+        std::cerr << "[GripTimeline] State at slice " << _size << " has values that can't be quantized"
+                  << " (NaN, infinite or too large for the resolution). Storing them clamped" << std::endl;
+        _clampWarned = true;
+    }
+
+    // The slice just pushed is the most likely one to be read next (e.g. back())
+    _decodePrev = _encodePrev;
+    _decodedIndex = _size;
+    _decodeOffset = block.size();
+}
+
+void GripTimeline::_decode(size_t index) const
+{
+    if (index == _decodedIndex) {
+        return;
+    }
+
+    size_t block = index / _keyframeInterval;
+    size_t start;
+    if (_decodedIndex != NO_INDEX && _decodedIndex < index
+            && _decodedIndex / _keyframeInterval == block) {
+        start = _decodedIndex + 1;
+    } else {
+        start = block * _keyframeInterval;
+        _decodePrev.assign(_stateSize, 0);
+        _decodeOffset = 0;
+    }
+
+    const unsigned char* data = _blocks[block - _memFirstChunk * (_chunkSize / _keyframeInterval)].data();
+    for (size_t n = start; n <= index; ++n) {
+        decodeRow(data, _decodeOffset, _stateSize, _compression, _decodePrev);
+    }
+    _decodedIndex = index;
+}
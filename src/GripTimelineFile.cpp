@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GripTimelineFile.h"
+#include "GripTimeline.h"
+
+// DART includes
+#include <dart/dynamics/Skeleton.h>
+
+// System includes for memory mapping
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+static const char TIMELINE_FILE_MAGIC[8] = {'G', 'R', 'I', 'P', 'T', 'M', 'L', '1'};
+static const uint32_t TIMELINE_FILE_VERSION = 1;
+
+GripTimelineFile::GripTimelineFile()
+    : _writeFile(NULL), _readFd(-1), _map(NULL), _mapSize(0), _headerSize(0),
+      _numRecords(0), _stateSize(0)
+{
+}
+
+GripTimelineFile::~GripTimelineFile()
+{
+    close();
+}
+
+void GripTimelineFile::_setLayout(const dart::simulation::World& world)
+{
+    _stateSize = world.getState().size();
+    _skeletonNames.clear();
+    _skeletonIndices.clear();
+    _skeletonNumGenCoords.clear();
+    for (int i = 0; i < world.getNumSkeletons(); ++i) {
+        _skeletonNames.push_back(world.getSkeleton(i)->getName());
+        _skeletonIndices.push_back(world.getIndex(i));
+        _skeletonNumGenCoords.push_back(world.getSkeleton(i)->getNumGenCoords());
+    }
+}
+
+bool GripTimelineFile::create(const std::string& fileName, const dart::simulation::World& world)
+{
+    close();
+
+    _writeFile = fopen(fileName.c_str(), "wb");
+    if (!_writeFile) {
+        std::cerr << "[GripTimelineFile] Unable to create " << fileName << ": "
+                  << strerror(errno) << std::endl;
+        return false;
+    }
+    // Large buffer so appending a record per time step is just a memcpy most of the time
+    setvbuf(_writeFile, NULL, _IOFBF, 1 << 20);
+
+    _fileName = fileName;
+    _setLayout(world);
+
+    // Build the header in memory, then write it in one go
+    std::vector<unsigned char> header(32, 0);
+    uint32_t numSkeletons = _skeletonNames.size();
+    std::memcpy(&header[0], TIMELINE_FILE_MAGIC, 8);
+    std::memcpy(&header[8], &TIMELINE_FILE_VERSION, 4);
+    std::memcpy(&header[12], &_stateSize, 4);
+    std::memcpy(&header[24], &numSkeletons, 4);
+    for (size_t i = 0; i < _skeletonNames.size(); ++i) {
+        uint32_t nameLength = _skeletonNames[i].size();
+        size_t offset = header.size();
+        header.resize(offset + 12 + nameLength);
+        std::memcpy(&header[offset], &nameLength, 4);
+        std::memcpy(&header[offset + 4], _skeletonNames[i].data(), nameLength);
+        std::memcpy(&header[offset + 4 + nameLength], &_skeletonIndices[i], 4);
+        std::memcpy(&header[offset + 8 + nameLength], &_skeletonNumGenCoords[i], 4);
+    }
+    // Pad so the records are aligned for reading doubles straight out of the map
+    header.resize((header.size() + 7) / 8 * 8, 0);
+    _headerSize = header.size();
+    std::memcpy(&header[16], &_headerSize, 8);
+
+    if (fwrite(&header[0], 1, header.size(), _writeFile) != header.size()) {
+        std::cerr << "[GripTimelineFile] Unable to write header of " << fileName << std::endl;
+        close();
+        return false;
+    }
+
+    _numRecords = 0;
+    return true;
+}
+
+bool GripTimelineFile::append(double time, const double* state)
+{
+    if (!_writeFile) {
+        std::cerr << "[GripTimelineFile] No file open for writing" << std::endl;
+        return false;
+    }
+
+    if (fwrite(&time, sizeof(double), 1, _writeFile) != 1
+            || fwrite(state, sizeof(double), _stateSize, _writeFile) != _stateSize) {
+        std::cerr << "[GripTimelineFile] Unable to append to " << _fileName << ": "
+                  << strerror(errno) << std::endl;
+        return false;
+    }
+
+    ++_numRecords;
+    return true;
+}
+
+void GripTimelineFile::flush()
+{
+    if (_writeFile) {
+        fflush(_writeFile);
+    }
+}
+
+bool GripTimelineFile::truncate(size_t numRecords)
+{
+    if (!_writeFile) {
+        std::cerr << "[GripTimelineFile] No file open for writing" << std::endl;
+        return false;
+    }
+    if (numRecords >= _numRecords) {
+        return true;
+    }
+
+    off_t size = _headerSize + numRecords * (_stateSize + 1) * sizeof(double);
+    if (fflush(_writeFile) != 0 || ftruncate(fileno(_writeFile), size) != 0
+            || fseeko(_writeFile, size, SEEK_SET) != 0) {
+        std::cerr << "[GripTimelineFile] Unable to truncate " << _fileName << ": "
+                  << strerror(errno) << std::endl;
+        return false;
+    }
+
+    _numRecords = numRecords;
+    return true;
+}
+
+bool GripTimelineFile::open(const std::string& fileName)
+{
+    close();
+
+    _readFd = ::open(fileName.c_str(), O_RDONLY);
+    if (_readFd < 0) {
+        std::cerr << "[GripTimelineFile] Unable to open " << fileName << ": "
+                  << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(_readFd, &fileStat) != 0 || fileStat.st_size < 32) {
+        std::cerr << "[GripTimelineFile] " << fileName << " is too small to be a timeline file" << std::endl;
+        close();
+        return false;
+    }
+
+    _mapSize = fileStat.st_size;
+    void* map = mmap(NULL, _mapSize, PROT_READ, MAP_SHARED, _readFd, 0);
+    if (map == MAP_FAILED) {
+        std::cerr << "[GripTimelineFile] Unable to map " << fileName << ": "
+                  << strerror(errno) << std::endl;
+        _mapSize = 0;
+        close();
+        return false;
+    }
+    _map = (const unsigned char*)map;
+    _fileName = fileName;
+
+    // Playback mostly walks the records in order
+    madvise(map, _mapSize, MADV_SEQUENTIAL);
+
+    uint32_t version, numSkeletons;
+    std::memcpy(&version, _map + 8, 4);
+    std::memcpy(&_stateSize, _map + 12, 4);
+    std::memcpy(&_headerSize, _map + 16, 8);
+    std::memcpy(&numSkeletons, _map + 24, 4);
+    if (std::memcmp(_map, TIMELINE_FILE_MAGIC, 8) != 0 || version != TIMELINE_FILE_VERSION
+            || _headerSize > _mapSize || _headerSize % 8) {
+        std::cerr << "[GripTimelineFile] " << fileName << " is not a valid timeline file" << std::endl;
+        close();
+        return false;
+    }
+
+    _skeletonNames.clear();
+    _skeletonIndices.clear();
+    _skeletonNumGenCoords.clear();
+    size_t offset = 32;
+    for (uint32_t i = 0; i < numSkeletons; ++i) {
+        uint32_t nameLength, index, numGenCoords;
+        if (offset + 4 > _headerSize) break;
+        std::memcpy(&nameLength, _map + offset, 4);
+        if (offset + 12 + nameLength > _headerSize) break;
+        _skeletonNames.push_back(std::string((const char*)_map + offset + 4, nameLength));
+        std::memcpy(&index, _map + offset + 4 + nameLength, 4);
+        std::memcpy(&numGenCoords, _map + offset + 8 + nameLength, 4);
+        _skeletonIndices.push_back(index);
+        _skeletonNumGenCoords.push_back(numGenCoords);
+        offset += 12 + nameLength;
+    }
+    if (_skeletonNames.size() != numSkeletons) {
+        std::cerr << "[GripTimelineFile] Corrupt skeleton table in " << fileName << std::endl;
+        close();
+        return false;
+    }
+
+    _numRecords = (_mapSize - _headerSize) / ((_stateSize + 1) * sizeof(double));
+    return true;
+}
+
+void GripTimelineFile::close()
+{
+    if (_writeFile) {
+        fclose(_writeFile);
+        _writeFile = NULL;
+    }
+    if (_map) {
+        munmap((void*)_map, _mapSize);
+        _map = NULL;
+        _mapSize = 0;
+    }
+    if (_readFd >= 0) {
+        ::close(_readFd);
+        _readFd = -1;
+    }
+    _numRecords = 0;
+}
+
+bool GripTimelineFile::isOpen() const
+{
+    return _writeFile || _map;
+}
+
+size_t GripTimelineFile::size() const
+{
+    return _numRecords;
+}
+
+GripTimesliceView GripTimelineFile::at(size_t index) const
+{
+    const double* record = (const double*)(_map + _headerSize) + index * (_stateSize + 1);
+    return GripTimesliceView(record[0], record + 1, _stateSize);
+}
+
+const std::string& GripTimelineFile::getFileName() const
+{
+    return _fileName;
+}
+
+size_t GripTimelineFile::getStateSize() const
+{
+    return _stateSize;
+}
+
+const std::vector<std::string>& GripTimelineFile::getSkeletonNames() const
+{
+    return _skeletonNames;
+}
+
+bool GripTimelineFile::matchesWorld(const dart::simulation::World& world) const
+{
+    if ((size_t)world.getNumSkeletons() != _skeletonNames.size()
+            || (size_t)world.getState().size() != _stateSize) {
+        return false;
+    }
+
+    for (int i = 0; i < world.getNumSkeletons(); ++i) {
+        if (world.getSkeleton(i)->getName() != _skeletonNames[i]
+                || (uint32_t)world.getIndex(i) != _skeletonIndices[i]
+                || (uint32_t)world.getSkeleton(i)->getNumGenCoords() != _skeletonNumGenCoords[i]) {
+            return false;
+        }
+    }
+    return true;
+}
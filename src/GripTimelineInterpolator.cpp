@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Local includes
+#include "GripTimelineInterpolator.h"
+
+// DART includes
+#include <dart/dynamics/Skeleton.h>
+#include <dart/dynamics/BodyNode.h>
+#include <dart/dynamics/FreeJoint.h>
+#include <dart/dynamics/GenCoord.h>
+#include <dart/math/Geometry.h>
+
+// Eigen includes
+#include <Eigen/Geometry>
+
+GripTimelineInterpolator::GripTimelineInterpolator()
+{
+}
+
+void GripTimelineInterpolator::setWorld(const dart::simulation::World& world)
+{
+    _freeJointOffsets.clear();
+
+    // Skeleton states are [q, dq], each starting at twice the skeleton's index
+    for (int i = 0; i < world.getNumSkeletons(); ++i) {
+        dart::dynamics::Skeleton* skel = world.getSkeleton(i);
+        for (int j = 0; j < skel->getNumBodyNodes(); ++j) {
+            dart::dynamics::Joint* joint = skel->getBodyNode(j)->getParentJoint();
+            if (dynamic_cast<dart::dynamics::FreeJoint*>(joint) && joint->getNumGenCoords() == 6) {
+                _freeJointOffsets.push_back(2 * world.getIndex(i) + joint->getGenCoord(0)->getSkeletonIndex());
+            }
+        }
+    }
+}
+
+size_t GripTimelineInterpolator::interpolate(const GripTimeline& timeline, double time, Eigen::VectorXd& state)
+{
+    size_t index = timeline.findIndex(time);
+    double beforeTime = timeline.at(index, state);
+    if (index + 1 >= timeline.size() || time <= beforeTime) {
+        return index;
+    }
+
+    double afterTime = timeline.at(index + 1, _after);
+    if (afterTime <= beforeTime) {
+        return index;
+    }
+
+    _before = state;
+    const Eigen::VectorXd& after = _after;
+    double alpha = (time - beforeTime) / (afterTime - beforeTime);
+    state += alpha * (after - _before);
+
+    // Lerping exponential coordinates doesn't follow the shortest rotation
+    for (size_t i = 0; i < _freeJointOffsets.size(); ++i) {
+        int offset = _freeJointOffsets[i];
+        if (offset + 6 > state.size()) {
+            continue;
+        }
+        Eigen::Isometry3d beforeTf = dart::math::expMap(Eigen::Vector6d(_before.segment<6>(offset)));
+        Eigen::Isometry3d afterTf = dart::math::expMap(Eigen::Vector6d(after.segment<6>(offset)));
+
+        Eigen::Isometry3d tf = Eigen::Isometry3d::Identity();
+        tf.linear() = Eigen::Quaterniond(beforeTf.linear())
+                .slerp(alpha, Eigen::Quaterniond(afterTf.linear())).toRotationMatrix();
+        tf.translation() = beforeTf.translation() + alpha * (afterTf.translation() - beforeTf.translation());
+        state.segment<6>(offset) = dart::math::logMap(tf);
+    }
+
+    return index;
+}
@@ -67,10 +67,10 @@ void GripTimeslice::setState(const Eigen::VectorXd &state)
     _state = state;
 }
 
-double GripTimeslice::getTime() {
+double GripTimeslice::getTime() const {
     return _time;
 }
 
-const Eigen::VectorXd& GripTimeslice::getState() {
+const Eigen::VectorXd& GripTimeslice::getState() const {
     return _state;
 }
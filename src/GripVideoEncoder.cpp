@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2014, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Pete Vieira <pete.vieira@gatech.edu>
+ * Date: Feb 2014
+ *
+ * Humanoid skeletonics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *   * Neither the name of the Humanoid Robotics Lab nor the names of
+ *     its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written
+ *     permission
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Local includes
+#include "GripVideoEncoder.h"
+
+// Qt includes
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QStringList>
+#include <QThread>
+
+// C++ Standard includes
+#include <iostream>
+
+/**
+ * \brief Thread pool task running one of the encoder loops of a GripVideoEncoder
+ */
+class GripEncoderTask : public QRunnable
+{
+public:
+    GripEncoderTask(GripVideoEncoder* encoder) : _encoder(encoder) {}
+
+    void run()
+    {
+        _encoder->_encode();
+    }
+
+protected:
+    GripVideoEncoder* _encoder;
+};
+
+GripVideoEncoder::GripVideoEncoder(int maxQueuedFrames, int numThreads)
+    : _pool(new QThreadPool),
+      _output(PNG_FRAMES),
+      _fps(30),
+      _process(NULL),
+      _maxQueuedFrames(maxQueuedFrames < 1 ? 1 : maxQueuedFrames),
+      _numThreads(numThreads > 0 ? numThreads : QThread::idealThreadCount()),
+      _numFramesQueued(0),
+      _numFramesWritten(0),
+      _numErrors(0),
+      _recording(false),
+      _finishing(false)
+{
+    if (_numThreads < 1) {
+        _numThreads = 1;
+    }
+}
+
+GripVideoEncoder::~GripVideoEncoder()
+{
+    finish();
+    delete _pool;
+}
+
+bool GripVideoEncoder::start(const QString& fileName, encoderOutput_t output, double fps)
+{
+    if (isRecording()) {
+        finish();
+    }
+
+    // Numbered frames get the frame number and extension appended
+    if (output == FFMPEG_PIPE) {
+        _fileName = fileName;
+    } else {
+        QFileInfo info(fileName);
+        _fileName = info.path() + "/" + info.completeBaseName();
+    }
+    _output = output;
+    _fps = fps;
+    _numFramesQueued = 0;
+    _numFramesWritten = 0;
+    _numErrors = 0;
+    _recording = true;
+    _finishing = false;
+
+    // ffmpeg needs the frames in order, so the pipe gets a single writer
+    int numThreads = (output == FFMPEG_PIPE ? 1 : _numThreads);
+    _pool->setMaxThreadCount(numThreads);
+    for (int i=0; i<numThreads; ++i) {
+        _pool->start(new GripEncoderTask(this));
+    }
+
+    return true;
+}
+
+bool GripVideoEncoder::addFrame(const QImage& frame)
+{
+    QMutexLocker lock(&_mutex);
+    if (!_recording) {
+        return false;
+    }
+
+    while (_queue.size() >= _maxQueuedFrames) {
+        _frameTaken.wait(&_mutex);
+    }
+
+    _queue.enqueue(qMakePair(_numFramesQueued++, frame));
+    _frameQueued.wakeOne();
+    return true;
+}
+
+bool GripVideoEncoder::finish()
+{
+    {
+        QMutexLocker lock(&_mutex);
+        if (!_recording) {
+            return _numErrors == 0;
+        }
+        _recording = false;
+        _finishing = true;
+        _frameQueued.wakeAll();
+    }
+
+    _pool->waitForDone();
+
+    QMutexLocker lock(&_mutex);
+    return _numErrors == 0;
+}
+
+bool GripVideoEncoder::isRecording() const
+{
+    QMutexLocker lock(&_mutex);
+    return _recording;
+}
+
+int GripVideoEncoder::getNumFramesWritten() const
+{
+    QMutexLocker lock(&_mutex);
+    return _numFramesWritten;
+}
+
+GripVideoEncoder::encoderOutput_t GripVideoEncoder::outputFromFileName(const QString& fileName)
+{
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "png") {
+        return PNG_FRAMES;
+    } else if (suffix == "raw") {
+        return RAW_FRAMES;
+    } else {
+        return FFMPEG_PIPE;
+    }
+}
+
+void GripVideoEncoder::_encode()
+{
+    QMutexLocker lock(&_mutex);
+    while (true) {
+        while (_queue.isEmpty() && !_finishing) {
+            _frameQueued.wait(&_mutex);
+        }
+        if (_queue.isEmpty()) {
+            break;
+        }
+
+        QPair<int, QImage> frame = _queue.dequeue();
+        _frameTaken.wakeOne();
+
+        // Encode without holding the lock so the other encoders and the recorder keep going
+        lock.unlock();
+        bool written = _writeFrame(frame.first, frame.second);
+        lock.relock();
+
+        if (written) {
+            ++_numFramesWritten;
+        } else {
+            ++_numErrors;
+        }
+    }
+
+    // The process belongs to the thread that started it, so it's closed here
+    if (_process) {
+        lock.unlock();
+        bool closed = _closePipe();
+        lock.relock();
+        if (!closed) {
+            ++_numErrors;
+        }
+    }
+}
+
+bool GripVideoEncoder::_writeFrame(int index, const QImage& frame)
+{
+    QString fileName;
+
+    switch (_output) {
+        case PNG_FRAMES: {
+            fileName.sprintf("%s%06d.png", qPrintable(_fileName), index);
+            if (!frame.save(fileName, "PNG")) {
+                std::cerr << "[GripVideoEncoder] Could not write " << fileName.toStdString() << std::endl;
+                return false;
+            }
+            return true;
+        }
+        case RAW_FRAMES: {
+            fileName.sprintf("%s%06d.raw", qPrintable(_fileName), index);
+            QFile file(fileName);
+            QImage pixels = frame.convertToFormat(QImage::Format_RGB32);
+            if (!file.open(QIODevice::WriteOnly)
+                    || file.write((const char*)pixels.constBits(), pixels.byteCount()) != pixels.byteCount()) {
+                std::cerr << "[GripVideoEncoder] Could not write " << fileName.toStdString() << std::endl;
+                return false;
+            }
+            return true;
+        }
+        case FFMPEG_PIPE: {
+            // The pipe is opened by the first frame, which gives the video size
+            if (!_process && (index != 0 || !_openPipe(frame.width(), frame.height()))) {
+                return false;
+            }
+            QImage pixels = frame.convertToFormat(QImage::Format_RGB32);
+            if (_process->write((const char*)pixels.constBits(), pixels.byteCount()) != pixels.byteCount()) {
+                return false;
+            }
+            // Wait for ffmpeg to take the frame so the process buffer stays bounded like the queue
+            while (_process->bytesToWrite() > 0) {
+                if (!_process->waitForBytesWritten(-1)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool GripVideoEncoder::_openPipe(int width, int height)
+{
+    // Arguments go straight to ffmpeg, so the file name is never seen by a shell
+    QStringList arguments;
+    arguments << "-loglevel" << "error" << "-y"
+              << "-f" << "rawvideo" << "-pix_fmt" << "bgra"
+              << "-s" << QString("%1x%2").arg(width).arg(height)
+              << "-r" << QString::number(_fps)
+              << "-i" << "-"
+              << "-pix_fmt" << "yuv420p" << _fileName;
+
+    _process = new QProcess;
+    _process->setProcessChannelMode(QProcess::ForwardedChannels);
+    _process->start("ffmpeg", arguments, QIODevice::WriteOnly);
+    if (!_process->waitForStarted()) {
+        std::cerr << "[GripVideoEncoder] Could not start ffmpeg to write " << _fileName.toStdString() << std::endl;
+        delete _process;
+        _process = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool GripVideoEncoder::_closePipe()
+{
+    _process->closeWriteChannel();
+    bool encoded = _process->waitForFinished(-1)
+            && _process->exitStatus() == QProcess::NormalExit
+            && _process->exitCode() == 0;
+    if (!encoded) {
+        std::cerr << "[GripVideoEncoder] ffmpeg failed to encode " << _fileName.toStdString() << std::endl;
+    }
+    delete _process;
+    _process = NULL;
+    return encoded;
+}
@@ -52,35 +52,56 @@ HuboController::HuboController(dart::dynamics::Skeleton *skeleton,
                                const Eigen::VectorXd i,
                                const Eigen::VectorXd d,
                                const Eigen::VectorXd mask,
-                               double tInit) {
+                               double tInit)
+    : _ldlt(skeleton->getNumGenCoords()) {
     skel = skeleton;
-    Kp = p.asDiagonal();
-    Ki = i.asDiagonal();
-    Kd = d.asDiagonal();
-    jointMask = mask.asDiagonal();
+    Kp = p;
+    Ki = i;
+    Kd = d;
+    jointMask = mask;
     tLast = tInit;
-    errorLast = Eigen::VectorXd::Zero(skel->getNumGenCoords());
-    errorDeriv = Eigen::VectorXd::Zero(skel->getNumGenCoords());
-    errorInteg = Eigen::VectorXd::Zero(skel->getNumGenCoords());
-    refVel = Eigen::VectorXd::Zero(skel->getNumGenCoords());
-    refPos = Eigen::VectorXd::Zero(skel->getNumGenCoords());
+    int n = skel->getNumGenCoords();
+    errorLast = Eigen::VectorXd::Zero(n);
+    errorDeriv = Eigen::VectorXd::Zero(n);
+    errorInteg = Eigen::VectorXd::Zero(n);
+    refVel = Eigen::VectorXd::Zero(n);
+    refPos = Eigen::VectorXd::Zero(n);
+
+    // Workspaces for getTorques, so a control tick doesn't allocate
+    _M.resize(n, n);
+    _p.resize(n);
+    _d.resize(n);
+    _qddot.resize(n);
 }
 
 Eigen::VectorXd HuboController::getTorques(const Eigen::VectorXd &curPos,
                                            const Eigen::VectorXd &curVel,
                                            double t) {
+    Eigen::VectorXd torques(curPos.size());
+    getTorques(curPos, curVel, t, torques);
+    return torques;
+}
+
+void HuboController::getTorques(const Eigen::VectorXd &curPos,
+                                const Eigen::VectorXd &curVel,
+                                double t,
+                                Eigen::VectorXd &torques) {
     // update time
     double dt = t - tLast;
     tLast = t;
 
     // SPD controller
     // J. Tan, K. Liu, G. Turk. Stable Proportional-Derivative Controllers. IEEE Computer Graphics and Applications, Vol. 31, No. 4, pp 34-44, 2011.
-    Eigen::MatrixXd M = skel->getMassMatrix() + Kd * dt;
-    Eigen::MatrixXd invM = M.inverse();
-    Eigen::VectorXd p = -Kp * (curPos - refPos + curVel * dt);
-    Eigen::VectorXd d = -Kd * (curVel - refVel);
-    Eigen::VectorXd qddot = invM * (-skel->getCombinedVector() + p + d);
-    Eigen::VectorXd torques = p + d - Kd * qddot * dt;
+    // M + Kd * dt is symmetric positive definite, so it's factored with LDLT and
+    // solved in place instead of inverted
+    _M = skel->getMassMatrix();
+    _M.diagonal() += Kd * dt;
+    _ldlt.compute(_M);
+
+    _p = -Kp.cwiseProduct(curPos - refPos + curVel * dt);
+    _d = -Kd.cwiseProduct(curVel - refVel);
+    _qddot = _p + _d - skel->getCombinedVector();
+    _ldlt.solveInPlace(_qddot);
 
-    return jointMask * torques;
+    torques = jointMask.cwiseProduct(_p + _d - dt * Kd.cwiseProduct(_qddot));
 }
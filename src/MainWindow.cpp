@@ -252,6 +252,16 @@ void MainWindow::createActions()
     loadWorkspaceConfigurationAct->setStatusTip(tr("Load a workspace configuration"));
     connect(loadWorkspaceConfigurationAct, SIGNAL(triggered()), this, SLOT(loadWorkspace()));
 
+    //saveTimelineAct
+    saveTimelineAct = new QAction(tr("Save Timeline"), this);
+    saveTimelineAct->setStatusTip(tr("Save the playback timeline to a file"));
+    connect(saveTimelineAct, SIGNAL(triggered()), this, SLOT(saveTimeline()));
+
+    //loadTimelineAct
+    loadTimelineAct = new QAction(tr("Load Timeline"), this);
+    loadTimelineAct->setStatusTip(tr("Load a timeline file for playback"));
+    connect(loadTimelineAct, SIGNAL(triggered()), this, SLOT(loadTimeline()));
+
     //closeAct
     closeSceneAct = new QAction(tr("&Close"), this);
     closeSceneAct->setShortcut(Qt::CTRL + Qt::Key_W);
@@ -295,6 +305,12 @@ void MainWindow::createActions()
     simulateSingleStepAct->setShortcut(Qt::CTRL + Qt::SHIFT + Qt::Key_R);
     connect(simulateSingleStepAct, SIGNAL(triggered()), this, SLOT(simulateSingleStep()));
 
+    //recordTimelineAct
+    recordTimelineAct = new QAction(tr("Record Simulation to File"), this);
+    recordTimelineAct->setStatusTip(tr("Stream every simulated time step to a timeline file"));
+    recordTimelineAct->setCheckable(true);
+    connect(recordTimelineAct, SIGNAL(toggled(bool)), this, SLOT(recordTimeline(bool)));
+
     //renderDuringSimulationAct
     renderDuringSimulationAct = new QAction(tr("Render during Simulation"), this);
     connect(renderDuringSimulationAct, SIGNAL(triggered()), this, SLOT(renderDuringSimulation()));
@@ -316,6 +332,27 @@ void MainWindow::createActions()
     resetCameraAct->setStatusTip(tr("Reset Camera Angle"));
     connect(resetCameraAct, SIGNAL(triggered()), this, SLOT(resetCamera()));
 
+    //timelineRetentionAct
+    timelineRetentionAct = new QAction(tr("Timeline Retention..."), this);
+    timelineRetentionAct->setStatusTip(tr("Limit how much of the timeline is kept in memory"));
+    connect(timelineRetentionAct, SIGNAL(triggered()), this, SLOT(setTimelineRetention()));
+
+    //maxFrameRateAct
+    maxFrameRateAct = new QAction(tr("Maximum Frame Rate..."), this);
+    maxFrameRateAct->setStatusTip(tr("Limit how often the scene is rendered while simulating"));
+    connect(maxFrameRateAct, SIGNAL(triggered()), this, SLOT(setMaxFrameRate()));
+
+    //renderingThreadsAct
+    renderingThreadsAct = new QAction(tr("Rendering Threads..."), this);
+    renderingThreadsAct->setStatusTip(tr("Choose which threads cull and draw the scene"));
+    connect(renderingThreadsAct, SIGNAL(triggered()), this, SLOT(setRenderingThreads()));
+
+    //saveProfileOnExitAct
+    saveProfileOnExitAct = new QAction(tr("Save Timings on Exit"), this);
+    saveProfileOnExitAct->setStatusTip(tr("Write the profiler timings to ~/grip-profile.csv on exit"));
+    saveProfileOnExitAct->setCheckable(true);
+    saveProfileOnExitAct->setChecked(true);
+
     //xga1024x768Act
     xga1024x768Act = new QAction(tr("XGA 1024 x 768"), this);
     xga1024x768Act->setCheckable(true);
@@ -332,6 +369,11 @@ void MainWindow::createActions()
     hd1280x720Act->setCheckable(true);
     connect(hd1280x720Act, SIGNAL(triggered()), this, SLOT(hd1280x720()));
 
+    //exportVideoAct
+    exportVideoAct = new QAction(tr("Export Video..."), this);
+    exportVideoAct->setStatusTip(tr("Render the timeline at a fixed frame rate of simulated time"));
+    connect(exportVideoAct, SIGNAL(triggered()), this, SLOT(exportVideo()));
+
     //aboutAct
     aboutAct = new QAction(tr("About"), this);
     aboutAct->setShortcut(Qt::Key_F1);
@@ -354,6 +396,9 @@ void MainWindow::createMenus()
     fileMenu->addAction(saveNewWorkspaceConfigurationAct);
     fileMenu->addAction(loadWorkspaceConfigurationAct);
     fileMenu->addSeparator();
+    fileMenu->addAction(saveTimelineAct);
+    fileMenu->addAction(loadTimelineAct);
+    fileMenu->addSeparator();
     fileMenu->addAction(exitAct);
 
     //viewMenu
@@ -368,6 +413,8 @@ void MainWindow::createMenus()
     simulationMenu->addAction(stopSimulationAct);
     simulationMenu->addSeparator();
     simulationMenu->addAction(simulateSingleStepAct);
+    simulationMenu->addSeparator();
+    simulationMenu->addAction(recordTimelineAct);
 
     //settingsMenu
     settingsMenu = menuBar()->addMenu(tr("&Settings"));
@@ -380,12 +427,18 @@ void MainWindow::createMenus()
     backgroundMenu->addAction(blackAct);
     //settings Menu contd...
     settingsMenu->addAction(resetCameraAct);
+    settingsMenu->addAction(timelineRetentionAct);
+    settingsMenu->addAction(maxFrameRateAct);
+    settingsMenu->addAction(renderingThreadsAct);
+    settingsMenu->addAction(saveProfileOnExitAct);
 
     //renderMenu
     renderMenu = menuBar()->addMenu(tr("&Render"));
     renderMenu->addAction(xga1024x768Act);
     renderMenu->addAction(vga640x480Act);
     renderMenu->addAction(hd1280x720Act);
+    renderMenu->addSeparator();
+    renderMenu->addAction(exportVideoAct);
 
     //helpMenu
     helpMenu = menuBar()->addMenu(tr("&Help"));
@@ -1,5 +1,6 @@
 #include <QApplication>
 #include "GripMainWindow.h"
+#include "GripInterface.h"
 #include <X11/Xlib.h>
 
 /**
@@ -16,11 +17,17 @@ void showUsage(std::ostream &ostr)
             "  -d|--debug                Print debug statements\n"
             "  -f|--file sceneFile       Load scene \"sceneFile\" (.urdf, .sdf)\n"
             "  -c|--config configFile    Load workspace \"configFile\" (.gripconfig)\n"
+            "  --headless                Simulate without a window (needs -f and -n)\n"
+            "  -n|--steps numSteps       Number of time steps to simulate in headless mode\n"
+            "  -o|--output timelineFile  Record the headless simulation to \"timelineFile\"\n"
+            "  --retention seconds       Only keep the last \"seconds\" of the timeline in memory\n"
+            "  --spill                   Spill older parts of the timeline to disk instead of dropping them\n"
             "  -h|--help                 Show this help message\n"
             "\n"
             "Examples\n"
             "  grip -d\n"
             "  grip -d -f ~/sceneFiles/robot.urdf\n"
+            "  grip --headless -f ~/sceneFiles/robot.urdf --steps 10000 -o robot.griptimeline\n"
             "  grip --help\n";
 }
 
@@ -33,6 +40,7 @@ int main(int argc, char *argv[])
 {
     // Variables for command line parsing
     bool debug = false;
+    bool headless = false;
     std::string sceneFilePath;
     std::string configFilePath;
 
@@ -46,12 +54,20 @@ int main(int argc, char *argv[])
             sceneFilePath = args[i+1];
         } else if ("-c" == args[i] || "--config" == args[i]) {
             configFilePath = args[i+1];
+        } else if ("--headless" == args[i]) {
+            headless = true;
         } else if ("-h" == args[i] || "--help" == args[i]) {
             showUsage(std::cerr);
             exit(1);
         }
     }
 
+    // Headless batch simulation never creates a window, so hand it off to the GripInterface
+    if (headless) {
+        GripInterface grip;
+        return grip._create(argc, argv);
+    }
+
     // Initialize Xlib support for concurrent threads
     XInitThreads();
 
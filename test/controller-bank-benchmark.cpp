@@ -0,0 +1,117 @@
+#include <dart/dynamics/Skeleton.h>
+#include <dart/utils/urdf/DartLoader.h>
+#include "GripControllerBank.h"
+#include "gripTime.h"
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+/**
+ * Compares computing the torques of many copies of the drchubo_v2 model one
+ * controller at a time against a GripControllerBank on all cores, and prints
+ * the slowest and fastest controller of the last tick. Both get the same joint
+ * states and gains, so the torques have to match.
+ *
+ * Usage: controller-bank-benchmark [urdfFile] [numSkeletons] [numTicks]
+ */
+
+HuboController* createController(dart::dynamics::Skeleton* robot)
+{
+    int n = robot->getNumGenCoords();
+    return new HuboController(robot,
+                              Eigen::VectorXd::Constant(n, 500.0),
+                              Eigen::VectorXd::Zero(n),
+                              Eigen::VectorXd::Constant(n, 50.0),
+                              Eigen::VectorXd::Ones(n),
+                              0);
+}
+
+void moveJoints(dart::dynamics::Skeleton* robot, size_t tick, size_t s)
+{
+    Eigen::VectorXd q(robot->getNumGenCoords());
+    for (int i=0; i<q.size(); ++i) {
+        q[i] = 0.2 * std::sin(0.01 * tick + i + s);
+    }
+    robot->setConfig(q);
+}
+
+int main(int argc, char** argv)
+{
+    std::string urdfFile = (argc > 1 ? argv[1] : "../models/drchubo_v2/robots/drchubo_v2.urdf");
+    size_t numSkeletons = (argc > 2 ? atoi(argv[2]) : 16);
+    size_t numTicks = (argc > 3 ? atoi(argv[3]) : 500);
+    const double dt = 0.001;
+
+    dart::utils::DartLoader loader;
+    std::vector<dart::dynamics::Skeleton*> robots;
+    std::vector<HuboController*> serial;
+    GripControllerBank bank;
+    for (size_t i=0; i<numSkeletons; ++i) {
+        dart::dynamics::Skeleton* robot = loader.parseSkeleton(urdfFile);
+        if (!robot) {
+            std::cerr << "[controller-bank-benchmark] Error parsing " << urdfFile << std::endl;
+            return 1;
+        }
+        robot->init(dt);
+        robots.push_back(robot);
+        serial.push_back(createController(robot));
+        bank.addController(createController(robot));
+    }
+
+    std::cout << numSkeletons << " skeletons with " << robots[0]->getNumGenCoords() << " DOFs, "
+              << numTicks << " ticks" << std::endl;
+
+    // Joint motion is the same for both so only the scheduling differs
+    std::vector<Eigen::VectorXd> torques(numSkeletons, Eigen::VectorXd::Zero(robots[0]->getNumGenCoords()));
+    double serialTime = 0;
+    double bankTime = 0;
+    int failed = 0;
+    for (size_t tick=0; tick<numTicks; ++tick) {
+        for (size_t s=0; s<numSkeletons; ++s) {
+            moveJoints(robots[s], tick, s);
+        }
+        double t = (tick + 1) * dt;
+
+        double start = grip::getTime();
+        for (size_t s=0; s<numSkeletons; ++s) {
+            serial[s]->getTorques(robots[s]->get_q(), robots[s]->get_dq(), t, torques[s]);
+        }
+        serialTime += grip::getTime() - start;
+
+        start = grip::getTime();
+        bank.computeTorques(t);
+        bankTime += grip::getTime() - start;
+
+        for (size_t s=0; s<numSkeletons; ++s) {
+            if (!torques[s].isApprox(bank.getTorques(s))) {
+                std::cerr << "[controller-bank-benchmark] Torques of skeleton " << s
+                          << " differ at tick " << tick << std::endl;
+                ++failed;
+            }
+        }
+    }
+
+    double slowest = 0;
+    double fastest = bank.getLastDuration(0);
+    for (size_t s=0; s<numSkeletons; ++s) {
+        slowest = std::max(slowest, bank.getLastDuration(s));
+        fastest = std::min(fastest, bank.getLastDuration(s));
+    }
+
+    std::cout << std::setw(12) << "path"
+              << std::setw(14) << "us/tick" << "\n"
+              << std::setw(12) << "serial"
+              << std::setw(14) << 1e6 * serialTime / numTicks << "\n"
+              << std::setw(12) << "bank"
+              << std::setw(14) << 1e6 * bankTime / numTicks << "\n"
+              << "speedup " << serialTime / bankTime << "\n"
+              << "last tick per controller: fastest " << 1e6 * fastest
+              << " us, slowest " << 1e6 * slowest << " us" << std::endl;
+
+    for (size_t s=0; s<numSkeletons; ++s) {
+        delete serial[s];
+    }
+    return failed;
+}
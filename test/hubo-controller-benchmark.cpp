@@ -0,0 +1,132 @@
+#include <dart/dynamics/Skeleton.h>
+#include <dart/dynamics/BodyNode.h>
+#include <dart/dynamics/RevoluteJoint.h>
+#include "HuboController.h"
+#include "gripTime.h"
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+
+/**
+ * Compares HuboController::getTorques, which factors the SPD system with LDLT
+ * into preallocated workspaces, against the dense inverse it replaced, on
+ * serial chains of revolute joints with increasing numbers of DOFs. Every
+ * iteration moves the chain and computes torques once, like a control tick.
+ *
+ * Usage: hubo-controller-benchmark [numTicks]
+ */
+
+dart::dynamics::Skeleton* createChain(int numDofs)
+{
+    dart::dynamics::Skeleton* chain = new dart::dynamics::Skeleton();
+    dart::dynamics::BodyNode* parent = NULL;
+    for (int i=0; i<numDofs; ++i) {
+        dart::dynamics::BodyNode* node = new dart::dynamics::BodyNode();
+        node->setMass(1.0);
+
+        // Alternate the axes so the mass matrix isn't banded
+        dart::dynamics::RevoluteJoint* joint =
+                new dart::dynamics::RevoluteJoint(i % 2 ? Eigen::Vector3d::UnitX() : Eigen::Vector3d::UnitY());
+        Eigen::Isometry3d offset = Eigen::Isometry3d::Identity();
+        offset.translation() = Eigen::Vector3d(0, 0, (parent ? 0.1 : 0));
+        joint->setTransformFromParentBodyNode(offset);
+        node->setParentJoint(joint);
+
+        if (parent) {
+            parent->addChildBodyNode(node);
+        }
+        chain->addBodyNode(node);
+        parent = node;
+    }
+    chain->init();
+    return chain;
+}
+
+void moveChain(dart::dynamics::Skeleton* chain, size_t tick)
+{
+    int n = chain->getNumGenCoords();
+    Eigen::VectorXd x(2 * n);
+    for (int i=0; i<n; ++i) {
+        x[i] = 0.2 * std::sin(0.01 * tick + i);
+        x[n + i] = 0.1 * std::cos(0.01 * tick + i);
+    }
+    chain->setState(x);
+}
+
+/// The stable PD torques as HuboController used to compute them
+Eigen::VectorXd inverseTorques(const HuboController& c, dart::dynamics::Skeleton* skel,
+                               const Eigen::VectorXd& curPos, const Eigen::VectorXd& curVel, double dt)
+{
+    Eigen::MatrixXd Kp = c.Kp.asDiagonal();
+    Eigen::MatrixXd Kd = c.Kd.asDiagonal();
+    Eigen::MatrixXd jointMask = c.jointMask.asDiagonal();
+    Eigen::MatrixXd M = skel->getMassMatrix() + Kd * dt;
+    Eigen::MatrixXd invM = M.inverse();
+    Eigen::VectorXd p = -Kp * (curPos - c.refPos + curVel * dt);
+    Eigen::VectorXd d = -Kd * (curVel - c.refVel);
+    Eigen::VectorXd qddot = invM * (-skel->getCombinedVector() + p + d);
+    Eigen::VectorXd torques = p + d - Kd * qddot * dt;
+    return jointMask * torques;
+}
+
+int main(int argc, char** argv)
+{
+    size_t numTicks = (argc > 1 ? atoi(argv[1]) : 1000);
+    const double dt = 0.001;
+    const int dofCounts[] = {8, 16, 32, 57, 64, 128};
+
+    std::cout << numTicks << " ticks per chain" << std::endl;
+    std::cout << std::setw(8) << "DOFs"
+              << std::setw(16) << "inverse us"
+              << std::setw(16) << "ldlt us"
+              << std::setw(12) << "speedup" << "\n";
+
+    int failed = 0;
+    for (size_t c=0; c<sizeof(dofCounts)/sizeof(dofCounts[0]); ++c) {
+        int n = dofCounts[c];
+        dart::dynamics::Skeleton* chain = createChain(n);
+        HuboController controller(chain,
+                                  Eigen::VectorXd::Constant(n, 500.0),
+                                  Eigen::VectorXd::Zero(n),
+                                  Eigen::VectorXd::Constant(n, 50.0),
+                                  Eigen::VectorXd::Ones(n),
+                                  0);
+
+        // Both paths see the same states, so only the solve differs
+        Eigen::VectorXd torques(n);
+        double maxError = 0;
+        double inverseTime = 0;
+        double ldltTime = 0;
+        for (size_t tick=0; tick<numTicks; ++tick) {
+            moveChain(chain, tick);
+            Eigen::VectorXd q = chain->get_q();
+            Eigen::VectorXd dq = chain->get_dq();
+
+            double start = grip::getTime();
+            Eigen::VectorXd expected = inverseTorques(controller, chain, q, dq, dt);
+            inverseTime += grip::getTime() - start;
+
+            start = grip::getTime();
+            controller.getTorques(q, dq, (tick + 1) * dt, torques);
+            ldltTime += grip::getTime() - start;
+
+            double error = (expected - torques).norm() / (expected.norm() + 1e-12);
+            maxError = (error > maxError ? error : maxError);
+        }
+
+        if (maxError > 1e-6) {
+            std::cerr << "[hubo-controller-benchmark] Torques differ by " << maxError
+                      << " with " << n << " DOFs" << std::endl;
+            ++failed;
+        }
+
+        std::cout << std::setw(8) << n
+                  << std::setw(16) << 1e6 * inverseTime / numTicks
+                  << std::setw(16) << 1e6 * ldltTime / numTicks
+                  << std::setw(12) << inverseTime / ldltTime << std::endl;
+        delete chain;
+    }
+
+    return failed;
+}
@@ -0,0 +1,172 @@
+#include <dart/dynamics/Skeleton.h>
+#include <dart/dynamics/BodyNode.h>
+#include <dart/utils/urdf/DartLoader.h>
+#include "SkeletonNode.h"
+#include "osgUtils.h"
+#include "gripTime.h"
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+/**
+ * Compares the flat array SkeletonNode::update against the recursive,
+ * map based walk it replaced, on copies of the drchubo_v2 model. Every
+ * iteration moves all the joints and then updates every SkeletonNode,
+ * like a frame during simulation with several robots in the scene.
+ *
+ * Usage: skeleton-update-benchmark [urdfFile] [numSkeletonNodes] [numFrames]
+ */
+
+/// Gives access to the recursive update SkeletonNode used to do
+class MapSkeletonNode : public osgDart::SkeletonNode
+{
+public:
+    MapSkeletonNode(const dart::dynamics::Skeleton& skeleton)
+        : osgDart::SkeletonNode(skeleton)
+    {
+    }
+
+    void updateWithMaps()
+    {
+        _bodyNodeMatrixMap.at(&_rootBodyNode)->setMatrix(osgGolems::eigToOsgMatrix(_rootBodyNode.getWorldTransform()));
+        _bodyNodeVisualsMap.at(&_rootBodyNode)->setMatrix(osgGolems::eigToOsgMatrix(_rootBodyNode.getWorldTransform()));
+        for (int i=0; i<_rootBodyNode.getNumChildBodyNodes(); ++i) {
+            updateRecursively(*_rootBodyNode.getChildBodyNode(i));
+        }
+        _updateSkeletonVisuals();
+    }
+
+    void updateRecursively(const dart::dynamics::BodyNode& bodyNode)
+    {
+        BodyNodeMatrixMap::const_iterator it = _bodyNodeMatrixMap.find(&bodyNode);
+        if (it != _bodyNodeMatrixMap.end()) {
+            _bodyNodeMatrixMap.at(&bodyNode)->setMatrix(osgGolems::eigToOsgMatrix(bodyNode.getWorldTransform()));
+            _bodyNodeVisualsMap.at(&bodyNode)->setMatrix(osgGolems::eigToOsgMatrix(bodyNode.getWorldTransform()));
+            for (int i=0; i<bodyNode.getNumChildBodyNodes(); ++i) {
+                updateRecursively(*bodyNode.getChildBodyNode(i));
+            }
+        }
+    }
+
+    const osg::MatrixTransform* getMatrix(const dart::dynamics::BodyNode* bodyNode)
+    {
+        return _bodyNodeMatrixMap.at(bodyNode).get();
+    }
+
+    const osg::MatrixTransform* getVisuals(const dart::dynamics::BodyNode* bodyNode)
+    {
+        return _bodyNodeVisualsMap.at(bodyNode).get();
+    }
+};
+
+/// Number of BodyNodes whose transforms differ between the map based and the flat update
+int compareUpdates(dart::dynamics::Skeleton* robot, MapSkeletonNode* node)
+{
+    std::vector<osg::Matrix> matrices(robot->getNumBodyNodes());
+    std::vector<osg::Matrix> visuals(robot->getNumBodyNodes());
+    node->updateWithMaps();
+    for (int i=0; i<robot->getNumBodyNodes(); ++i) {
+        matrices[i] = node->getMatrix(robot->getBodyNode(i))->getMatrix();
+        visuals[i] = node->getVisuals(robot->getBodyNode(i))->getMatrix();
+    }
+
+    int failed = 0;
+    node->update();
+    for (int i=0; i<robot->getNumBodyNodes(); ++i) {
+        if (node->getMatrix(robot->getBodyNode(i))->getMatrix() != matrices[i]
+                || node->getVisuals(robot->getBodyNode(i))->getMatrix() != visuals[i]) {
+            std::cerr << "[skeleton-update-benchmark] Flat update differs from the map based one for "
+                      << robot->getBodyNode(i)->getName() << std::endl;
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+void moveJoints(dart::dynamics::Skeleton* robot, size_t frame)
+{
+    Eigen::VectorXd q(robot->getNumGenCoords());
+    for (int i=0; i<q.size(); ++i) {
+        q[i] = 0.2 * std::sin(0.01 * frame + i);
+    }
+    robot->setConfig(q);
+}
+
+int main(int argc, char** argv)
+{
+    std::string urdfFile = (argc > 1 ? argv[1] : "../models/drchubo_v2/robots/drchubo_v2.urdf");
+    size_t numNodes = (argc > 2 ? atoi(argv[2]) : 24);
+    size_t numFrames = (argc > 3 ? atoi(argv[3]) : 500);
+
+    dart::utils::DartLoader loader;
+    dart::dynamics::Skeleton* robot = loader.parseSkeleton(urdfFile);
+    if (!robot) {
+        std::cerr << "[skeleton-update-benchmark] Error parsing " << urdfFile << std::endl;
+        return 1;
+    }
+
+    std::vector<osg::ref_ptr<MapSkeletonNode> > nodes;
+    for (size_t i=0; i<numNodes; ++i) {
+        nodes.push_back(new MapSkeletonNode(*robot));
+    }
+
+    std::cout << robot->getNumBodyNodes() << " BodyNodes, " << numNodes << " SkeletonNodes, "
+              << numFrames << " frames" << std::endl;
+
+    // Both paths have to put every BodyNode in the same place before either is worth timing
+    int failed = 0;
+    for (size_t frame=0; frame<numFrames && frame<10; ++frame) {
+        moveJoints(robot, 37 * frame);
+        failed += compareUpdates(robot, nodes[0].get());
+    }
+    if (failed) {
+        return failed;
+    }
+
+    // Joint motion is the same for both so only the update itself differs
+    double mapTime = 0;
+    double flatTime = 0;
+    for (size_t frame=0; frame<numFrames; ++frame) {
+        moveJoints(robot, frame);
+
+        double start = grip::getTime();
+        for (size_t i=0; i<numNodes; ++i) {
+            nodes[i]->updateWithMaps();
+        }
+        mapTime += grip::getTime() - start;
+
+        start = grip::getTime();
+        for (size_t i=0; i<numNodes; ++i) {
+            nodes[i]->update();
+        }
+        flatTime += grip::getTime() - start;
+    }
+
+    // And the flat path has to follow the skeleton
+    osg::Matrix expected;
+    for (int i=0; i<robot->getNumBodyNodes(); ++i) {
+        expected = osgGolems::eigToOsgMatrix(robot->getBodyNode(i)->getWorldTransform());
+        if (nodes[0]->getMatrix(robot->getBodyNode(i))->getMatrix() != expected) {
+            std::cerr << "[skeleton-update-benchmark] Wrong transform for "
+                      << robot->getBodyNode(i)->getName() << std::endl;
+            ++failed;
+        }
+    }
+
+    double mapFrame = 1e6 * mapTime / numFrames;
+    double flatFrame = 1e6 * flatTime / numFrames;
+    std::cout << std::setw(12) << "path"
+              << std::setw(14) << "us/frame"
+              << std::setw(14) << "ns/body" << "\n"
+              << std::setw(12) << "map"
+              << std::setw(14) << mapFrame
+              << std::setw(14) << 1e3 * mapFrame / (numNodes * robot->getNumBodyNodes()) << "\n"
+              << std::setw(12) << "flat"
+              << std::setw(14) << flatFrame
+              << std::setw(14) << 1e3 * flatFrame / (numNodes * robot->getNumBodyNodes()) << "\n"
+              << "speedup " << mapTime / flatTime << std::endl;
+
+    return failed;
+}
@@ -0,0 +1,171 @@
+#include "GripTimeline.h"
+#include "gripTime.h"
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/**
+ * Memory and throughput benchmark for the GripTimeline storage modes.
+ * Records a synthetic humanoid-sized trajectory (smoothly moving joints plus
+ * joints that stay put, like a Hubo standing with its hands at rest) and
+ * reports bytes per slice, push rate, sequential and random decode rates,
+ * and the largest decoding error.
+ *
+ * Usage: timeline-benchmark [numSteps] [numDofs]
+ */
+
+// Keeps the decode loops from being optimized away
+volatile double sink;
+
+Eigen::VectorXd makeState(size_t step, size_t numDofs)
+{
+    // Position then velocity for each dof, like World::getState
+    double t = step * 0.001;
+    Eigen::VectorXd state = Eigen::VectorXd::Zero(2 * numDofs);
+    for (size_t i = 0; i < numDofs; ++i) {
+        if (i % 3 == 2) {
+            state[i] = 0.1 * i;   // Joint at rest
+            continue;
+        }
+        double w = 0.5 + 0.1 * i;
+        state[i] = 0.3 * std::sin(w * t + i);
+        state[numDofs + i] = 0.3 * w * std::cos(w * t + i);
+    }
+    return state;
+}
+
+int benchmark(const char* name, GripTimeline& timeline, size_t numSteps, size_t numDofs,
+              double maxAllowedError)
+{
+    double start = grip::getTime();
+    for (size_t i = 0; i < numSteps; ++i) {
+        timeline.push_back(i * 0.001, makeState(i, numDofs));
+    }
+    double pushTime = grip::getTime() - start;
+
+    // Sequential playback, one slice after the other
+    start = grip::getTime();
+    double checksum = 0;
+    for (size_t i = 0; i < numSteps; ++i) {
+        checksum += timeline.at(i).getState()[0];
+    }
+    double sequentialTime = grip::getTime() - start;
+
+    // Random access, like dragging the playback slider around
+    size_t numRandom = numSteps / 10 + 1;
+    srand(0);
+    start = grip::getTime();
+    for (size_t i = 0; i < numRandom; ++i) {
+        checksum += timeline.at(rand() % numSteps).getState()[0];
+    }
+    double randomTime = grip::getTime() - start;
+
+    // Whole timeline into contiguous arrays, like handing it to numpy
+    std::vector<double> times(numSteps);
+    std::vector<double> states(numSteps * timeline.getStateSize());
+    start = grip::getTime();
+    timeline.copyTo(0, numSteps, times.data(), states.data());
+    double bulkTime = grip::getTime() - start;
+
+    // Worst decoding error over the whole run
+    double maxError = 0;
+    for (size_t i = 0; i < numSteps; ++i) {
+        double error = (timeline.at(i).getState() - makeState(i, numDofs)).cwiseAbs().maxCoeff();
+        maxError = std::max(maxError, error);
+    }
+
+    // The bulk copy has to match the slices one by one exactly
+    bool bulkMatches = true;
+    for (size_t i = 0; i < numSteps && bulkMatches; ++i) {
+        Eigen::Map<const Eigen::VectorXd> state(&states[i * timeline.getStateSize()], timeline.getStateSize());
+        bulkMatches = (times[i] == timeline.at(i).getTime() && state == timeline.at(i).getState());
+    }
+
+    std::cout << std::setw(10) << name
+              << std::setw(12) << (double)timeline.getMemoryUsage() / numSteps
+              << std::setw(10) << (double)timeline.getRawMemoryUsage() / timeline.getMemoryUsage()
+              << std::setw(14) << numSteps / pushTime
+              << std::setw(14) << numSteps / sequentialTime
+              << std::setw(14) << numRandom / randomTime
+              << std::setw(14) << numSteps / bulkTime
+              << std::setw(12) << maxError << std::endl;
+    sink = checksum;
+
+    if (maxError > maxAllowedError) {
+        std::cerr << "[timeline-benchmark] " << name << " error " << maxError
+                  << " exceeds " << maxAllowedError << std::endl;
+        return 1;
+    }
+    if (!bulkMatches) {
+        std::cerr << "[timeline-benchmark] " << name << " bulk copy doesn't match the slices" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    size_t numSteps = (argc > 1 ? atoi(argv[1]) : 20000);
+    size_t numDofs = (argc > 2 ? atoi(argv[2]) : 63);
+    double resolution = 1e-6;
+
+    std::cout << numSteps << " steps, state size " << 2 * numDofs << "\n"
+              << std::setw(10) << "mode"
+              << std::setw(12) << "bytes/step"
+              << std::setw(10) << "ratio"
+              << std::setw(14) << "push/s"
+              << std::setw(14) << "seq read/s"
+              << std::setw(14) << "rand read/s"
+              << std::setw(14) << "bulk read/s"
+              << std::setw(12) << "max error" << std::endl;
+
+    int failed = 0;
+
+    GripTimeline raw;
+    failed += benchmark("raw", raw, numSteps, numDofs, 0);
+
+    GripTimeline lossless;
+    lossless.setCompression(TIMELINE_LOSSLESS);
+    failed += benchmark("lossless", lossless, numSteps, numDofs, 0);
+
+    GripTimeline quantized;
+    quantized.setCompression(TIMELINE_QUANTIZED, 64, resolution);
+    failed += benchmark("quantized", quantized, numSteps, numDofs, resolution / 2 + 1e-12);
+
+    // Truncating in the middle of a block has to leave the encoder consistent
+    quantized.truncate(numSteps / 2 + 7);
+    for (size_t i = numSteps / 2 + 7; i < numSteps; ++i) {
+        quantized.push_back(i * 0.001, makeState(i, numDofs));
+    }
+    double error = (quantized.at(numSteps - 1).getState() - makeState(numSteps - 1, numDofs)).cwiseAbs().maxCoeff();
+    if (error > resolution / 2 + 1e-12) {
+        std::cerr << "[timeline-benchmark] Wrong state after truncating, error " << error << std::endl;
+        ++failed;
+    }
+
+    // Views of a compressed timeline decode into themselves, so they don't overwrite each other
+    GripTimesliceView first = lossless.at(0);
+    GripTimesliceView last = lossless.at(numSteps - 1);
+    if (first.getState() != makeState(0, numDofs) || last.getState() != makeState(numSteps - 1, numDofs)) {
+        std::cerr << "[timeline-benchmark] Two views of the compressed timeline overwrote each other" << std::endl;
+        ++failed;
+    }
+
+    // NaN and values too large to quantize are clamped rather than converted to garbage
+    Eigen::VectorXd bad = makeState(numSteps, numDofs);
+    bad[0] = std::numeric_limits<double>::quiet_NaN();
+    bad[1] = std::numeric_limits<double>::infinity();
+    quantized.push_back(numSteps * 0.001, bad);
+    Eigen::VectorXd decoded;
+    quantized.at(numSteps, decoded);
+    if (decoded[0] != 0 || !(decoded[1] > 1e12)) {
+        std::cerr << "[timeline-benchmark] Non-finite values weren't clamped: "
+                  << decoded[0] << ", " << decoded[1] << std::endl;
+        ++failed;
+    }
+
+    return failed;
+}
@@ -0,0 +1,132 @@
+#include <dart/dynamics/Skeleton.h>
+#include <dart/simulation/World.h>
+#include <dart/utils/urdf/DartLoader.h>
+#include <osgViewer/Viewer>
+#include <osgGA/TrackballManipulator>
+#include "DartNode.h"
+#include "ViewerWidget.h"
+#include "gripTime.h"
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+
+/**
+ * Renders a scene with many copies of the drchubo_v2 model with each of the
+ * OpenSceneGraph threading models and prints the frame rate. Every frame moves
+ * all the joints before rendering, like a frame during simulation, so with
+ * DrawThreadPerContext and CullThreadPerCameraDrawThreadPerContext the joint
+ * updates overlap drawing the previous frame. Needs a display, and vsync is
+ * turned off so the frame rate isn't capped at the refresh rate.
+ *
+ * Usage: viewer-threading-benchmark [urdfFile] [numSkeletons] [numFrames]
+ */
+
+void moveJoints(dart::simulation::World* world, size_t frame)
+{
+    for (int s=0; s<world->getNumSkeletons(); ++s) {
+        dart::dynamics::Skeleton* robot = world->getSkeleton(s);
+        Eigen::VectorXd q(robot->getNumGenCoords());
+        for (int i=0; i<q.size(); ++i) {
+            q[i] = 0.2 * std::sin(0.01 * frame + i + s);
+        }
+        robot->setConfig(q);
+    }
+}
+
+osgViewer::Viewer* createViewer(osg::Node* scene, osgViewer::ViewerBase::ThreadingModel threadingModel)
+{
+    osg::ref_ptr<osg::GraphicsContext::Traits> traits = new osg::GraphicsContext::Traits;
+    traits->x = 50;
+    traits->y = 50;
+    traits->width = 800;
+    traits->height = 600;
+    traits->windowDecoration = true;
+    traits->doubleBuffer = true;
+    traits->vsync = false;
+
+    osg::ref_ptr<osg::GraphicsContext> gc = osg::GraphicsContext::createGraphicsContext(traits.get());
+    if (!gc.valid()) {
+        return NULL;
+    }
+
+    osgViewer::Viewer* viewer = new osgViewer::Viewer;
+    osg::Camera* camera = viewer->getCamera();
+    camera->setGraphicsContext(gc.get());
+    camera->setViewport(new osg::Viewport(0, 0, traits->width, traits->height));
+    camera->setProjectionMatrixAsPerspective(30.0, (double)traits->width / traits->height, 1.0, 1000.0);
+    camera->setClearColor(osg::Vec4(.5, .5, .5, 1));
+
+    viewer->setThreadingModel(threadingModel);
+    viewer->setSceneData(scene);
+    viewer->setCameraManipulator(new osgGA::TrackballManipulator);
+    viewer->realize();
+    return viewer;
+}
+
+int main(int argc, char** argv)
+{
+    std::string urdfFile = (argc > 1 ? argv[1] : "../models/drchubo_v2/robots/drchubo_v2.urdf");
+    size_t numSkeletons = (argc > 2 ? atoi(argv[2]) : 24);
+    size_t numFrames = (argc > 3 ? atoi(argv[3]) : 500);
+
+    // Each copy is its own skeleton, so it gets its own SkeletonNode and transforms
+    dart::utils::DartLoader loader;
+    dart::simulation::World* world = new dart::simulation::World;
+    for (size_t i=0; i<numSkeletons; ++i) {
+        dart::dynamics::Skeleton* robot = loader.parseSkeleton(urdfFile);
+        if (!robot) {
+            std::cerr << "[viewer-threading-benchmark] Error parsing " << urdfFile << std::endl;
+            return 1;
+        }
+        world->addSkeleton(robot);
+    }
+
+    osg::ref_ptr<osgDart::DartNode> dartNode = new osgDart::DartNode;
+    dartNode->addWorld(world);
+
+    std::cout << numSkeletons << " skeletons, " << numFrames << " frames" << std::endl;
+
+    const osgViewer::ViewerBase::ThreadingModel models[] = {
+        osgViewer::ViewerBase::SingleThreaded,
+        osgViewer::ViewerBase::CullDrawThreadPerContext,
+        osgViewer::ViewerBase::DrawThreadPerContext,
+        osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext
+    };
+
+    std::cout << std::setw(42) << "threading model"
+              << std::setw(12) << "fps"
+              << std::setw(14) << "ms/frame" << "\n";
+
+    for (size_t m=0; m<sizeof(models)/sizeof(models[0]); ++m) {
+        osg::ref_ptr<osgViewer::Viewer> viewer = createViewer(dartNode.get(), models[m]);
+        if (!viewer.valid() || !viewer->isRealized()) {
+            // Not a failure, there's just nothing to render to without a display
+            std::cerr << "[viewer-threading-benchmark] Couldn't open a window, skipping" << std::endl;
+            return 0;
+        }
+
+        // Let the first frames compile display lists and textures
+        for (size_t frame=0; frame<10; ++frame) {
+            moveJoints(world, frame);
+            viewer->frame();
+        }
+
+        double start = grip::getTime();
+        for (size_t frame=0; frame<numFrames; ++frame) {
+            moveJoints(world, frame);
+            viewer->frame();
+        }
+        double elapsed = grip::getTime() - start;
+
+        std::cout << std::setw(42) << ViewerWidget::getThreadingModelName(models[m])
+                  << std::setw(12) << numFrames / elapsed
+                  << std::setw(14) << 1e3 * elapsed / numFrames << std::endl;
+
+        // Joins the graphics threads before the window goes away
+        viewer->setDone(true);
+        viewer->stopThreading();
+    }
+
+    return 0;
+}